@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "BuoyancyCoreTypes.h"
+#include "WaterSurface.h"
+#include <cmath>
+#include <vector>
+
+//Synthetic hulls for the headless benchmark, sizes are in unreal units (cm)
+namespace BuoyancyBench
+{
+	using BuoyancyCore::FVec3;
+
+	struct FSyntheticHull
+	{
+		std::vector<FVec3> Vertices;
+		std::vector<int32_t> Triangles;
+
+		int32_t NumTriangles() const { return (int32_t)(Triangles.size() / 3); }
+	};
+
+	/**
+	 * Closed ellipsoid (a stretched uv sphere) roughly the shape of a boat hull with about TargetTriangles triangles.
+	 * Triangles are wound the same way as the PhysX cooked meshes we get in the engine.
+	 */
+	inline FSyntheticHull MakeEllipsoidHull(int32_t TargetTriangles, FVec3 Radius = FVec3(400.0f, 150.0f, 100.0f))
+	{
+		//a uv sphere with 2 * Rings segments has 4 * Rings * (Rings - 1) triangles
+		int32_t Rings = (int32_t)std::ceil((1.0f + std::sqrt(1.0f + (float)TargetTriangles)) / 2.0f);
+		if (Rings < 3)
+		{
+			Rings = 3;
+		}
+		const int32_t Segments = Rings * 2;
+		const float Pi = 3.14159265f;
+
+		FSyntheticHull Hull;
+		Hull.Vertices.reserve(2 + (Rings - 1) * Segments);
+		Hull.Triangles.reserve(Segments * (Rings - 1) * 6);
+
+		//Poles first, then one loop of vertices per inner ring
+		Hull.Vertices.push_back(FVec3(0.0f, 0.0f, Radius.Z));
+		Hull.Vertices.push_back(FVec3(0.0f, 0.0f, -Radius.Z));
+		for (int32_t Ring = 1; Ring < Rings; Ring++)
+		{
+			const float Theta = Pi * (float)Ring / (float)Rings;
+			for (int32_t Segment = 0; Segment < Segments; Segment++)
+			{
+				const float Phi = 2.0f * Pi * (float)Segment / (float)Segments;
+				Hull.Vertices.push_back(FVec3(
+					Radius.X * std::sin(Theta) * std::cos(Phi),
+					Radius.Y * std::sin(Theta) * std::sin(Phi),
+					Radius.Z * std::cos(Theta)));
+			}
+		}
+
+		auto RingVertex = [Segments](int32_t Ring, int32_t Segment)
+		{
+			return 2 + (Ring - 1) * Segments + (Segment % Segments);
+		};
+
+		for (int32_t Segment = 0; Segment < Segments; Segment++)
+		{
+			//Top cap
+			Hull.Triangles.push_back(0);
+			Hull.Triangles.push_back(RingVertex(1, Segment + 1));
+			Hull.Triangles.push_back(RingVertex(1, Segment));
+
+			//Bottom cap
+			Hull.Triangles.push_back(1);
+			Hull.Triangles.push_back(RingVertex(Rings - 1, Segment));
+			Hull.Triangles.push_back(RingVertex(Rings - 1, Segment + 1));
+		}
+
+		for (int32_t Ring = 1; Ring < Rings - 1; Ring++)
+		{
+			for (int32_t Segment = 0; Segment < Segments; Segment++)
+			{
+				const int32_t A = RingVertex(Ring, Segment);
+				const int32_t B = RingVertex(Ring, Segment + 1);
+				const int32_t C = RingVertex(Ring + 1, Segment);
+				const int32_t D = RingVertex(Ring + 1, Segment + 1);
+
+				Hull.Triangles.push_back(A);
+				Hull.Triangles.push_back(B);
+				Hull.Triangles.push_back(C);
+
+				Hull.Triangles.push_back(B);
+				Hull.Triangles.push_back(D);
+				Hull.Triangles.push_back(C);
+			}
+		}
+
+		return Hull;
+	}
+
+	//A bobbing and rolling pose so the waterline moves over the hull from frame to frame
+	inline BuoyancyCore::FHullTransform MakeBobbingTransform(int32_t Frame)
+	{
+		const float Time = (float)Frame / 60.0f;
+		const float Roll = 0.15f * std::sin(Time * 1.3f);
+		const float Pitch = 0.08f * std::sin(Time * 0.7f + 1.0f);
+		const float Heave = 30.0f * std::sin(Time * 2.1f);
+
+		const float CR = std::cos(Roll), SR = std::sin(Roll);
+		const float CP = std::cos(Pitch), SP = std::sin(Pitch);
+
+		//Rotation = Pitch (about Y) * Roll (about X)
+		BuoyancyCore::FHullTransform Transform;
+		Transform.M[0][0] = CP;  Transform.M[0][1] = SP * SR;  Transform.M[0][2] = SP * CR;  Transform.M[0][3] = 1000.0f;
+		Transform.M[1][0] = 0.0f; Transform.M[1][1] = CR;      Transform.M[1][2] = -SR;     Transform.M[1][3] = -250.0f;
+		Transform.M[2][0] = -SP; Transform.M[2][1] = CP * SR;  Transform.M[2][2] = CP * CR;  Transform.M[2][3] = Heave;
+		return Transform;
+	}
+
+	//A boat tied up in a harbor: the same motion as MakeBobbingTransform but a few percent of it, so most frames barely move
+	inline BuoyancyCore::FHullTransform MakeMooredTransform(int32_t Frame)
+	{
+		const float Time = (float)Frame / 60.0f;
+		const float Roll = 0.004f * std::sin(Time * 1.3f);
+		const float Heave = 1.5f * std::sin(Time * 0.9f);
+
+		const float CR = std::cos(Roll), SR = std::sin(Roll);
+
+		BuoyancyCore::FHullTransform Transform;
+		Transform.M[1][1] = CR;  Transform.M[1][2] = -SR;
+		Transform.M[2][1] = SR;  Transform.M[2][2] = CR;
+		Transform.M[0][3] = 1000.0f;
+		Transform.M[1][3] = -250.0f;
+		Transform.M[2][3] = Heave;
+		return Transform;
+	}
+
+	//A four wave sea state with wavelengths around the hull length, so the waterline is nowhere near flat
+	inline void MakeBenchSea(BuoyancyCore::FGerstnerWaterSurface& Surface)
+	{
+		BuoyancyCore::FGerstnerWave Waves[4];
+		Waves[0].DirectionX = 1.0f;  Waves[0].DirectionY = 0.2f;  Waves[0].Wavelength = 1800.0f; Waves[0].Amplitude = 40.0f; Waves[0].Steepness = 0.6f;
+		Waves[1].DirectionX = 0.7f;  Waves[1].DirectionY = 0.7f;  Waves[1].Wavelength = 900.0f;  Waves[1].Amplitude = 18.0f; Waves[1].Steepness = 0.5f; Waves[1].Phase = 1.3f;
+		Waves[2].DirectionX = -0.3f; Waves[2].DirectionY = 1.0f;  Waves[2].Wavelength = 450.0f;  Waves[2].Amplitude = 7.0f;  Waves[2].Steepness = 0.4f; Waves[2].Phase = 2.1f;
+		Waves[3].DirectionX = 1.0f;  Waves[3].DirectionY = -0.6f; Waves[3].Wavelength = 230.0f;  Waves[3].Amplitude = 3.0f;  Waves[3].Steepness = 0.3f; Waves[3].Phase = 0.4f;
+		Surface.SetWaves(Waves, 4);
+	}
+}
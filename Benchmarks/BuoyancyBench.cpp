@@ -0,0 +1,1144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ * Headless benchmark for the BuoyancyCore hull clipping, runs the same code the component ticks
+ * on synthetic hulls from 1k to 1M triangles and prints per frame numbers.
+ *
+ * Usage: BuoyancyBench [--frames N] [--min-triangles N] [--max-triangles N] [--filter Name] [--json File]
+ *     [--baseline File] [--tolerance Percent]
+ *
+ * With --baseline the run also fails when a pipeline's median frame is more than --tolerance percent (default 10) slower than
+ * in a file written by --json before, at the same hull size. Checksums that differ from the baseline only warn.
+ */
+
+#include "BenchHulls.h"
+#include "CookedHull.h"
+#include "HullClipper.h"
+#include "HullOptimizer.h"
+#include "HullPontoons.h"
+#include "HullSimplifier.h"
+#include "VertexStream.h"
+#include "WaterSurface.h"
+#include "WaterHeightfieldCache.h"
+#include "WaterVolumes.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+//Count every heap allocation so we can report allocations per frame
+static std::atomic<int64_t> GAllocationCount(0);
+
+void* operator new(std::size_t Size)
+{
+	GAllocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* Ptr = std::malloc(Size ? Size : 1))
+	{
+		return Ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t Size)
+{
+	return operator new(Size);
+}
+
+//GCC sees the malloc and free of the pair above once they are inlined into a new and delete and takes them for a mismatch,
+//they are the replacements of each other so there is none
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* Ptr) noexcept
+{
+	std::free(Ptr);
+}
+
+void operator delete[](void* Ptr) noexcept
+{
+	std::free(Ptr);
+}
+
+void operator delete(void* Ptr, std::size_t) noexcept
+{
+	std::free(Ptr);
+}
+
+void operator delete[](void* Ptr, std::size_t) noexcept
+{
+	std::free(Ptr);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+namespace BuoyancyBench
+{
+	//One way of running the buoyancy pipeline, every pipeline is timed on every hull size
+	class FBenchPipeline
+	{
+	public:
+		virtual ~FBenchPipeline() {}
+		virtual const char* GetName() const = 0;
+		virtual void Setup(const FSyntheticHull& Hull) = 0;
+		virtual void RunFrame(int32_t Frame) = 0;
+		//Number of triangles produced by the last frame
+		virtual int64_t GetEmittedTriangles() const = 0;
+		//Something derived from the output so results can be compared between commits
+		virtual double GetChecksum() const = 0;
+		//Frames after the warm up must not allocate, the run fails when they do
+		virtual bool IsSteadyState() const { return true; }
+	};
+
+	//The default path, what UUnderWaterMeshGenerator::GenerateUnderWaterMesh runs every tick
+	class FClipPipeline : public FBenchPipeline
+	{
+	public:
+		const char* GetName() const override { return "Clip"; }
+
+		void Setup(const FSyntheticHull& Hull) override
+		{
+			Clipper.SetHull(Hull.Vertices.data(), (int32_t)Hull.Vertices.size(), Hull.Triangles.data(), (int32_t)Hull.Triangles.size());
+		}
+
+		void RunFrame(int32_t Frame) override
+		{
+			Clipper.GenerateUnderWaterMesh(MakeBobbingTransform(Frame));
+		}
+
+		int64_t GetEmittedTriangles() const override { return Clipper.GetNumUnderWaterTriangles(); }
+
+		double GetChecksum() const override
+		{
+			double Sum = 0.0;
+			for (int32_t i = 0; i < Clipper.GetNumUnderWaterTriangles(); i++)
+			{
+				const BuoyancyCore::FUnderWaterTriangle& Triangle = Clipper.GetUnderWaterTriangles()[i];
+				Sum += Triangle.Area * Triangle.Normal.Z;
+			}
+			return Sum;
+		}
+
+	private:
+		BuoyancyCore::FHullClipper Clipper;
+	};
+
+	//Which water the force pipelines float the hull on
+	enum class EBenchWater
+	{
+		Flat,
+		Waves,
+		//The waves through a heightfield cache, rebuilt every frame since the time changes
+		CachedWaves
+	};
+
+	//Clip plus the net force and torque summed in the same pass, the aggregated force mode of the component
+	class FClipForcesPipeline : public FBenchPipeline
+	{
+	public:
+		//With SubstepsPerFrame > 1 only every n-th frame reclassifies, like the component's substeps reusing the waterline.
+		//bInLocalSpace clips in the hull's space against the water plane instead, bInHydrodynamics adds drag and slamming
+		explicit FClipForcesPipeline(int32_t InSubstepsPerFrame = 1, EBenchWater InWater = EBenchWater::Flat, bool bInLocalSpace = false, BuoyancyCore::EBuoyancyModel InModel = BuoyancyCore::EBuoyancyModel::Pressure, bool bInHydrodynamics = false)
+			: SubstepsPerFrame(InSubstepsPerFrame), Water(InWater), bLocalSpace(bInLocalSpace), Model(InModel), bHydrodynamics(bInHydrodynamics) {}
+
+		const char* GetName() const override
+		{
+			if (bHydrodynamics)
+			{
+				return bLocalSpace ? "ClipForcesDragLocal" : "ClipForcesDrag";
+			}
+			if (Model == BuoyancyCore::EBuoyancyModel::DisplacedVolume)
+			{
+				return "ClipForcesVolume";
+			}
+			if (bLocalSpace)
+			{
+				return Water == EBenchWater::Flat ? "ClipForcesLocal" : "ClipForcesLocalWaves";
+			}
+			switch (Water)
+			{
+			case EBenchWater::Waves: return "ClipForcesWaves";
+			case EBenchWater::CachedWaves: return "ClipForcesCached";
+			default: return SubstepsPerFrame > 1 ? "ClipForcesReuse" : "ClipForces";
+			}
+		}
+
+		void Setup(const FSyntheticHull& Hull) override
+		{
+			Clipper.SetHull(Hull.Vertices.data(), (int32_t)Hull.Vertices.size(), Hull.Triangles.data(), (int32_t)Hull.Triangles.size());
+			MakeBenchSea(Sea);
+			Cache.SetSource(&Sea, BuoyancyCore::FWaterHeightfieldCache::FSettings());
+		}
+
+		void RunFrame(int32_t Frame) override
+		{
+			const BuoyancyCore::FHullTransform Transform = MakeBobbingTransform(Frame);
+			const BuoyancyCore::IWaterSurface* Surface = nullptr;
+			if (Water == EBenchWater::Waves)
+			{
+				Surface = &Sea;
+			}
+			else if (Water == EBenchWater::CachedWaves)
+			{
+				Surface = &Cache;
+			}
+			Clipper.SetWaterSurface(Surface, (float)Frame / 60.0f);
+
+			BuoyancyCore::FBuoyancyParams Params;
+			Params.Model = Model;
+			Params.CenterOfMass = Transform.GetOrigin();
+			if (bHydrodynamics)
+			{
+				//Moving ahead and pitching, fast enough for every force to matter
+				Params.Hydrodynamics.bEnabled = true;
+				Params.Hydrodynamics.LinearVelocity = BuoyancyCore::FVec3(500.0f, 0.0f, -50.0f);
+				Params.Hydrodynamics.AngularVelocity = BuoyancyCore::FVec3(0.0f, 0.2f, 0.0f);
+				Params.Hydrodynamics.ResistanceCoefficient = BuoyancyCore::ViscousResistanceCoefficient(500.0f, 1000.0f, 0.01f);
+				Params.Hydrodynamics.DeltaTime = 1.0f / 60.0f;
+				Params.Hydrodynamics.Mass = 1000.0f;
+			}
+			if (bLocalSpace)
+			{
+				Clipper.GenerateUnderWaterMeshLocal(Transform, Params, Wrench);
+			}
+			else if (Frame % SubstepsPerFrame == 0)
+			{
+				Clipper.GenerateUnderWaterMesh(Transform, Params, Wrench);
+			}
+			else
+			{
+				Clipper.UpdateUnderWaterMesh(Transform, Params, Wrench);
+			}
+		}
+
+		int64_t GetEmittedTriangles() const override { return Clipper.GetNumUnderWaterTriangles(); }
+
+		double GetChecksum() const override
+		{
+			//Only drag has a horizontal force
+			return Wrench.Force.X + Wrench.Force.Z + Wrench.Torque.X + Wrench.Torque.Y;
+		}
+
+	private:
+		int32_t SubstepsPerFrame;
+		EBenchWater Water;
+		bool bLocalSpace;
+		BuoyancyCore::EBuoyancyModel Model;
+		bool bHydrodynamics;
+		BuoyancyCore::FGerstnerWaterSurface Sea;
+		BuoyancyCore::FWaterHeightfieldCache Cache;
+		BuoyancyCore::FHullClipper Clipper;
+		BuoyancyCore::FBuoyancyWrench Wrench;
+	};
+
+	//The analytic mode of distant bodies, the same bobbing hull as ClipForces without clipping it
+	class FAnalyticForcesPipeline : public FBenchPipeline
+	{
+	public:
+		const char* GetName() const override { return "AnalyticForces"; }
+
+		void Setup(const FSyntheticHull& Hull) override
+		{
+			Clipper.SetHull(Hull.Vertices.data(), (int32_t)Hull.Vertices.size(), Hull.Triangles.data(), (int32_t)Hull.Triangles.size());
+		}
+
+		void RunFrame(int32_t Frame) override
+		{
+			const BuoyancyCore::FHullTransform Transform = MakeBobbingTransform(Frame);
+			BuoyancyCore::FBuoyancyParams Params;
+			Params.CenterOfMass = Transform.GetOrigin();
+			Clipper.GenerateAnalyticForces(Transform, Params, Wrench);
+		}
+
+		int64_t GetEmittedTriangles() const override { return 0; }
+
+		double GetChecksum() const override { return Wrench.Force.Z + Wrench.Torque.X + Wrench.Torque.Y; }
+
+	private:
+		BuoyancyCore::FHullClipper Clipper;
+		BuoyancyCore::FBuoyancyWrench Wrench;
+	};
+
+	//The voxel pontoons of the hull on the same bobbing pose and waves as ClipForcesWaves, no clipping
+	class FPontoonsPipeline : public FBenchPipeline
+	{
+	public:
+		const char* GetName() const override { return "Pontoons"; }
+
+		void Setup(const FSyntheticHull& Hull) override
+		{
+			const std::shared_ptr<const BuoyancyCore::FHullTopology> Topology = BuoyancyCore::FHullTopology::Make(Hull.Vertices.data(), (int32_t)Hull.Vertices.size(), Hull.Triangles.data(), (int32_t)Hull.Triangles.size());
+			const std::shared_ptr<const BuoyancyCore::FHullPontoons> Pontoons = BuoyancyCore::FHullPontoons::Build(*Topology, BuoyancyCore::FPontoonSettings());
+			BuoyancyCore::FPontoonErrorReport Report;
+			BuoyancyCore::ComparePontoons(Topology, Pontoons, Report);
+			std::printf("  %d pontoons of %d triangles: force error %.4f max %.4f, torque error %.4f max %.4f over %d poses\n",
+				Pontoons->GetNum(), Hull.NumTriangles(), Report.MeanForceError, Report.MaxForceError, Report.MeanTorqueError, Report.MaxTorqueError, Report.NumPoses);
+
+			MakeBenchSea(Sea);
+			Solver.SetPontoons(Pontoons);
+		}
+
+		void RunFrame(int32_t Frame) override
+		{
+			const BuoyancyCore::FHullTransform Transform = MakeBobbingTransform(Frame);
+			BuoyancyCore::FBuoyancyParams Params;
+			Params.CenterOfMass = Transform.GetOrigin();
+			Solver.SetWaterSurface(&Sea, (float)Frame / 60.0f);
+			Solver.ComputeForces(Transform, Params, Wrench);
+		}
+
+		int64_t GetEmittedTriangles() const override { return 0; }
+
+		//Comparable with ClipForcesWaves in DisplacedVolume terms
+		double GetChecksum() const override { return Wrench.Force.Z + Wrench.Torque.X + Wrench.Torque.Y; }
+
+	private:
+		BuoyancyCore::FGerstnerWaterSurface Sea;
+		BuoyancyCore::FPontoonSolver Solver;
+		BuoyancyCore::FBuoyancyWrench Wrench;
+	};
+
+	//ClipForces for a moored hull, every frame clipped in full or through the coherent path
+	class FClipForcesMooredPipeline : public FBenchPipeline
+	{
+	public:
+		explicit FClipForcesMooredPipeline(bool bInCoherent) : bCoherent(bInCoherent) {}
+
+		const char* GetName() const override { return bCoherent ? "ClipForcesCoherent" : "ClipForcesMoored"; }
+
+		void Setup(const FSyntheticHull& Hull) override
+		{
+			Clipper.SetHull(Hull.Vertices.data(), (int32_t)Hull.Vertices.size(), Hull.Triangles.data(), (int32_t)Hull.Triangles.size());
+		}
+
+		void RunFrame(int32_t Frame) override
+		{
+			const BuoyancyCore::FHullTransform Transform = MakeMooredTransform(Frame);
+			BuoyancyCore::FBuoyancyParams Params;
+			Params.CenterOfMass = Transform.GetOrigin();
+			if (bCoherent)
+			{
+				Clipper.GenerateUnderWaterMeshCoherent(Transform, Params, BuoyancyCore::FClipCoherenceSettings(), Wrench);
+			}
+			else
+			{
+				Clipper.GenerateUnderWaterMesh(Transform, Params, Wrench);
+			}
+		}
+
+		int64_t GetEmittedTriangles() const override { return Clipper.GetNumUnderWaterTriangles(); }
+
+		double GetChecksum() const override
+		{
+			return Wrench.Force.Z + Wrench.Torque.X + Wrench.Torque.Y;
+		}
+
+	private:
+		bool bCoherent;
+		BuoyancyCore::FHullClipper Clipper;
+		BuoyancyCore::FBuoyancyWrench Wrench;
+	};
+
+	//ClipForces on a simplified proxy of the hull, the near LOD of the component
+	class FClipForcesProxyPipeline : public FBenchPipeline
+	{
+	public:
+		const char* GetName() const override { return "ClipForcesProxy"; }
+
+		void Setup(const FSyntheticHull& Hull) override
+		{
+			BuoyancyCore::FHullMesh Source;
+			Source.Vertices = Hull.Vertices;
+			Source.Indexes = Hull.Triangles;
+
+			BuoyancyCore::FHullSimplifySettings Settings;
+			Settings.TargetTriangles = 1000;
+			BuoyancyCore::FHullSimplifyResult Proxy;
+			SimplifyHull(Source, Settings, Proxy);
+			std::printf("  proxy of %d triangles: %d triangles, volume error %.4f, centroid error %.4f\n",
+				Hull.NumTriangles(), Proxy.Mesh.GetNumTriangles(), Proxy.VolumeError, Proxy.CentroidError);
+
+			Clipper.SetHull(Proxy.Mesh.Vertices.data(), (int32_t)Proxy.Mesh.Vertices.size(), Proxy.Mesh.Indexes.data(), (int32_t)Proxy.Mesh.Indexes.size());
+		}
+
+		void RunFrame(int32_t Frame) override
+		{
+			const BuoyancyCore::FHullTransform Transform = MakeBobbingTransform(Frame);
+			BuoyancyCore::FBuoyancyParams Params;
+			Params.CenterOfMass = Transform.GetOrigin();
+			Clipper.GenerateUnderWaterMesh(Transform, Params, Wrench);
+		}
+
+		int64_t GetEmittedTriangles() const override { return Clipper.GetNumUnderWaterTriangles(); }
+
+		//Comparable with ClipForces, the difference is the error the proxy adds
+		double GetChecksum() const override
+		{
+			return Wrench.Force.Z + Wrench.Torque.X + Wrench.Torque.Y;
+		}
+
+	private:
+		BuoyancyCore::FHullClipper Clipper;
+		BuoyancyCore::FBuoyancyWrench Wrench;
+	};
+
+	//ClipForces on the hull with its vertices and triangles shuffled, like a collision cooker may leave them, as it is or
+	//after the load time OptimizeHull the registry runs on meshes without cooked data
+	class FClipForcesLayoutPipeline : public FBenchPipeline
+	{
+	public:
+		explicit FClipForcesLayoutPipeline(bool bInOptimized) : bOptimized(bInOptimized) {}
+
+		const char* GetName() const override { return bOptimized ? "ClipForcesOptimized" : "ClipForcesShuffled"; }
+
+		void Setup(const FSyntheticHull& Hull) override
+		{
+			//Same shuffle for both so they clip the same triangles
+			std::mt19937 Random(1234);
+			std::vector<int32_t> VertexOrder(Hull.Vertices.size());
+			for (size_t i = 0; i < VertexOrder.size(); i++)
+			{
+				VertexOrder[i] = (int32_t)i;
+			}
+			std::shuffle(VertexOrder.begin(), VertexOrder.end(), Random);
+			std::vector<int32_t> TriangleOrder(Hull.NumTriangles());
+			for (size_t i = 0; i < TriangleOrder.size(); i++)
+			{
+				TriangleOrder[i] = (int32_t)i;
+			}
+			std::shuffle(TriangleOrder.begin(), TriangleOrder.end(), Random);
+
+			BuoyancyCore::FHullMesh Shuffled;
+			Shuffled.Vertices.resize(Hull.Vertices.size());
+			for (size_t i = 0; i < VertexOrder.size(); i++)
+			{
+				Shuffled.Vertices[VertexOrder[i]] = Hull.Vertices[i];
+			}
+			for (const int32_t Triangle : TriangleOrder)
+			{
+				Shuffled.Indexes.push_back(VertexOrder[Hull.Triangles[Triangle * 3 + 0]]);
+				Shuffled.Indexes.push_back(VertexOrder[Hull.Triangles[Triangle * 3 + 1]]);
+				Shuffled.Indexes.push_back(VertexOrder[Hull.Triangles[Triangle * 3 + 2]]);
+			}
+
+			BuoyancyCore::FHullMesh Mesh;
+			if (bOptimized)
+			{
+				BuoyancyCore::FHullOptimizeReport Report;
+				BuoyancyCore::OptimizeHull(Shuffled, BuoyancyCore::FHullOptimizeSettings(), Mesh, Report);
+				std::printf("  optimized %d triangles: %d duplicate and %d unused vertices, %d degenerate triangles, gather misses %lld -> %lld\n",
+					Hull.NumTriangles(), Report.NumDuplicateVertices, Report.NumUnusedVertices, Report.NumDegenerateTriangles,
+					(long long)Report.GatherMissesBefore, (long long)Report.GatherMissesAfter);
+			}
+			else
+			{
+				Mesh = Shuffled;
+			}
+			Clipper.SetHull(Mesh.Vertices.data(), (int32_t)Mesh.Vertices.size(), Mesh.Indexes.data(), (int32_t)Mesh.Indexes.size());
+		}
+
+		void RunFrame(int32_t Frame) override
+		{
+			const BuoyancyCore::FHullTransform Transform = MakeBobbingTransform(Frame);
+			BuoyancyCore::FBuoyancyParams Params;
+			Params.CenterOfMass = Transform.GetOrigin();
+			Clipper.GenerateUnderWaterMesh(Transform, Params, Wrench);
+		}
+
+		int64_t GetEmittedTriangles() const override { return Clipper.GetNumUnderWaterTriangles(); }
+
+		//Comparable with ClipForces, the layout only changes the order of the sums
+		double GetChecksum() const override
+		{
+			return Wrench.Force.Z + Wrench.Torque.X + Wrench.Torque.Y;
+		}
+
+	private:
+		bool bOptimized;
+		BuoyancyCore::FHullClipper Clipper;
+		BuoyancyCore::FBuoyancyWrench Wrench;
+	};
+
+	//Where a spawned hull comes from
+	enum class EBenchHullSource
+	{
+		//The PhysX fallback: per triangle index reads grown one element at a time, then a private copy
+		PhysX,
+		//The cooked data checked and copied in blocks
+		Cooked,
+		//A proxy cooked after the hull, instead of simplifying it at runtime
+		CookedProxy,
+		//Another actor already loaded the mesh, only the scratch buffers are made
+		Shared
+	};
+
+	//What spawning a hull costs
+	class FHullLoadPipeline : public FBenchPipeline
+	{
+	public:
+		explicit FHullLoadPipeline(EBenchHullSource InSource) : HullSource(InSource) {}
+
+		const char* GetName() const override
+		{
+			switch (HullSource)
+			{
+			case EBenchHullSource::Cooked: return "HullLoadCooked";
+			case EBenchHullSource::CookedProxy: return "HullLoadProxy";
+			case EBenchHullSource::Shared: return "HullLoadShared";
+			default: return "HullLoad";
+			}
+		}
+
+		//Every frame loads a new hull
+		bool IsSteadyState() const override { return false; }
+
+		void Setup(const FSyntheticHull& Hull) override
+		{
+			Source.Vertices = Hull.Vertices;
+			Source.Indexes = Hull.Triangles;
+			BuoyancyCore::CookHull(Source, 0.01f, &ProxySettings, 1, Cooked);
+			SharedHull = BuoyancyCore::FHullTopology::Make(Hull.Vertices.data(), (int32_t)Hull.Vertices.size(), Hull.Triangles.data(), (int32_t)Hull.Triangles.size());
+		}
+
+		void RunFrame(int32_t) override
+		{
+			if (HullSource == EBenchHullSource::Shared)
+			{
+				Clipper.SetHull(SharedHull);
+			}
+			else if (HullSource == EBenchHullSource::Cooked)
+			{
+				BuoyancyCore::FCookedHullView View;
+				if (BuoyancyCore::ReadCookedHull(Cooked.data(), Cooked.size(), View))
+				{
+					Clipper.SetHull(BuoyancyCore::FHullTopology::Make(View));
+				}
+			}
+			else if (HullSource == EBenchHullSource::CookedProxy)
+			{
+				BuoyancyCore::FCookedHullView View;
+				BuoyancyCore::FCookedHullView Proxy;
+				if (BuoyancyCore::ReadCookedHull(Cooked.data(), Cooked.size(), View) && View.FindProxy(ProxySettings, Proxy))
+				{
+					Clipper.SetHull(BuoyancyCore::FHullTopology::Make(Proxy));
+				}
+			}
+			else
+			{
+				//Same shape as GetStaticMeshVertexLocationsAndTriangles, the bench keeps its indexes 32 bit
+				std::vector<FVec3> Vertices;
+				std::vector<int32_t> Indexes;
+				const int32_t NumTriangles = Source.GetNumTriangles();
+				for (int32_t Triangle = 0; Triangle < NumTriangles; Triangle++)
+				{
+					const volatile bool b16BitIndices = false;
+					if (b16BitIndices)
+					{
+						continue;
+					}
+					Indexes.push_back(Source.Indexes[Triangle * 3 + 0]);
+					Indexes.push_back(Source.Indexes[Triangle * 3 + 1]);
+					Indexes.push_back(Source.Indexes[Triangle * 3 + 2]);
+				}
+				for (const FVec3& Vertex : Source.Vertices)
+				{
+					Vertices.push_back(Vertex);
+				}
+				//Welded and reordered like the registry does before making the hull
+				BuoyancyCore::FHullMesh Loaded;
+				Loaded.Vertices.swap(Vertices);
+				Loaded.Indexes.swap(Indexes);
+				BuoyancyCore::FHullMesh Hull;
+				BuoyancyCore::FHullOptimizeReport Report;
+				BuoyancyCore::OptimizeHull(Loaded, BuoyancyCore::FHullOptimizeSettings(), Hull, Report);
+				Clipper.SetHull(Hull.Vertices.data(), (int32_t)Hull.Vertices.size(), Hull.Indexes.data(), (int32_t)Hull.Indexes.size());
+			}
+		}
+
+		int64_t GetEmittedTriangles() const override { return Clipper.GetNumTriangles(); }
+
+		double GetChecksum() const override { return (double)Clipper.GetNumVertices(); }
+
+	private:
+		EBenchHullSource HullSource;
+		BuoyancyCore::FHullMesh Source;
+		std::vector<uint8_t> Cooked;
+		//The defaults, like the Near proxy of a buoyancy component
+		BuoyancyCore::FHullSimplifySettings ProxySettings;
+		std::shared_ptr<const BuoyancyCore::FHullTopology> SharedHull;
+		BuoyancyCore::FHullClipper Clipper;
+	};
+
+	//Just the vertex transform and waterline distance pass, vectorized or the scalar reference
+	class FTransformPipeline : public FBenchPipeline
+	{
+	public:
+		explicit FTransformPipeline(bool bInScalar) : bScalar(bInScalar) {}
+
+		const char* GetName() const override { return bScalar ? "TransformRef" : "Transform"; }
+
+		void Setup(const FSyntheticHull& Hull) override
+		{
+			Local.SetNum((int32_t)Hull.Vertices.size());
+			for (int32_t i = 0; i < Local.Num; i++)
+			{
+				Local.Set(i, Hull.Vertices[i]);
+			}
+			World.SetNum(Local.Num);
+			Distances.assign(Local.GetPaddedNum(), 0.0f);
+		}
+
+		void RunFrame(int32_t Frame) override
+		{
+			if (bScalar)
+			{
+				BuoyancyCore::TransformVerticesAndDistancesScalar(MakeBobbingTransform(Frame), Local, 0.0f, World, Distances.data(), 0, Local.GetPaddedNum());
+			}
+			else
+			{
+				BuoyancyCore::TransformVerticesAndDistances(MakeBobbingTransform(Frame), Local, 0.0f, World, Distances.data());
+			}
+		}
+
+		int64_t GetEmittedTriangles() const override { return 0; }
+
+		double GetChecksum() const override
+		{
+			double Sum = 0.0;
+			for (int32_t i = 0; i < Local.Num; i++)
+			{
+				Sum += Distances[i];
+			}
+			return Sum;
+		}
+
+	private:
+		bool bScalar;
+		BuoyancyCore::FVertexStream Local;
+		BuoyancyCore::FVertexStream World;
+		std::vector<float> Distances;
+	};
+
+	//Gerstner heights under every world space vertex, one batched query or std::sin per vertex for reference
+	class FWaveHeightsPipeline : public FBenchPipeline
+	{
+	public:
+		explicit FWaveHeightsPipeline(bool bInScalar) : bScalar(bInScalar) {}
+
+		const char* GetName() const override { return bScalar ? "WaveHeightsRef" : "WaveHeights"; }
+
+		void Setup(const FSyntheticHull& Hull) override
+		{
+			Local.SetNum((int32_t)Hull.Vertices.size());
+			for (int32_t i = 0; i < Local.Num; i++)
+			{
+				Local.Set(i, Hull.Vertices[i]);
+			}
+			World.SetNum(Local.Num);
+			Distances.assign(Local.GetPaddedNum(), 0.0f);
+			Heights.assign(Local.GetPaddedNum(), 0.0f);
+			BuoyancyCore::TransformVerticesAndDistances(MakeBobbingTransform(0), Local, 0.0f, World, Distances.data());
+			MakeBenchSea(Sea);
+		}
+
+		void RunFrame(int32_t Frame) override
+		{
+			const float Time = (float)Frame / 60.0f;
+			if (bScalar)
+			{
+				for (int32_t i = 0; i < World.Num; i++)
+				{
+					Heights[i] = Sea.GetHeightReference(World.X[i], World.Y[i], Time);
+				}
+			}
+			else
+			{
+				Sea.GetHeights(World.X.data(), World.Y.data(), World.GetPaddedNum(), Time, Heights.data());
+			}
+		}
+
+		int64_t GetEmittedTriangles() const override { return 0; }
+
+		double GetChecksum() const override
+		{
+			double Sum = 0.0;
+			for (int32_t i = 0; i < World.Num; i++)
+			{
+				Sum += Heights[i];
+			}
+			return Sum;
+		}
+
+	private:
+		bool bScalar;
+		BuoyancyCore::FGerstnerWaterSurface Sea;
+		BuoyancyCore::FVertexStream Local;
+		BuoyancyCore::FVertexStream World;
+		std::vector<float> Distances;
+		std::vector<float> Heights;
+	};
+
+	//Water heights for a fleet of boats close together, every boat evaluating the waves itself or all sampling one shared cache
+	class FFleetHeightsPipeline : public FBenchPipeline
+	{
+	public:
+		static constexpr int32_t NumBoats = 8;
+
+		//With Substeps > 1 every boat samples that many times per frame, like the fixed timestep substeps do
+		explicit FFleetHeightsPipeline(bool bInCached, int32_t InSubsteps = 1) : bCached(bInCached), Substeps(InSubsteps) {}
+
+		const char* GetName() const override
+		{
+			if (Substeps > 1)
+			{
+				return bCached ? "FleetSubstepsCached" : "FleetSubsteps";
+			}
+			return bCached ? "FleetHeightsCached" : "FleetHeights";
+		}
+
+		void Setup(const FSyntheticHull& Hull) override
+		{
+			Local.SetNum((int32_t)Hull.Vertices.size());
+			for (int32_t i = 0; i < Local.Num; i++)
+			{
+				Local.Set(i, Hull.Vertices[i]);
+			}
+			Distances.assign(Local.GetPaddedNum(), 0.0f);
+			Heights.assign(Local.GetPaddedNum() * NumBoats, 0.0f);
+
+			//Two rows of boats 12m apart
+			for (int32_t Boat = 0; Boat < NumBoats; Boat++)
+			{
+				BuoyancyCore::FHullTransform Transform = MakeBobbingTransform(Boat * 7);
+				Transform.M[0][3] += 1200.0f * (float)(Boat % 4);
+				Transform.M[1][3] += 600.0f * (float)(Boat / 4);
+				Boats[Boat].SetNum(Local.Num);
+				BuoyancyCore::TransformVerticesAndDistances(Transform, Local, 0.0f, Boats[Boat], Distances.data());
+			}
+
+			MakeBenchSea(Sea);
+			Cache.SetSource(&Sea, BuoyancyCore::FWaterHeightfieldCache::FSettings());
+		}
+
+		void RunFrame(int32_t Frame) override
+		{
+			const BuoyancyCore::IWaterSurface& Surface = bCached ? (const BuoyancyCore::IWaterSurface&)Cache : Sea;
+			for (int32_t Substep = 0; Substep < Substeps; Substep++)
+			{
+				const float Time = ((float)Frame + (float)Substep / (float)Substeps) / 60.0f;
+				for (int32_t Boat = 0; Boat < NumBoats; Boat++)
+				{
+					Surface.GetHeights(Boats[Boat].X.data(), Boats[Boat].Y.data(), Local.GetPaddedNum(), Time, Heights.data() + Boat * Local.GetPaddedNum());
+				}
+			}
+		}
+
+		int64_t GetEmittedTriangles() const override { return 0; }
+
+		double GetChecksum() const override
+		{
+			double Sum = 0.0;
+			for (int32_t Boat = 0; Boat < NumBoats; Boat++)
+			{
+				for (int32_t i = 0; i < Local.Num; i++)
+				{
+					Sum += Heights[Boat * Local.GetPaddedNum() + i];
+				}
+			}
+			return Sum;
+		}
+
+	private:
+		bool bCached;
+		int32_t Substeps;
+		BuoyancyCore::FGerstnerWaterSurface Sea;
+		BuoyancyCore::FWaterHeightfieldCache Cache;
+		BuoyancyCore::FVertexStream Local;
+		BuoyancyCore::FVertexStream Boats[NumBoats];
+		std::vector<float> Distances;
+		std::vector<float> Heights;
+	};
+
+	//Which water volume every body of a big fleet floats in, once per body per frame. A sea over half the map and a grid of
+	//lakes, the boats drift across the whole map so some are always out of the water. Doesn't depend on the hull size
+	class FWaterVolumesPipeline : public FBenchPipeline
+	{
+	public:
+		static constexpr int32_t NumBodies = 4096;
+		static constexpr int32_t NumLakesPerSide = 16;
+
+		const char* GetName() const override { return "WaterVolumes"; }
+
+		void Setup(const FSyntheticHull& Hull) override
+		{
+			HalfExtent = FVec3(0.0f, 0.0f, 0.0f);
+			for (const FVec3& Vertex : Hull.Vertices)
+			{
+				HalfExtent = FVec3(std::max(HalfExtent.X, std::fabs(Vertex.X)), std::max(HalfExtent.Y, std::fabs(Vertex.Y)), std::max(HalfExtent.Z, std::fabs(Vertex.Z)));
+			}
+
+			BuoyancyCore::FWaterVolume Sea;
+			Sea.BoundsMin = FVec3(-MapSize, -MapSize, -5000.0f);
+			Sea.BoundsMax = FVec3(MapSize, 0.0f, 100.0f);
+			Volumes.Add(Sea);
+			for (int32_t Y = 0; Y < NumLakesPerSide; Y++)
+			{
+				for (int32_t X = 0; X < NumLakesPerSide; X++)
+				{
+					BuoyancyCore::FWaterVolume Lake;
+					const FVec3 Center(-MapSize + (X + 0.5f) * 2.0f * MapSize / NumLakesPerSide, -MapSize + (Y + 0.5f) * 2.0f * MapSize / NumLakesPerSide, 0.0f);
+					Lake.BoundsMin = Center - FVec3(4000.0f, 3000.0f, 500.0f);
+					Lake.BoundsMax = Center + FVec3(4000.0f, 3000.0f, 100.0f);
+					Lake.Density = 1.0f + 0.01f * (float)(X % 3);
+					Volumes.Add(Lake);
+				}
+			}
+
+			//Spread over the map on a fixed pseudo random pattern
+			Positions.resize(NumBodies);
+			for (int32_t Body = 0; Body < NumBodies; Body++)
+			{
+				Positions[Body] = FVec3(-MapSize + std::fmod((float)Body * 7919.0f, 2.0f * MapSize), -MapSize + std::fmod((float)Body * 104729.0f, 2.0f * MapSize), 0.0f);
+			}
+		}
+
+		void RunFrame(int32_t Frame) override
+		{
+			NumInWater = 0;
+			HandleSum = 0;
+			//Drifting a little every frame, around the map
+			const float Drift = std::fmod((float)Frame * 40.0f, 2.0f * MapSize);
+			for (int32_t Body = 0; Body < NumBodies; Body++)
+			{
+				FVec3 Center = Positions[Body];
+				Center.X += Drift;
+				Center.X -= Center.X > MapSize ? 2.0f * MapSize : 0.0f;
+				const int32_t Handle = Volumes.FindBest(Center - HalfExtent, Center + HalfExtent);
+				NumInWater += Handle >= 0 ? 1 : 0;
+				HandleSum += Handle + 1;
+			}
+		}
+
+		//Bodies that go on to the clip, the rest skip it
+		int64_t GetEmittedTriangles() const override { return NumInWater; }
+
+		double GetChecksum() const override { return (double)HandleSum; }
+
+	private:
+		static constexpr float MapSize = 200000.0f;
+		BuoyancyCore::FWaterVolumeRegistry Volumes;
+		FVec3 HalfExtent;
+		std::vector<FVec3> Positions;
+		int64_t NumInWater = 0;
+		int64_t HandleSum = 0;
+	};
+
+	struct FBenchResult
+	{
+		std::string Pipeline;
+		int32_t Triangles;
+		int32_t Frames;
+		double MedianFrameNs;
+		double NsPerTriangle;
+		double TrianglesPerSecond;
+		double AllocationsPerFrame;
+		int64_t EmittedTriangles;
+		double Checksum;
+		bool bSteadyState;
+	};
+
+	struct FBenchOptions
+	{
+		int32_t Frames = 0;
+		int32_t MinTriangles = 1000;
+		int32_t MaxTriangles = 1000000;
+		std::string Filter;
+		std::string JsonPath;
+		std::string BaselinePath;
+		double TolerancePercent = 10.0;
+	};
+
+	static FBenchResult RunPipeline(FBenchPipeline& Pipeline, const FSyntheticHull& Hull, const FBenchOptions& Options)
+	{
+		Pipeline.Setup(Hull);
+
+		//Scale the frame count so every size takes a similar amount of time
+		int32_t Frames = Options.Frames;
+		if (Frames <= 0)
+		{
+			Frames = std::max(10, std::min(2000, 20000000 / std::max(1, Hull.NumTriangles())));
+		}
+
+		//Warm up so the scratch buffers reach their high water mark before we count allocations
+		for (int32_t Frame = 0; Frame < 8; Frame++)
+		{
+			Pipeline.RunFrame(Frame);
+		}
+
+		std::vector<double> FrameNs;
+		FrameNs.reserve(Frames);
+
+		const int64_t AllocationsBefore = GAllocationCount.load();
+		for (int32_t Frame = 0; Frame < Frames; Frame++)
+		{
+			const auto Start = std::chrono::steady_clock::now();
+			Pipeline.RunFrame(Frame);
+			const auto End = std::chrono::steady_clock::now();
+			FrameNs.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(End - Start).count());
+		}
+		//The FrameNs buffer was reserved up front so it doesn't show up here
+		const int64_t Allocations = GAllocationCount.load() - AllocationsBefore;
+
+		std::sort(FrameNs.begin(), FrameNs.end());
+
+		FBenchResult Result;
+		Result.Pipeline = Pipeline.GetName();
+		Result.Triangles = Hull.NumTriangles();
+		Result.Frames = Frames;
+		Result.MedianFrameNs = FrameNs[FrameNs.size() / 2];
+		Result.NsPerTriangle = Result.MedianFrameNs / (double)Result.Triangles;
+		Result.TrianglesPerSecond = Result.MedianFrameNs > 0.0 ? (double)Result.Triangles * 1.0e9 / Result.MedianFrameNs : 0.0;
+		Result.AllocationsPerFrame = (double)Allocations / (double)Frames;
+		Result.EmittedTriangles = Pipeline.GetEmittedTriangles();
+		Result.Checksum = Pipeline.GetChecksum();
+		Result.bSteadyState = Pipeline.IsSteadyState();
+		return Result;
+	}
+
+	static void WriteJson(const std::string& Path, const std::vector<FBenchResult>& Results)
+	{
+		FILE* File = std::fopen(Path.c_str(), "w");
+		if (!File)
+		{
+			std::fprintf(stderr, "Could not open %s for writing\n", Path.c_str());
+			return;
+		}
+
+		std::fprintf(File, "{\n  \"results\": [\n");
+		for (size_t i = 0; i < Results.size(); i++)
+		{
+			const FBenchResult& R = Results[i];
+			std::fprintf(File,
+				"    {\"pipeline\": \"%s\", \"triangles\": %d, \"frames\": %d, \"median_frame_ns\": %.1f, \"ns_per_triangle\": %.4f, "
+				"\"triangles_per_second\": %.1f, \"allocations_per_frame\": %.3f, \"emitted_triangles\": %lld, \"checksum\": %.6g}%s\n",
+				R.Pipeline.c_str(), R.Triangles, R.Frames, R.MedianFrameNs, R.NsPerTriangle,
+				R.TrianglesPerSecond, R.AllocationsPerFrame, (long long)R.EmittedTriangles, R.Checksum,
+				i + 1 < Results.size() ? "," : "");
+		}
+		std::fprintf(File, "  ]\n}\n");
+		std::fclose(File);
+	}
+
+	//Reads back what WriteJson wrote, one result per line. Only the fields the baseline comparison needs
+	static bool ReadJson(const std::string& Path, std::vector<FBenchResult>& OutResults)
+	{
+		FILE* File = std::fopen(Path.c_str(), "r");
+		if (!File)
+		{
+			std::fprintf(stderr, "Could not open %s for reading\n", Path.c_str());
+			return false;
+		}
+
+		char Line[1024];
+		while (std::fgets(Line, sizeof(Line), File))
+		{
+			char Name[128];
+			FBenchResult Result = {};
+			if (std::sscanf(Line, " {\"pipeline\": \"%127[^\"]\", \"triangles\": %d, \"frames\": %d, \"median_frame_ns\": %lf",
+				Name, &Result.Triangles, &Result.Frames, &Result.MedianFrameNs) != 4)
+			{
+				continue;
+			}
+			if (const char* Checksum = std::strstr(Line, "\"checksum\": "))
+			{
+				Result.Checksum = std::strtod(Checksum + std::strlen("\"checksum\": "), nullptr);
+			}
+			Result.Pipeline = Name;
+			OutResults.push_back(Result);
+		}
+		std::fclose(File);
+		return true;
+	}
+
+	//Number of results more than the tolerance slower than their baseline
+	static int32_t CompareWithBaseline(const std::vector<FBenchResult>& Results, const std::vector<FBenchResult>& Baseline, double TolerancePercent)
+	{
+		int32_t NumRegressed = 0;
+		for (const FBenchResult& Result : Results)
+		{
+			const auto Base = std::find_if(Baseline.begin(), Baseline.end(), [&Result](const FBenchResult& Candidate)
+			{
+				return Candidate.Pipeline == Result.Pipeline && Candidate.Triangles == Result.Triangles;
+			});
+			if (Base == Baseline.end() || Base->MedianFrameNs <= 0.0)
+			{
+				continue;
+			}
+
+			const double ChangePercent = (Result.MedianFrameNs / Base->MedianFrameNs - 1.0) * 100.0;
+			if (ChangePercent > TolerancePercent)
+			{
+				std::fprintf(stderr, "%s at %d triangles regressed by %.1f%%: %.2f us against %.2f us in the baseline\n",
+					Result.Pipeline.c_str(), Result.Triangles, ChangePercent, Result.MedianFrameNs / 1000.0, Base->MedianFrameNs / 1000.0);
+				NumRegressed++;
+			}
+			//Written with 6 digits, anything closer than that is the same
+			if (std::fabs(Result.Checksum - Base->Checksum) > std::fabs(Base->Checksum) * 1.0e-5 + 1.0e-6)
+			{
+				std::fprintf(stderr, "%s at %d triangles has checksum %.6g, %.6g in the baseline\n",
+					Result.Pipeline.c_str(), Result.Triangles, Result.Checksum, Base->Checksum);
+			}
+		}
+		return NumRegressed;
+	}
+
+	static bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+	{
+		for (int i = 1; i < Argc; i++)
+		{
+			const bool bHasValue = i + 1 < Argc;
+			if (!std::strcmp(Argv[i], "--frames") && bHasValue)
+			{
+				Options.Frames = std::atoi(Argv[++i]);
+			}
+			else if (!std::strcmp(Argv[i], "--min-triangles") && bHasValue)
+			{
+				Options.MinTriangles = std::atoi(Argv[++i]);
+			}
+			else if (!std::strcmp(Argv[i], "--max-triangles") && bHasValue)
+			{
+				Options.MaxTriangles = std::atoi(Argv[++i]);
+			}
+			else if (!std::strcmp(Argv[i], "--filter") && bHasValue)
+			{
+				Options.Filter = Argv[++i];
+			}
+			else if (!std::strcmp(Argv[i], "--json") && bHasValue)
+			{
+				Options.JsonPath = Argv[++i];
+			}
+			else if (!std::strcmp(Argv[i], "--baseline") && bHasValue)
+			{
+				Options.BaselinePath = Argv[++i];
+			}
+			else if (!std::strcmp(Argv[i], "--tolerance") && bHasValue)
+			{
+				Options.TolerancePercent = std::atof(Argv[++i]);
+			}
+			else
+			{
+				std::fprintf(stderr, "Usage: %s [--frames N] [--min-triangles N] [--max-triangles N] [--filter Name] [--json File] [--baseline File] [--tolerance Percent]\n", Argv[0]);
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int Argc, char** Argv)
+{
+	using namespace BuoyancyBench;
+
+	FBenchOptions Options;
+	if (!ParseOptions(Argc, Argv, Options))
+	{
+		return 1;
+	}
+
+	//Read before running so a missing file doesn't waste the whole run
+	std::vector<FBenchResult> Baseline;
+	if (!Options.BaselinePath.empty() && !ReadJson(Options.BaselinePath, Baseline))
+	{
+		return 1;
+	}
+
+	std::vector<std::unique_ptr<FBenchPipeline>> Pipelines;
+	Pipelines.emplace_back(new FClipPipeline());
+	Pipelines.emplace_back(new FClipForcesPipeline());
+	Pipelines.emplace_back(new FClipForcesPipeline(4));
+	Pipelines.emplace_back(new FClipForcesPipeline(1, EBenchWater::Waves));
+	Pipelines.emplace_back(new FClipForcesPipeline(1, EBenchWater::CachedWaves));
+	Pipelines.emplace_back(new FClipForcesPipeline(1, EBenchWater::Flat, true));
+	Pipelines.emplace_back(new FClipForcesPipeline(1, EBenchWater::Waves, true));
+	Pipelines.emplace_back(new FClipForcesPipeline(1, EBenchWater::Flat, false, BuoyancyCore::EBuoyancyModel::DisplacedVolume));
+	Pipelines.emplace_back(new FClipForcesPipeline(1, EBenchWater::Flat, false, BuoyancyCore::EBuoyancyModel::Pressure, true));
+	Pipelines.emplace_back(new FClipForcesPipeline(1, EBenchWater::Flat, true, BuoyancyCore::EBuoyancyModel::Pressure, true));
+	Pipelines.emplace_back(new FClipForcesMooredPipeline(false));
+	Pipelines.emplace_back(new FClipForcesMooredPipeline(true));
+	Pipelines.emplace_back(new FClipForcesProxyPipeline());
+	Pipelines.emplace_back(new FClipForcesLayoutPipeline(false));
+	Pipelines.emplace_back(new FClipForcesLayoutPipeline(true));
+	Pipelines.emplace_back(new FAnalyticForcesPipeline());
+	Pipelines.emplace_back(new FPontoonsPipeline());
+	Pipelines.emplace_back(new FHullLoadPipeline(EBenchHullSource::PhysX));
+	Pipelines.emplace_back(new FHullLoadPipeline(EBenchHullSource::Cooked));
+	Pipelines.emplace_back(new FHullLoadPipeline(EBenchHullSource::CookedProxy));
+	Pipelines.emplace_back(new FHullLoadPipeline(EBenchHullSource::Shared));
+	Pipelines.emplace_back(new FTransformPipeline(false));
+	Pipelines.emplace_back(new FTransformPipeline(true));
+	Pipelines.emplace_back(new FWaveHeightsPipeline(false));
+	Pipelines.emplace_back(new FWaveHeightsPipeline(true));
+	Pipelines.emplace_back(new FFleetHeightsPipeline(false));
+	Pipelines.emplace_back(new FFleetHeightsPipeline(true));
+	Pipelines.emplace_back(new FFleetHeightsPipeline(false, 4));
+	Pipelines.emplace_back(new FFleetHeightsPipeline(true, 4));
+	Pipelines.emplace_back(new FWaterVolumesPipeline());
+
+	std::vector<FBenchResult> Results;
+
+	std::printf("SIMD: %s\n", BuoyancyCore::GetSimdName());
+	std::printf("%-16s %10s %8s %14s %10s %14s %12s %10s\n", "Pipeline", "Triangles", "Frames", "Frame (us)", "ns/tri", "tri/s", "allocs/frame", "emitted");
+	for (int32_t Target = 1000; Target <= 1000000; Target *= 10)
+	{
+		if (Target < Options.MinTriangles || Target > Options.MaxTriangles)
+		{
+			continue;
+		}
+
+		const FSyntheticHull Hull = MakeEllipsoidHull(Target);
+		for (const std::unique_ptr<FBenchPipeline>& Pipeline : Pipelines)
+		{
+			if (!Options.Filter.empty() && Options.Filter != Pipeline->GetName())
+			{
+				continue;
+			}
+
+			const FBenchResult Result = RunPipeline(*Pipeline, Hull, Options);
+			std::printf("%-16s %10d %8d %14.2f %10.3f %14.4g %12.2f %10lld\n",
+				Result.Pipeline.c_str(), Result.Triangles, Result.Frames, Result.MedianFrameNs / 1000.0,
+				Result.NsPerTriangle, Result.TrianglesPerSecond, Result.AllocationsPerFrame, (long long)Result.EmittedTriangles);
+			Results.push_back(Result);
+		}
+	}
+
+	if (!Options.JsonPath.empty())
+	{
+		WriteJson(Options.JsonPath, Results);
+	}
+
+	//The buoyancy step is meant to run without touching the heap once its scratch buffers are sized
+	int32_t NumAllocating = 0;
+	for (const FBenchResult& Result : Results)
+	{
+		if (Result.bSteadyState && Result.AllocationsPerFrame > 0.0)
+		{
+			std::fprintf(stderr, "%s allocates %.2f times per frame at %d triangles\n", Result.Pipeline.c_str(), Result.AllocationsPerFrame, Result.Triangles);
+			NumAllocating++;
+		}
+	}
+
+	const int32_t NumRegressed = Options.BaselinePath.empty() ? 0 : CompareWithBaseline(Results, Baseline, Options.TolerancePercent);
+	return NumAllocating > 0 || NumRegressed > 0 ? 1 : 0;
+}
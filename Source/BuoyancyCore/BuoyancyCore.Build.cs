@@ -0,0 +1,15 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+using UnrealBuildTool;
+
+public class BuoyancyCore : ModuleRules
+{
+	public BuoyancyCore(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		// Everything except BuoyancyCoreModule.cpp is plain C++ with no engine includes,
+		// so the same sources are also built headless by Benchmarks/CMakeLists.txt
+		PublicDependencyModuleNames.AddRange(new string[] { "Core" });
+	}
+}
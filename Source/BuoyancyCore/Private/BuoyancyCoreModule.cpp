@@ -0,0 +1,6 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Modules/ModuleManager.h"
+
+//The only engine facing file of the module, keep the rest of BuoyancyCore free of UObject dependencies
+IMPLEMENT_MODULE(FDefaultModuleImpl, BuoyancyCore);
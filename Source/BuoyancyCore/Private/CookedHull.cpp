@@ -0,0 +1,229 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CookedHull.h"
+#include "HullOptimizer.h"
+#include "HullTopology.h"
+#include "BuoyancySimd.h"
+#include <cstring>
+
+namespace BuoyancyCore
+{
+	namespace
+	{
+		constexpr uint32_t CookedHullAlignment = 16;
+
+		inline uint32_t AlignOffset(uint32_t Offset)
+		{
+			return (Offset + CookedHullAlignment - 1) & ~(CookedHullAlignment - 1);
+		}
+
+		//Section at Offset of Bytes bytes lies inside the data and is aligned
+		inline bool IsSectionValid(uint32_t Offset, uint64_t Bytes, uint32_t TotalSize)
+		{
+			return Offset % CookedHullAlignment == 0 && Offset >= sizeof(FCookedHullHeader) && (uint64_t)Offset + Bytes <= TotalSize;
+		}
+
+		inline bool HasProxies(const FCookedHullHeader& Header)
+		{
+			for (uint32_t ProxyOffset : Header.ProxyOffsets)
+			{
+				if (ProxyOffset != 0)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		//Writes Hull, which has to be optimized already, in the cooked format at the end of OutData and returns where its header starts
+		uint32_t AppendCookedHull(const FHullMesh& Hull, const FHullSimplifySettings* ProxySettings, std::vector<uint8_t>& OutData)
+		{
+			//Everything that is cooked comes from the same code that loads the hull from PhysX, so both give the same hull
+			const std::shared_ptr<const FHullTopology> Topology = FHullTopology::Make(Hull.Vertices.data(), (int32_t)Hull.Vertices.size(), Hull.Indexes.data(), (int32_t)Hull.Indexes.size());
+			const int32_t NumVertices = Topology->Vertices.Num;
+			const int32_t PaddedNumVertices = Topology->Vertices.GetPaddedNum();
+			const int32_t NumIndexes = (int32_t)Topology->Triangles.size();
+			const int32_t NumTriangles = NumIndexes / 3;
+			const int32_t NumTreeNodes = (int32_t)Topology->BoundsTree.Nodes.size();
+
+			FCookedHullHeader Header;
+			std::memset(&Header, 0, sizeof(Header));
+			Header.Magic = CookedHullMagic;
+			Header.Version = CookedHullVersion;
+			Header.NumVertices = NumVertices;
+			Header.PaddedNumVertices = PaddedNumVertices;
+			Header.NumIndexes = NumIndexes;
+			Header.NumTreeNodes = NumTreeNodes;
+			Header.Volume = Topology->Volume;
+			Header.CentroidX = Topology->Centroid.X;
+			Header.CentroidY = Topology->Centroid.Y;
+			Header.CentroidZ = Topology->Centroid.Z;
+			Header.BoundingRadius = Topology->BoundingRadius;
+			Header.BoundsMinX = Topology->BoundsMin.X;
+			Header.BoundsMinY = Topology->BoundsMin.Y;
+			Header.BoundsMinZ = Topology->BoundsMin.Z;
+			Header.BoundsMaxX = Topology->BoundsMax.X;
+			Header.BoundsMaxY = Topology->BoundsMax.Y;
+			Header.BoundsMaxZ = Topology->BoundsMax.Z;
+			Header.SurfaceArea = Topology->SurfaceArea;
+			if (ProxySettings)
+			{
+				Header.ProxyTargetTriangles = ProxySettings->TargetTriangles;
+				Header.ProxyMaxVolumeError = ProxySettings->MaxVolumeError;
+				Header.ProxyMaxCentroidError = ProxySettings->MaxCentroidError;
+			}
+
+			uint32_t Offset = AlignOffset(sizeof(FCookedHullHeader));
+			Header.VertexXOffset = Offset;
+			Offset = AlignOffset(Offset + PaddedNumVertices * sizeof(float));
+			Header.VertexYOffset = Offset;
+			Offset = AlignOffset(Offset + PaddedNumVertices * sizeof(float));
+			Header.VertexZOffset = Offset;
+			Offset = AlignOffset(Offset + PaddedNumVertices * sizeof(float));
+			Header.IndexOffset = Offset;
+			Offset = AlignOffset(Offset + NumIndexes * sizeof(int32_t));
+			Header.TriangleAreaOffset = Offset;
+			Offset = AlignOffset(Offset + NumTriangles * sizeof(float));
+			Header.TreeNodeOffset = Offset;
+			Offset = AlignOffset(Offset + NumTreeNodes * sizeof(FHullBoundsNode));
+			Header.TreeTriangleOffset = Offset;
+			Offset = AlignOffset(Offset + Topology->BoundsTree.Triangles.size() * sizeof(int32_t));
+			Header.TotalSize = Offset;
+
+			//Zero filled, which takes care of the gaps between sections. The vertex streams are already zero padded.
+			//Every hull's size is aligned, so the next one starts aligned too
+			const uint32_t Start = (uint32_t)OutData.size();
+			OutData.resize(Start + Header.TotalSize, 0);
+			uint8_t* Data = OutData.data() + Start;
+			std::memcpy(Data, &Header, sizeof(Header));
+			std::memcpy(Data + Header.VertexXOffset, Topology->Vertices.X.data(), PaddedNumVertices * sizeof(float));
+			std::memcpy(Data + Header.VertexYOffset, Topology->Vertices.Y.data(), PaddedNumVertices * sizeof(float));
+			std::memcpy(Data + Header.VertexZOffset, Topology->Vertices.Z.data(), PaddedNumVertices * sizeof(float));
+			std::memcpy(Data + Header.IndexOffset, Topology->Triangles.data(), NumIndexes * sizeof(int32_t));
+			std::memcpy(Data + Header.TriangleAreaOffset, Topology->TriangleAreas.data(), NumTriangles * sizeof(float));
+			std::memcpy(Data + Header.TreeNodeOffset, Topology->BoundsTree.Nodes.data(), NumTreeNodes * sizeof(FHullBoundsNode));
+			std::memcpy(Data + Header.TreeTriangleOffset, Topology->BoundsTree.Triangles.data(), Topology->BoundsTree.Triangles.size() * sizeof(int32_t));
+			return Start;
+		}
+	}
+
+	void FCookedHullView::ToHullMesh(FHullMesh& OutMesh) const
+	{
+		OutMesh.Vertices.resize(GetNumVertices());
+		for (int32_t i = 0; i < GetNumVertices(); i++)
+		{
+			OutMesh.Vertices[i] = GetVertex(i);
+		}
+		OutMesh.Indexes.assign(Indexes, Indexes + GetNumIndexes());
+	}
+
+	bool FCookedHullView::FindProxy(const FHullSimplifySettings& Settings, FCookedHullView& OutProxy) const
+	{
+		for (const FCookedHullHeader* Proxy : Proxies)
+		{
+			if (Proxy && Proxy->ProxyTargetTriangles == Settings.TargetTriangles && Proxy->ProxyMaxVolumeError == Settings.MaxVolumeError
+				&& Proxy->ProxyMaxCentroidError == Settings.MaxCentroidError)
+			{
+				return ReadCookedHull(Proxy, Proxy->TotalSize, OutProxy);
+			}
+		}
+		OutProxy = FCookedHullView();
+		return false;
+	}
+
+	void BuildProxyHull(const FHullMesh& Source, const FHullSimplifySettings& Settings, FHullMesh& OutMesh, FHullSimplifyResult& OutResult)
+	{
+		SimplifyHull(Source, Settings, OutResult);
+		//Collapses leave the triangles and vertices scattered, nothing is left to weld
+		FHullOptimizeReport Report;
+		OptimizeHull(OutResult.Mesh, FHullOptimizeSettings(), OutMesh, Report);
+	}
+
+	void CookHull(const FHullMesh& Source, float WeldDistance, std::vector<uint8_t>& OutData)
+	{
+		CookHull(Source, WeldDistance, nullptr, 0, OutData);
+	}
+
+	void CookHull(const FHullMesh& Source, float WeldDistance, const FHullSimplifySettings* ProxySettings, int32_t NumProxies, std::vector<uint8_t>& OutData)
+	{
+		FHullMesh Hull;
+		FHullOptimizeSettings Settings;
+		Settings.WeldDistance = WeldDistance;
+		FHullOptimizeReport Report;
+		OptimizeHull(Source, Settings, Hull, Report);
+
+		OutData.clear();
+		AppendCookedHull(Hull, nullptr, OutData);
+		for (int32_t i = 0; i < NumProxies && i < MaxCookedProxies; i++)
+		{
+			FHullMesh Proxy;
+			FHullSimplifyResult Result;
+			BuildProxyHull(Hull, ProxySettings[i], Proxy, Result);
+			const uint32_t ProxyOffset = AppendCookedHull(Proxy, &ProxySettings[i], OutData);
+			std::memcpy(OutData.data() + offsetof(FCookedHullHeader, ProxyOffsets) + i * sizeof(uint32_t), &ProxyOffset, sizeof(ProxyOffset));
+		}
+	}
+
+	bool ReadCookedHull(const void* Data, size_t Size, FCookedHullView& OutView)
+	{
+		OutView = FCookedHullView();
+		if (!Data || Size < sizeof(FCookedHullHeader) || ((uintptr_t)Data & 3) != 0)
+		{
+			return false;
+		}
+
+		const FCookedHullHeader* Header = (const FCookedHullHeader*)Data;
+		if (Header->Magic != CookedHullMagic || Header->Version != CookedHullVersion || Header->TotalSize > Size)
+		{
+			return false;
+		}
+		if (Header->NumVertices < 0 || Header->NumIndexes < 0 || Header->NumTreeNodes < 0 || Header->NumIndexes % 3 != 0 || Header->PaddedNumVertices != PadToSimdLanes(Header->NumVertices))
+		{
+			return false;
+		}
+
+		const uint64_t VertexBytes = (uint64_t)Header->PaddedNumVertices * sizeof(float);
+		const uint64_t NumTriangles = (uint64_t)Header->NumIndexes / 3;
+		const uint64_t NumTreeTriangles = Header->NumTreeNodes > 0 ? NumTriangles : 0;
+		if (!IsSectionValid(Header->VertexXOffset, VertexBytes, Header->TotalSize) ||
+			!IsSectionValid(Header->VertexYOffset, VertexBytes, Header->TotalSize) ||
+			!IsSectionValid(Header->VertexZOffset, VertexBytes, Header->TotalSize) ||
+			!IsSectionValid(Header->IndexOffset, (uint64_t)Header->NumIndexes * sizeof(int32_t), Header->TotalSize) ||
+			!IsSectionValid(Header->TriangleAreaOffset, NumTriangles * sizeof(float), Header->TotalSize) ||
+			!IsSectionValid(Header->TreeNodeOffset, (uint64_t)Header->NumTreeNodes * sizeof(FHullBoundsNode), Header->TotalSize) ||
+			!IsSectionValid(Header->TreeTriangleOffset, NumTreeTriangles * sizeof(int32_t), Header->TotalSize))
+		{
+			return false;
+		}
+
+		//Every proxy is a whole cooked hull of its own past this one's sections, and has none of its own
+		const uint8_t* Bytes = (const uint8_t*)Data;
+		const FCookedHullHeader* Proxies[MaxCookedProxies] = {};
+		for (int32_t i = 0; i < MaxCookedProxies; i++)
+		{
+			const uint32_t ProxyOffset = Header->ProxyOffsets[i];
+			if (ProxyOffset == 0)
+			{
+				continue;
+			}
+			FCookedHullView Proxy;
+			if (ProxyOffset % CookedHullAlignment != 0 || ProxyOffset < Header->TotalSize || ProxyOffset >= Size
+				|| !ReadCookedHull(Bytes + ProxyOffset, Size - ProxyOffset, Proxy) || HasProxies(*Proxy.Header))
+			{
+				return false;
+			}
+			Proxies[i] = Proxy.Header;
+		}
+
+		OutView.Header = Header;
+		OutView.X = (const float*)(Bytes + Header->VertexXOffset);
+		OutView.Y = (const float*)(Bytes + Header->VertexYOffset);
+		OutView.Z = (const float*)(Bytes + Header->VertexZOffset);
+		OutView.Indexes = (const int32_t*)(Bytes + Header->IndexOffset);
+		OutView.TriangleAreas = (const float*)(Bytes + Header->TriangleAreaOffset);
+		OutView.TreeNodes = (const FHullBoundsNode*)(Bytes + Header->TreeNodeOffset);
+		OutView.TreeTriangles = (const int32_t*)(Bytes + Header->TreeTriangleOffset);
+		std::memcpy(OutView.Proxies, Proxies, sizeof(Proxies));
+		return true;
+	}
+}
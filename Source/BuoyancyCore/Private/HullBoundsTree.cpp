@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HullBoundsTree.h"
+#include <algorithm>
+#include <cfloat>
+
+namespace BuoyancyCore
+{
+	namespace
+	{
+		inline float GetAxis(const FVec3& V, int32_t Axis)
+		{
+			return Axis == 0 ? V.X : (Axis == 1 ? V.Y : V.Z);
+		}
+
+		//Plain compares rather than std::fmin / std::fmax, which don't get inlined and are most of the build time otherwise
+		inline void AddToBounds(FVec3& Min, FVec3& Max, const FVec3& P)
+		{
+			Min.X = P.X < Min.X ? P.X : Min.X;
+			Min.Y = P.Y < Min.Y ? P.Y : Min.Y;
+			Min.Z = P.Z < Min.Z ? P.Z : Min.Z;
+			Max.X = P.X > Max.X ? P.X : Max.X;
+			Max.Y = P.Y > Max.Y ? P.Y : Max.Y;
+			Max.Z = P.Z > Max.Z ? P.Z : Max.Z;
+		}
+
+		struct FTreeBuilder
+		{
+			FHullBoundsTree& Tree;
+			//Centers in tree order next to their triangle, so the splits only move contiguous memory around
+			std::vector<std::pair<FVec3, int32_t>> Centers;
+			//Per triangle, indexed by triangle
+			std::vector<FVec3> Mins;
+			std::vector<FVec3> Maxs;
+
+			void BuildNode(int32_t Begin, int32_t End)
+			{
+				const int32_t NodeIndex = (int32_t)Tree.Nodes.size();
+				Tree.Nodes.push_back(FHullBoundsNode());
+				Tree.Nodes[NodeIndex].FirstTriangle = Begin;
+				Tree.Nodes[NodeIndex].NumTriangles = End - Begin;
+				Tree.Nodes[NodeIndex].SecondChild = -1;
+
+				FVec3 Min(FLT_MAX, FLT_MAX, FLT_MAX);
+				FVec3 Max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+				if (End - Begin <= FHullBoundsTree::MaxLeafTriangles)
+				{
+					for (int32_t i = Begin; i < End; i++)
+					{
+						const int32_t Triangle = Centers[i].second;
+						Tree.Triangles[i] = Triangle;
+						AddToBounds(Min, Max, Mins[Triangle]);
+						AddToBounds(Min, Max, Maxs[Triangle]);
+					}
+					Tree.Nodes[NodeIndex].Min = Min;
+					Tree.Nodes[NodeIndex].Max = Max;
+					return;
+				}
+
+				//Median split of the centers along the longest side, always halves the triangles so the depth stays logarithmic
+				for (int32_t i = Begin; i < End; i++)
+				{
+					AddToBounds(Min, Max, Centers[i].first);
+				}
+				const FVec3 Extent = Max - Min;
+				const int32_t Axis = Extent.X >= Extent.Y && Extent.X >= Extent.Z ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+				const int32_t Middle = Begin + (End - Begin) / 2;
+				//Ties broken by triangle so the keys are unique, meshes built on a grid have lots of equal centers and
+				//nth_element gets very slow on those
+				std::nth_element(Centers.begin() + Begin, Centers.begin() + Middle, Centers.begin() + End,
+					[Axis](const std::pair<FVec3, int32_t>& A, const std::pair<FVec3, int32_t>& B)
+					{
+						const float KeyA = GetAxis(A.first, Axis);
+						const float KeyB = GetAxis(B.first, Axis);
+						return KeyA < KeyB || (KeyA == KeyB && A.second < B.second);
+					});
+
+				BuildNode(Begin, Middle);
+				const int32_t SecondChild = (int32_t)Tree.Nodes.size();
+				BuildNode(Middle, End);
+
+				//The box is the children's together, nodes may have moved while building them
+				FHullBoundsNode& Node = Tree.Nodes[NodeIndex];
+				const FHullBoundsNode& First = Tree.Nodes[NodeIndex + 1];
+				const FHullBoundsNode& Second = Tree.Nodes[SecondChild];
+				Node.Min = First.Min;
+				Node.Max = First.Max;
+				AddToBounds(Node.Min, Node.Max, Second.Min);
+				AddToBounds(Node.Min, Node.Max, Second.Max);
+				Node.SecondChild = SecondChild;
+			}
+		};
+	}
+
+	void FHullBoundsTree::Build(const FVertexStream& Vertices, const int32_t* TriangleIndexes, int32_t NumIndexes)
+	{
+		Nodes.clear();
+		Triangles.clear();
+		const int32_t NumTriangles = NumIndexes / 3;
+		if (NumTriangles <= MaxLeafTriangles)
+		{
+			return;
+		}
+
+		FTreeBuilder Builder{ *this, std::vector<std::pair<FVec3, int32_t>>(NumTriangles), std::vector<FVec3>(NumTriangles), std::vector<FVec3>(NumTriangles) };
+		Triangles.resize(NumTriangles);
+		for (int32_t Triangle = 0; Triangle < NumTriangles; Triangle++)
+		{
+			const FVec3 P0 = Vertices.Get(TriangleIndexes[Triangle * 3 + 0]);
+			const FVec3 P1 = Vertices.Get(TriangleIndexes[Triangle * 3 + 1]);
+			const FVec3 P2 = Vertices.Get(TriangleIndexes[Triangle * 3 + 2]);
+			Builder.Centers[Triangle] = std::make_pair((P0 + P1 + P2) / 3.0f, Triangle);
+			Builder.Mins[Triangle] = P0;
+			Builder.Maxs[Triangle] = P0;
+			AddToBounds(Builder.Mins[Triangle], Builder.Maxs[Triangle], P1);
+			AddToBounds(Builder.Mins[Triangle], Builder.Maxs[Triangle], P2);
+		}
+
+		//A binary tree with at most MaxLeafTriangles per leaf has fewer than 2 * NumTriangles / (MaxLeafTriangles / 2) nodes
+		Nodes.reserve(4 * NumTriangles / MaxLeafTriangles + 1);
+		Builder.BuildNode(0, NumTriangles);
+		Nodes.shrink_to_fit();
+	}
+}
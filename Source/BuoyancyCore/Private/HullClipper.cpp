@@ -0,0 +1,1060 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HullClipper.h"
+#include <algorithm>
+#include <cfloat>
+
+namespace BuoyancyCore
+{
+	namespace
+	{
+		//Corners of the output triangles index into the 3 vertices followed by the 3 points where the edges cross the water
+		enum EClipPoint : uint8_t
+		{
+			V0, V1, V2,
+			//Edge 0-1, 1-2 and 2-0 at the water
+			E01, E12, E20
+		};
+
+		//What a triangle turns into, up to 2 triangles with corners from EClipPoint
+		struct FClipCase
+		{
+			int32_t NumTriangles;
+			uint8_t Corners[2][3];
+		};
+
+		/**
+		 * Every case a triangle can be in, indexed by AboveMask | (BelowMask << 3) where bit k of each mask
+		 * says vertex k is strictly above / strictly below the water. A vertex with neither bit set is on the surface.
+		 *
+		 * The submerged polygon is found by walking the triangle in its own order, keeping the vertices that are not
+		 * above the water and the points where an edge goes from one side to the other. It is then stored in reverse
+		 * order (unreal counter clockwise) and split from the point where the walk goes under the water, which gives
+		 * the same triangles the old sorting code made: (I_L, I_M, M) and (L, I_L, M) with one vertex above the water,
+		 * (J_M, J_H, L) with two above.
+		 * Vertices on the surface never create cut points so they are kept instead of dropped, and triangles with
+		 * nothing strictly under the water produce nothing.
+		 */
+		struct FClipCaseTable
+		{
+			FClipCase Cases[64];
+
+			FClipCaseTable()
+			{
+				for (int32_t Above = 0; Above < 8; Above++)
+				{
+					for (int32_t Below = 0; Below < 8; Below++)
+					{
+						FClipCase& Case = Cases[Above | (Below << 3)];
+						Case = FClipCase{ 0, { { V0, V0, V0 }, { V0, V0, V0 } } };
+
+						if ((Above & Below) != 0 || Below == 0)
+						{
+							continue;
+						}
+
+						uint8_t Polygon[4] = {};
+						int32_t NumPoints = 0;
+						int32_t Start = -1;
+						for (int32_t k = 0; k < 3; k++)
+						{
+							const int32_t Next = (k + 1) % 3;
+							const bool bAbove = (Above >> k) & 1;
+							if (!bAbove)
+							{
+								Polygon[NumPoints++] = (uint8_t)k;
+							}
+
+							const bool bGoesUnder = bAbove && ((Below >> Next) & 1);
+							const bool bComesUp = ((Below >> k) & 1) && ((Above >> Next) & 1);
+							if (bGoesUnder)
+							{
+								Start = NumPoints;
+							}
+							if (bGoesUnder || bComesUp)
+							{
+								Polygon[NumPoints++] = (uint8_t)(E01 + k);
+							}
+						}
+						if (Start < 0)
+						{
+							Start = NumPoints - 1;
+						}
+
+						uint8_t Reversed[4] = {};
+						for (int32_t j = 0; j < NumPoints; j++)
+						{
+							Reversed[j] = Polygon[(Start - j + NumPoints) % NumPoints];
+						}
+
+						Case.NumTriangles = NumPoints - 2;
+						Case.Corners[0][0] = Reversed[0];
+						Case.Corners[0][1] = Reversed[1];
+						Case.Corners[0][2] = Reversed[2];
+						if (NumPoints == 4)
+						{
+							Case.Corners[1][0] = Reversed[3];
+							Case.Corners[1][1] = Reversed[0];
+							Case.Corners[1][2] = Reversed[2];
+						}
+					}
+				}
+			}
+		};
+
+		const FClipCaseTable ClipCases;
+
+		//Every vertex strictly below the water, the case of the triangles FHullClipper::AddSubmergedTriangles takes whole
+		constexpr uint32_t SubmergedCase = 7 << 3;
+
+		//Lowest and highest of Num values, padding lanes left out
+		void GetRange(const float* Values, int32_t Num, float& OutMin, float& OutMax)
+		{
+			const int32_t NumFull = Num - Num % FSimdFloat::Width;
+			FSimdFloat Min = FSimdFloat::Splat(FLT_MAX);
+			FSimdFloat Max = FSimdFloat::Splat(-FLT_MAX);
+			for (int32_t i = 0; i < NumFull; i += FSimdFloat::Width)
+			{
+				const FSimdFloat Value = FSimdFloat::Load(Values + i);
+				Min = FSimdFloat::Min(Min, Value);
+				Max = FSimdFloat::Max(Max, Value);
+			}
+
+			float MinLanes[FSimdFloat::Width];
+			float MaxLanes[FSimdFloat::Width];
+			Min.Store(MinLanes);
+			Max.Store(MaxLanes);
+			OutMin = FLT_MAX;
+			OutMax = -FLT_MAX;
+			for (int32_t Lane = 0; Lane < FSimdFloat::Width; Lane++)
+			{
+				OutMin = std::fmin(OutMin, MinLanes[Lane]);
+				OutMax = std::fmax(OutMax, MaxLanes[Lane]);
+			}
+			for (int32_t i = NumFull; i < Num; i++)
+			{
+				OutMin = std::fmin(OutMin, Values[i]);
+				OutMax = std::fmax(OutMax, Values[i]);
+			}
+		}
+
+		/**
+		 * Sums the drag and slamming of the under water triangles as they are finished, see FHydrodynamicParams.
+		 * Slamming needs the whole submerged area of a hull triangle, so the pieces of one are held until the next
+		 * hull triangle starts. The clip always emits those pieces one after the other.
+		 */
+		class FHydrodynamicSum
+		{
+		public:
+			FHydrodynamicSum(const FBuoyancyParams& InParams, const FHullTopology& InHull, float InAreaScale, FVec3* InFlux, uint32_t* InFrames, uint32_t InFrame)
+				: Params(InParams)
+				, Hydro(InParams.Hydrodynamics)
+				, Hull(InHull)
+				, AreaScale(InAreaScale)
+				, Flux(InFlux)
+				, Frames(InFrames)
+				, Frame(InFrame)
+				, bSlamming(InParams.Hydrodynamics.HasSlamming())
+			{
+			}
+
+			//One under water triangle in world space
+			void Add(int32_t Source, const FVec3& Center, const FVec3& Normal, float Area)
+			{
+				const FVec3 Velocity = Hydro.LinearVelocity + FVec3::Cross(Hydro.AngularVelocity, Center - Params.CenterOfMass);
+				const float SpeedSquared = Velocity.SizeSquared();
+				if (SpeedSquared <= 1.e-16f)
+				{
+					return;
+				}
+				//One square root and one divide shared by every force, they are most of the cost here
+				const float InvSpeed = 1.0f / std::sqrt(SpeedSquared);
+				const float NormalSpeed = FVec3::Dot(Velocity, Normal);
+				const float CosTheta = NormalSpeed * InvSpeed;
+				Wrench.Add(ViscousResistanceForce(Params.WaterDensity, Hydro.ResistanceCoefficient, Velocity, NormalSpeed, Normal, Area) + PressureDragForce(Hydro, SpeedSquared * InvSpeed, CosTheta, Normal, Area), Center, Params.CenterOfMass);
+
+				if (!bSlamming)
+				{
+					return;
+				}
+				if (Source != PendingSource || NumPending == 2)
+				{
+					Flush();
+					PendingSource = Source;
+				}
+				PendingFlux += Velocity * Area;
+				Pending[NumPending++] = FPiece{ Center, Velocity, CosTheta, Area };
+			}
+
+			//Slamming of the held pieces, call once more after the last triangle
+			void Flush()
+			{
+				if (NumPending == 0)
+				{
+					return;
+				}
+
+				//Change of submerged area times velocity over the area of the whole hull triangle
+				const FVec3 Previous = Frames[PendingSource] + 1 == Frame ? Flux[PendingSource] : FVec3();
+				Flux[PendingSource] = PendingFlux;
+				Frames[PendingSource] = Frame;
+				const float SourceArea = Hull.TriangleAreas[PendingSource] * AreaScale;
+				const float Acceleration = SourceArea > 0.0f ? (PendingFlux - Previous).Size() / (SourceArea * Hydro.DeltaTime) : 0.0f;
+
+				for (int32_t i = 0; i < NumPending; i++)
+				{
+					const FPiece& Piece = Pending[i];
+					Wrench.Add(SlammingForce(Hydro, Acceleration, Piece.CosTheta, Piece.Velocity, Piece.Area, Hull.SurfaceArea * AreaScale), Piece.Center, Params.CenterOfMass);
+				}
+				NumPending = 0;
+				PendingFlux = FVec3();
+			}
+
+			const FBuoyancyWrench& GetWrench() const { return Wrench; }
+
+		private:
+			struct FPiece
+			{
+				FVec3 Center;
+				FVec3 Velocity;
+				float CosTheta;
+				float Area;
+			};
+
+			const FBuoyancyParams& Params;
+			const FHydrodynamicParams& Hydro;
+			const FHullTopology& Hull;
+			//World area over local area, for the hull triangle areas
+			const float AreaScale;
+			FVec3* Flux;
+			uint32_t* Frames;
+			const uint32_t Frame;
+			const bool bSlamming;
+
+			FBuoyancyWrench Wrench;
+			FPiece Pending[2];
+			int32_t NumPending = 0;
+			int32_t PendingSource = -1;
+			FVec3 PendingFlux;
+		};
+
+		//Point where A-B crosses the water, only meaningful when the edge really crosses it
+		inline FVec3 EdgeAtWater(const FVec3& A, const FVec3& B, float DA, float DB)
+		{
+			//Only edges with one end strictly above and one strictly below are picked by the table, keep the rest finite anyway
+			const float Denominator = DA - DB;
+			const float t = DA / (Denominator != 0.0f ? Denominator : 1.0f);
+			//Clamped for UpdateUnderWaterMesh, where the cached case can be slightly out of date
+			const float Clamped = std::fmin(std::fmax(t, 0.0f), 1.0f);
+			return A + Clamped * (B - A);
+		}
+	}
+
+	FUnderWaterTriangle FUnderWaterTriangle::Make(const FVec3& P1, const FVec3& P2, const FVec3& P3)
+	{
+		FUnderWaterTriangle Triangle;
+		Triangle.P1 = P1;
+		Triangle.P2 = P2;
+		Triangle.P3 = P3;
+		Triangle.CornerDistances[0] = P1.Z;
+		Triangle.CornerDistances[1] = P2.Z;
+		Triangle.CornerDistances[2] = P3.Z;
+		Triangle.UpdateDerivedData();
+		return Triangle;
+	}
+
+	void FUnderWaterTriangle::UpdateDerivedData()
+	{
+		//Center of the triangle
+		Center = (P1 + P2 + P3) / 3.0f;
+
+		//Depth of the center, the water is linear across the triangle so this is the average of the corners
+		DistanceToSurface = -(CornerDistances[0] + CornerDistances[1] + CornerDistances[2]) / 3.0f;
+
+		//Normal to the triangle, the cross product is twice the area long. This used to be clamped to length 1 instead
+		//of normalized, and the area came from the corner angle put into sin as degrees, both wrong for most triangles
+		const FVec3 Cross = FVec3::Cross(P2 - P3, P1 - P3);
+		const float DoubleArea = Cross.Size();
+		Normal = DoubleArea > 1.e-8f ? Cross / DoubleArea : FVec3();
+		Area = DoubleArea * 0.5f;
+	}
+
+	void FHullClipper::SetHull(std::shared_ptr<const FHullTopology> InHull)
+	{
+		Hull = InHull ? std::move(InHull) : FHullTopology::GetEmpty();
+		ResetScratchBuffers();
+	}
+
+	void FHullClipper::SetHull(const FVec3* LocalVertices, int32_t NumVertices, const int32_t* TriangleIndexes, int32_t NumIndexes)
+	{
+		SetHull(FHullTopology::Make(LocalVertices, NumVertices, TriangleIndexes, NumIndexes));
+	}
+
+	void FHullClipper::ResetScratchBuffers()
+	{
+		const int32_t NumVertices = Hull->Vertices.Num;
+		const int32_t PaddedNum = Hull->Vertices.GetPaddedNum();
+		const int32_t NumIndexes = (int32_t)Hull->Triangles.size();
+
+		MeshVerticesGlobal.SetNum(NumVertices);
+		AllDistancesToWater.assign(PaddedNum, 0.0f);
+		WaterHeights.assign(PaddedNum, 0.0f);
+		AboveWaterBits.assign(PaddedNum / 8, 0);
+		BelowWaterBits.assign(PaddedNum / 8, 0);
+
+		UnderWaterTriangles.assign(2 * (NumIndexes / 3) + 2, FUnderWaterTriangle());
+		UnderWaterSources.assign(UnderWaterTriangles.size(), 0);
+		NumUnderWaterTriangles = 0;
+
+		WetTriangles.assign(NumIndexes / 3 + 1, 0);
+		WetTriangleCases.assign(NumIndexes / 3 + 1, 0);
+		NumWetTriangles = 0;
+		NumWetSubmerged = 0;
+		bHasClassification = false;
+
+		const size_t NumCulled = Hull->BoundsTree.IsEmpty() ? 0 : NumIndexes / 3;
+		SubmergedTriangles.assign(NumCulled, 0);
+		WaterlineTriangles.assign(NumCulled, 0);
+		NumSubmergedTriangles = 0;
+		NumWaterlineTriangles = 0;
+
+		//The coherent and slamming state too, even if they end up unused, so no clip ever allocates after this
+		CandidateTriangles.clear();
+		CandidateTriangles.reserve(NumIndexes / 3);
+		ReferenceDistances.assign(PaddedNum, 0.0f);
+		ResultDistances.assign(PaddedNum, 0.0f);
+		bHasCoherentState = false;
+
+		SlammingFlux.assign(NumIndexes / 3, FVec3());
+		SlammingFrames.assign(NumIndexes / 3, 0);
+	}
+
+	void FHullClipper::ForgetHistory()
+	{
+		NumUnderWaterTriangles = 0;
+		NumWetTriangles = 0;
+		NumWetSubmerged = 0;
+		bHasClassification = false;
+		bHasCoherentState = false;
+		//Skipping a frame makes every triangle's slamming state older than the last frame, see FHydrodynamicSum
+		HydrodynamicFrame++;
+		HydrodynamicWrench = FBuoyancyWrench();
+	}
+
+	size_t FHullClipper::GetScratchSize() const
+	{
+		return MeshVerticesGlobal.GetAllocatedSize()
+			+ (AllDistancesToWater.capacity() + WaterHeights.capacity() + ReferenceDistances.capacity() + ResultDistances.capacity()) * sizeof(float)
+			+ (AboveWaterBits.capacity() + BelowWaterBits.capacity() + WetTriangleCases.capacity()) * sizeof(uint8_t)
+			+ UnderWaterTriangles.capacity() * sizeof(FUnderWaterTriangle)
+			+ (UnderWaterSources.capacity() + WetTriangles.capacity() + SubmergedTriangles.capacity() + WaterlineTriangles.capacity() + CandidateTriangles.capacity()) * sizeof(int32_t)
+			+ SlammingFlux.capacity() * sizeof(FVec3) + SlammingFrames.capacity() * sizeof(uint32_t);
+	}
+
+	void FHullClipper::SetWaterSurface(const IWaterSurface* Surface, float Time)
+	{
+		WaterSurface = Surface;
+		WaterTime = Time;
+	}
+
+	void FHullClipper::GenerateUnderWaterMesh(const FHullTransform& LocalToWorld)
+	{
+		bHasCoherentState = false;
+		TransformAndClassify(LocalToWorld);
+		ClipTriangles(LocalToWorld);
+
+		//Center, normal and area in a separate tight loop over what was actually emitted
+		FClipStageScope StageScope(Profiler, EClipStage::Integrate);
+		FUnderWaterTriangle* Output = UnderWaterTriangles.data();
+		for (int32_t i = 0; i < NumUnderWaterTriangles; i++)
+		{
+			Output[i].UpdateDerivedData();
+		}
+	}
+
+	void FHullClipper::GenerateUnderWaterMesh(const FHullTransform& LocalToWorld, const FBuoyancyParams& Params, FBuoyancyWrench& OutWrench)
+	{
+		bHasCoherentState = false;
+		TransformAndMeasure(LocalToWorld);
+		if (Params.Model == EBuoyancyModel::DisplacedVolume)
+		{
+			float MinDistance;
+			float MaxDistance;
+			GetRange(AllDistancesToWater.data(), Hull->Vertices.Num, MinDistance, MaxDistance);
+			if (TryDisplacedVolumeFastPath(LocalToWorld, MinDistance, MaxDistance, Params, OutWrench))
+			{
+				return;
+			}
+		}
+
+		ClassifyAllVertices();
+		ClipTriangles(LocalToWorld);
+		FinishTriangles(LocalToWorld, Params, OutWrench);
+	}
+
+	void FHullClipper::UpdateUnderWaterMesh(const FHullTransform& LocalToWorld, const FBuoyancyParams& Params, FBuoyancyWrench& OutWrench)
+	{
+		if (!bHasClassification)
+		{
+			GenerateUnderWaterMesh(LocalToWorld, Params, OutWrench);
+			return;
+		}
+
+		//New depths, but the triangles and cases from the last full clip
+		bHasCoherentState = false;
+		TransformAndMeasure(LocalToWorld);
+		UpdateTriangles();
+		FinishTriangles(LocalToWorld, Params, OutWrench);
+	}
+
+	void FHullClipper::GenerateUnderWaterMeshCoherent(const FHullTransform& LocalToWorld, const FBuoyancyParams& Params, const FClipCoherenceSettings& Settings, FBuoyancyWrench& OutWrench)
+	{
+		TransformAndMeasure(LocalToWorld);
+
+		if (bHasCoherentState)
+		{
+			//No vertex can have moved further than the change of the linear part times the hull radius plus the change of the translation
+			float LinearChange = 0.0f;
+			for (int32_t Row = 0; Row < 3; Row++)
+			{
+				for (int32_t Col = 0; Col < 3; Col++)
+				{
+					const float Delta = LocalToWorld.M[Row][Col] - ResultTransform.M[Row][Col];
+					LinearChange += Delta * Delta;
+				}
+			}
+			const FVec3 TranslationChange(LocalToWorld.M[0][3] - ResultTransform.M[0][3], LocalToWorld.M[1][3] - ResultTransform.M[1][3], LocalToWorld.M[2][3] - ResultTransform.M[2][3]);
+			const float MaxMovement = std::sqrt(LinearChange) * Hull->BoundingRadius + TranslationChange.Size();
+
+			//Drag and slamming follow the velocity and the last frame's flux, which a pose that didn't move says nothing about
+			if (!Params.Hydrodynamics.bEnabled && MaxMovement <= Settings.SkipMovement && GetMaxDepthChange(ResultDistances) <= Settings.SkipDepthChange)
+			{
+				//The triangles in UnderWaterTriangles are still the ones the wrench was summed from
+				OutWrench = ResultWrench;
+				HydrodynamicWrench = FBuoyancyWrench();
+				LastClipPath = EClipPath::Skipped;
+				return;
+			}
+
+			//A triangle that had every corner at least BandMargin above the water can't have a corner below it now
+			if (GetMaxDepthChange(ReferenceDistances) <= Settings.BandMargin)
+			{
+				ClassifyAllVertices();
+				NumUnderWaterTriangles = 0;
+				NumWetTriangles = 0;
+				NumWetSubmerged = 0;
+				AddTriangles(CandidateTriangles.data(), (int32_t)CandidateTriangles.size());
+				FinishTriangles(LocalToWorld, Params, OutWrench);
+				SaveCoherentResult(LocalToWorld, OutWrench);
+				LastClipPath = EClipPath::Band;
+				return;
+			}
+		}
+
+		ClassifyAllVertices();
+		ClipTriangles(LocalToWorld);
+		FinishTriangles(LocalToWorld, Params, OutWrench);
+
+		//The new reference, and every triangle with a corner that could get under water before the next full clip
+		FClipStageScope StageScope(Profiler, EClipStage::Classify);
+		ReferenceDistances = AllDistancesToWater;
+		CandidateTriangles.clear();
+		const int32_t* Indexes = Hull->Triangles.data();
+		const float* Distances = AllDistancesToWater.data();
+		for (int32_t Triangle = 0; Triangle < GetNumTriangles(); Triangle++)
+		{
+			const float MinDistance = std::fmin(Distances[Indexes[Triangle * 3 + 0]], std::fmin(Distances[Indexes[Triangle * 3 + 1]], Distances[Indexes[Triangle * 3 + 2]]));
+			if (MinDistance < Settings.BandMargin)
+			{
+				CandidateTriangles.push_back(Triangle);
+			}
+		}
+		SaveCoherentResult(LocalToWorld, OutWrench);
+		LastClipPath = EClipPath::Full;
+	}
+
+	void FHullClipper::GenerateUnderWaterMeshLocal(const FHullTransform& LocalToWorld, const FBuoyancyParams& Params, FBuoyancyWrench& OutWrench)
+	{
+		bHasCoherentState = false;
+		bLocalSpace = true;
+
+		FVec3 HeightAxis;
+		float HeightOffset;
+		GetLocalWaterPlane(LocalToWorld, HeightAxis, HeightOffset);
+
+		//Every vertex is within the hull radius of the origin, which bounds the heights without looking at them
+		if (Params.Model == EBuoyancyModel::DisplacedVolume)
+		{
+			const float HeightRadius = HeightAxis.Size() * Hull->BoundingRadius;
+			if (TryDisplacedVolumeFastPath(LocalToWorld, HeightOffset - HeightRadius, HeightOffset + HeightRadius, Params, OutWrench))
+			{
+				return;
+			}
+		}
+
+		{
+			FClipStageScope StageScope(Profiler, EClipStage::Transform);
+			ComputePlaneDistances(Hull->Vertices, HeightAxis, HeightOffset, AllDistancesToWater.data());
+		}
+		ClassifyAllVertices();
+		ClipTriangles(HeightAxis, HeightOffset, 0.0f, 0.0f);
+		FinishTrianglesLocal(LocalToWorld, Params, OutWrench);
+	}
+
+	void FHullClipper::GenerateAnalyticForces(const FHullTransform& LocalToWorld, const FBuoyancyParams& Params, FBuoyancyWrench& OutWrench)
+	{
+		bHasCoherentState = false;
+		FVec3 HeightAxis;
+		float HeightOffset;
+		GetLocalWaterPlane(LocalToWorld, HeightAxis, HeightOffset);
+
+		FClipStageScope StageScope(Profiler, EClipStage::Integrate);
+		AdvanceHydrodynamicFrame(Params);
+		//Like the displaced volume fast path there is nothing UpdateUnderWaterMesh could reuse
+		NumUnderWaterTriangles = 0;
+		NumWetTriangles = 0;
+		NumWetSubmerged = 0;
+		bHasClassification = false;
+		OutWrench = FBuoyancyWrench();
+
+		//Column centers are a quarter of the box in from its sides, the height range of a column is that of a box half as wide and deep
+		const FVec3 Center = (Hull->BoundsMin + Hull->BoundsMax) * 0.5f;
+		const FVec3 Quarter = (Hull->BoundsMax - Hull->BoundsMin) * 0.25f;
+		const float ColumnRadius = std::fabs(HeightAxis.X) * Quarter.X + std::fabs(HeightAxis.Y) * Quarter.Y + std::fabs(HeightAxis.Z) * Quarter.Z * 2.0f;
+		const float ColumnVolume = Hull->Volume * LocalToWorld.GetDeterminant() * 0.25f;
+		if (ColumnRadius <= 0.0f)
+		{
+			return;
+		}
+
+		for (int32_t Column = 0; Column < 4; Column++)
+		{
+			const FVec3 Local(Center.X + ((Column & 1) ? Quarter.X : -Quarter.X), Center.Y + ((Column & 2) ? Quarter.Y : -Quarter.Y), Center.Z);
+			const float Height = FVec3::Dot(HeightAxis, Local) + HeightOffset;
+			const float Bottom = Height - ColumnRadius;
+			const float Top = std::fmin(Height + ColumnRadius, 0.0f);
+			if (Top <= Bottom)
+			{
+				continue;
+			}
+
+			//The wet part is the bottom of the column, its center is moved down from the column's along the world up axis
+			const FVec3 CenterOfBuoyancy = LocalToWorld.TransformPosition(Local) + FVec3(0.0f, 0.0f, (Bottom + Top) * 0.5f - Height);
+			AddDisplacedVolume(OutWrench, Params.WaterDensity, Params.GravityZ, ColumnVolume * (Top - Bottom) / (2.0f * ColumnRadius), CenterOfBuoyancy, Params.CenterOfMass);
+		}
+	}
+
+	void FHullClipper::GetLocalWaterPlane(const FHullTransform& LocalToWorld, FVec3& OutHeightAxis, float& OutHeightOffset) const
+	{
+		FClipStageScope StageScope(Profiler, EClipStage::Transform);
+
+		//Scale along the world up axis, the hull radius in world space
+		const FVec3 Up(LocalToWorld.M[2][0], LocalToWorld.M[2][1], LocalToWorld.M[2][2]);
+		const FVec3 Origin = LocalToWorld.GetOrigin();
+		const FWaterPlane Water = FWaterPlane::Fit(WaterSurface, WaterTime, Origin.X, Origin.Y, Hull->BoundingRadius * Up.Size());
+
+		//Height above the plane is Dot(World, (-SlopeX, -SlopeY, 1)) minus the plane at the center, the transposed linear part brings that axis into local space
+		const FVec3 WorldAxis(-Water.SlopeX, -Water.SlopeY, 1.0f);
+		OutHeightAxis = FVec3(
+			LocalToWorld.M[0][0] * WorldAxis.X + LocalToWorld.M[1][0] * WorldAxis.Y + LocalToWorld.M[2][0] * WorldAxis.Z,
+			LocalToWorld.M[0][1] * WorldAxis.X + LocalToWorld.M[1][1] * WorldAxis.Y + LocalToWorld.M[2][1] * WorldAxis.Z,
+			LocalToWorld.M[0][2] * WorldAxis.X + LocalToWorld.M[1][2] * WorldAxis.Y + LocalToWorld.M[2][2] * WorldAxis.Z);
+		OutHeightOffset = Origin.Z - Water.GetHeight(Origin.X, Origin.Y);
+	}
+
+	float FHullClipper::GetMaxDepthChange(const std::vector<float>& Other) const
+	{
+		//Padding lanes are the transformed origin rather than a vertex, so they are left out
+		const int32_t Num = Hull->Vertices.Num;
+		const int32_t NumFull = Num - Num % FSimdFloat::Width;
+		const float* Distances = AllDistancesToWater.data();
+		const float* OtherDistances = Other.data();
+
+		FSimdFloat MaxChange = FSimdFloat::Splat(0.0f);
+		for (int32_t i = 0; i < NumFull; i += FSimdFloat::Width)
+		{
+			const FSimdFloat Change = FSimdFloat::Load(Distances + i) - FSimdFloat::Load(OtherDistances + i);
+			MaxChange = FSimdFloat::Max(MaxChange, FSimdFloat::Max(Change, FSimdFloat::Splat(0.0f) - Change));
+		}
+
+		float Lanes[FSimdFloat::Width];
+		MaxChange.Store(Lanes);
+		float Result = 0.0f;
+		for (int32_t Lane = 0; Lane < FSimdFloat::Width; Lane++)
+		{
+			Result = std::fmax(Result, Lanes[Lane]);
+		}
+		for (int32_t i = NumFull; i < Num; i++)
+		{
+			Result = std::fmax(Result, std::fabs(Distances[i] - OtherDistances[i]));
+		}
+		return Result;
+	}
+
+	void FHullClipper::SaveCoherentResult(const FHullTransform& LocalToWorld, const FBuoyancyWrench& Wrench)
+	{
+		ResultDistances = AllDistancesToWater;
+		ResultTransform = LocalToWorld;
+		ResultWrench = Wrench;
+		bHasCoherentState = true;
+	}
+
+	void FHullClipper::TransformAndMeasure(const FHullTransform& LocalToWorld)
+	{
+		FClipStageScope StageScope(Profiler, EClipStage::Transform);
+		bLocalSpace = false;
+
+		//Global positions and height above Z = 0 for every vertex in one vectorized pass
+		TransformVerticesAndDistances(LocalToWorld, Hull->Vertices, 0.0f, MeshVerticesGlobal, AllDistancesToWater.data());
+		if (WaterSurface == nullptr)
+		{
+			return;
+		}
+
+		//One query for the whole hull, padding lanes included so the subtract below needs no tail
+		const int32_t PaddedNum = Hull->Vertices.GetPaddedNum();
+		float* Distances = AllDistancesToWater.data();
+		const float* Heights = WaterHeights.data();
+		WaterSurface->GetHeights(MeshVerticesGlobal.X.data(), MeshVerticesGlobal.Y.data(), PaddedNum, WaterTime, WaterHeights.data());
+		for (int32_t i = 0; i < PaddedNum; i += FSimdFloat::Width)
+		{
+			(FSimdFloat::Load(Distances + i) - FSimdFloat::Load(Heights + i)).Store(Distances + i);
+		}
+	}
+
+	void FHullClipper::TransformAndClassify(const FHullTransform& LocalToWorld)
+	{
+		TransformAndMeasure(LocalToWorld);
+		ClassifyAllVertices();
+	}
+
+	void FHullClipper::ClassifyAllVertices()
+	{
+		//Sign of every vertex, packed so the triangle loop only needs a few bit lookups for its case
+		FClipStageScope StageScope(Profiler, EClipStage::Classify);
+		ClassifyVertices(AllDistancesToWater.data(), Hull->Vertices.GetPaddedNum(), AboveWaterBits.data(), BelowWaterBits.data());
+	}
+
+	void FHullClipper::ClipTriangles(const FHullTransform& LocalToWorld)
+	{
+		float WaterMin = 0.0f;
+		float WaterMax = 0.0f;
+		if (!Hull->BoundsTree.IsEmpty())
+		{
+			GetWaterHeightRange(WaterMin, WaterMax);
+		}
+		const FVec3 HeightAxis(LocalToWorld.M[2][0], LocalToWorld.M[2][1], LocalToWorld.M[2][2]);
+		ClipTriangles(HeightAxis, LocalToWorld.M[2][3], WaterMin, WaterMax);
+	}
+
+	void FHullClipper::ClipTriangles(const FVec3& HeightAxis, float HeightOffset, float WaterMin, float WaterMax)
+	{
+		NumUnderWaterTriangles = 0;
+		NumWetTriangles = 0;
+		NumWetSubmerged = 0;
+		if (Hull->BoundsTree.IsEmpty())
+		{
+			AddTriangles();
+			return;
+		}
+
+		CullTriangles(HeightAxis, HeightOffset, WaterMin, WaterMax);
+		AddSubmergedTriangles(SubmergedTriangles.data(), NumSubmergedTriangles);
+		AddTriangles(WaterlineTriangles.data(), NumWaterlineTriangles);
+	}
+
+	void FHullClipper::CullTriangles(const FVec3& HeightAxis, float HeightOffset, float WaterMin, float WaterMax)
+	{
+		FClipStageScope StageScope(Profiler, EClipStage::Classify);
+		const FHullBoundsTree& Tree = Hull->BoundsTree;
+		const int32_t* TreeTriangles = Tree.Triangles.data();
+		const float WaterSize = std::fmax(std::fabs(WaterMin), std::fabs(WaterMax));
+
+		int32_t NumSubmerged = 0;
+		int32_t NumWaterline = 0;
+		int32_t Stack[FHullBoundsTree::MaxDepth];
+		int32_t StackSize = 0;
+		Stack[StackSize++] = 0;
+		while (StackSize > 0)
+		{
+			const int32_t NodeIndex = Stack[--StackSize];
+			const FHullBoundsNode& Node = Tree.Nodes[NodeIndex];
+
+			//Height range of the box, its center plus the half extents projected on the height axis
+			const FVec3 Center = (Node.Min + Node.Max) * 0.5f;
+			const FVec3 HalfExtent = (Node.Max - Node.Min) * 0.5f;
+			const float CenterZ = FVec3::Dot(HeightAxis, Center) + HeightOffset;
+			const float RadiusZ = std::fabs(HeightAxis.X) * HalfExtent.X + std::fabs(HeightAxis.Y) * HalfExtent.Y + std::fabs(HeightAxis.Z) * HalfExtent.Z;
+			//The vertex distances were rounded differently, only decide a box when it is clear of that
+			const float Margin = 1.e-5f * (std::fabs(CenterZ) + RadiusZ + WaterSize);
+
+			const bool bDry = CenterZ - RadiusZ - WaterMax > Margin;
+			const bool bSubmerged = CenterZ + RadiusZ - WaterMin < -Margin;
+			if (bDry)
+			{
+				continue;
+			}
+			if (bSubmerged || Node.IsLeaf())
+			{
+				int32_t* Out = bSubmerged ? SubmergedTriangles.data() + NumSubmerged : WaterlineTriangles.data() + NumWaterline;
+				std::copy(TreeTriangles + Node.FirstTriangle, TreeTriangles + Node.FirstTriangle + Node.NumTriangles, Out);
+				(bSubmerged ? NumSubmerged : NumWaterline) += Node.NumTriangles;
+				continue;
+			}
+
+			//First child on top so the triangles come out in tree order
+			Stack[StackSize++] = Node.SecondChild;
+			Stack[StackSize++] = NodeIndex + 1;
+		}
+		NumSubmergedTriangles = NumSubmerged;
+		NumWaterlineTriangles = NumWaterline;
+	}
+
+	void FHullClipper::GetWaterHeightRange(float& OutMin, float& OutMax) const
+	{
+		if (WaterSurface == nullptr)
+		{
+			OutMin = 0.0f;
+			OutMax = 0.0f;
+			return;
+		}
+
+		GetRange(WaterHeights.data(), Hull->Vertices.Num, OutMin, OutMax);
+	}
+
+	int32_t FHullClipper::ClipTriangle(int32_t Triangle, uint32_t CaseIndex, FUnderWaterTriangle* Out) const
+	{
+		const int32_t* Indexes = Hull->Triangles.data() + Triangle * 3;
+		const int32_t I0 = Indexes[0];
+		const int32_t I1 = Indexes[1];
+		const int32_t I2 = Indexes[2];
+
+		const FVertexStream& Vertices = GetClipVertices();
+		const FVec3 P0 = Vertices.Get(I0);
+		const FVec3 P1 = Vertices.Get(I1);
+		const FVec3 P2 = Vertices.Get(I2);
+		const float D0 = AllDistancesToWater[I0];
+		const float D1 = AllDistancesToWater[I1];
+		const float D2 = AllDistancesToWater[I2];
+
+		const FVec3 Points[6] = { P0, P1, P2, EdgeAtWater(P0, P1, D0, D1), EdgeAtWater(P1, P2, D1, D2), EdgeAtWater(P2, P0, D2, D0) };
+		const float Distances[6] = { D0, D1, D2, 0.0f, 0.0f, 0.0f };
+
+		//No branching on the case: both output slots are always written and only the first NumTriangles count,
+		//the unused slot gets overwritten by the next triangle
+		const FClipCase& Case = ClipCases.Cases[CaseIndex];
+		for (int32_t Slot = 0; Slot < 2; Slot++)
+		{
+			Out[Slot].P1 = Points[Case.Corners[Slot][0]];
+			Out[Slot].P2 = Points[Case.Corners[Slot][1]];
+			Out[Slot].P3 = Points[Case.Corners[Slot][2]];
+			Out[Slot].CornerDistances[0] = Distances[Case.Corners[Slot][0]];
+			Out[Slot].CornerDistances[1] = Distances[Case.Corners[Slot][1]];
+			Out[Slot].CornerDistances[2] = Distances[Case.Corners[Slot][2]];
+		}
+		return Case.NumTriangles;
+	}
+
+	void FHullClipper::AddTriangles(const int32_t* Candidates, int32_t NumCandidates)
+	{
+		FClipStageScope StageScope(Profiler, EClipStage::Clip);
+		const int32_t NumTriangles = Candidates ? NumCandidates : GetNumTriangles();
+		const int32_t* Indexes = Hull->Triangles.data();
+		const uint8_t* AboveBits = AboveWaterBits.data();
+		const uint8_t* BelowBits = BelowWaterBits.data();
+		FUnderWaterTriangle* Output = UnderWaterTriangles.data();
+		int32_t* Sources = UnderWaterSources.data();
+		int32_t* WetTriangleIndexes = WetTriangles.data();
+		uint8_t* WetCases = WetTriangleCases.data();
+
+		int32_t Count = NumUnderWaterTriangles;
+		int32_t NumWet = NumWetTriangles;
+		for (int32_t i = 0; i < NumTriangles; i++)
+		{
+			const int32_t Triangle = Candidates ? Candidates[i] : i;
+			const int32_t I0 = Indexes[Triangle * 3 + 0];
+			const int32_t I1 = Indexes[Triangle * 3 + 1];
+			const int32_t I2 = Indexes[Triangle * 3 + 2];
+
+			const uint32_t AboveMask =
+				((AboveBits[I0 >> 3] >> (I0 & 7)) & 1) |
+				(((AboveBits[I1 >> 3] >> (I1 & 7)) & 1) << 1) |
+				(((AboveBits[I2 >> 3] >> (I2 & 7)) & 1) << 2);
+			const uint32_t BelowMask =
+				((BelowBits[I0 >> 3] >> (I0 & 7)) & 1) |
+				(((BelowBits[I1 >> 3] >> (I1 & 7)) & 1) << 1) |
+				(((BelowBits[I2 >> 3] >> (I2 & 7)) & 1) << 2);
+			const uint32_t CaseIndex = AboveMask | (BelowMask << 3);
+
+			const int32_t Emitted = ClipTriangle(Triangle, CaseIndex, Output + Count);
+			Sources[Count] = Triangle;
+			Sources[Count + 1] = Triangle;
+			Count += Emitted;
+
+			//Remember the classification so UpdateUnderWaterMesh can skip it, written always and kept when wet
+			WetTriangleIndexes[NumWet] = Triangle;
+			WetCases[NumWet] = (uint8_t)CaseIndex;
+			NumWet += Emitted > 0 ? 1 : 0;
+		}
+		NumUnderWaterTriangles = Count;
+		NumWetTriangles = NumWet;
+		bHasClassification = true;
+	}
+
+	void FHullClipper::CopySubmergedTriangles(const int32_t* Triangles, int32_t Num, FUnderWaterTriangle* Output, int32_t* Sources) const
+	{
+		const int32_t* Indexes = Hull->Triangles.data();
+		const FVertexStream& Vertices = GetClipVertices();
+		for (int32_t i = 0; i < Num; i++)
+		{
+			const int32_t Triangle = Triangles[i];
+			const int32_t I0 = Indexes[Triangle * 3 + 0];
+			const int32_t I1 = Indexes[Triangle * 3 + 1];
+			const int32_t I2 = Indexes[Triangle * 3 + 2];
+
+			//Reversed like the clip table does it for a triangle with every corner under water
+			FUnderWaterTriangle& Out = Output[i];
+			Out.P1 = Vertices.Get(I2);
+			Out.P2 = Vertices.Get(I1);
+			Out.P3 = Vertices.Get(I0);
+			Out.CornerDistances[0] = AllDistancesToWater[I2];
+			Out.CornerDistances[1] = AllDistancesToWater[I1];
+			Out.CornerDistances[2] = AllDistancesToWater[I0];
+			Sources[i] = Triangle;
+		}
+	}
+
+	void FHullClipper::AddSubmergedTriangles(const int32_t* Triangles, int32_t Num)
+	{
+		FClipStageScope StageScope(Profiler, EClipStage::Clip);
+		CopySubmergedTriangles(Triangles, Num, UnderWaterTriangles.data() + NumUnderWaterTriangles, UnderWaterSources.data() + NumUnderWaterTriangles);
+
+		//Only the first ones of a clip can be copied again by UpdateTriangles, the wet list has to start with them
+		NumWetSubmerged += NumWetSubmerged == NumWetTriangles ? Num : 0;
+		std::copy(Triangles, Triangles + Num, WetTriangles.data() + NumWetTriangles);
+		std::fill(WetTriangleCases.data() + NumWetTriangles, WetTriangleCases.data() + NumWetTriangles + Num, (uint8_t)SubmergedCase);
+		NumUnderWaterTriangles += Num;
+		NumWetTriangles += Num;
+		bHasClassification = true;
+	}
+
+	void FHullClipper::UpdateTriangles()
+	{
+		FClipStageScope StageScope(Profiler, EClipStage::Clip);
+		const int32_t* WetTriangleIndexes = WetTriangles.data();
+		const uint8_t* WetCases = WetTriangleCases.data();
+		FUnderWaterTriangle* Output = UnderWaterTriangles.data();
+		int32_t* Sources = UnderWaterSources.data();
+
+		//What the bounds tree found under water is copied whole like the full clip does, only its waterline goes through the table
+		CopySubmergedTriangles(WetTriangleIndexes, NumWetSubmerged, Output, Sources);
+		int32_t Count = NumWetSubmerged;
+		for (int32_t i = NumWetSubmerged; i < NumWetTriangles; i++)
+		{
+			const int32_t Triangle = WetTriangleIndexes[i];
+			Sources[Count] = Triangle;
+			Sources[Count + 1] = Triangle;
+			Count += ClipTriangle(Triangle, WetCases[i], Output + Count);
+		}
+		NumUnderWaterTriangles = Count;
+	}
+
+	bool FHullClipper::TryDisplacedVolumeFastPath(const FHullTransform& LocalToWorld, float MinHeight, float MaxHeight, const FBuoyancyParams& Params, FBuoyancyWrench& OutWrench)
+	{
+		//Drag and slamming are summed over the triangles, a submerged hull with those has to be clipped
+		const bool bDry = MinHeight > 0.0f;
+		const bool bSubmerged = MaxHeight < 0.0f && !Params.Hydrodynamics.bEnabled;
+		if (!bDry && !bSubmerged)
+		{
+			return false;
+		}
+		FClipStageScope StageScope(Profiler, EClipStage::Integrate);
+		AdvanceHydrodynamicFrame(Params);
+
+		//Nothing is clipped, so there are no triangles and nothing UpdateUnderWaterMesh could reuse
+		NumUnderWaterTriangles = 0;
+		NumWetTriangles = 0;
+		NumWetSubmerged = 0;
+		bHasClassification = false;
+		OutWrench = FBuoyancyWrench();
+		if (bSubmerged)
+		{
+			AddDisplacedVolume(OutWrench, Params.WaterDensity, Params.GravityZ, Hull->Volume * LocalToWorld.GetDeterminant(), LocalToWorld.TransformPosition(Hull->Centroid), Params.CenterOfMass);
+		}
+		return true;
+	}
+
+	void FHullClipper::SumDisplacedVolume(float& OutVolume, FVec3& OutCentroid) const
+	{
+		const FUnderWaterTriangle* Output = UnderWaterTriangles.data();
+
+		//The under water triangles are closed off by the waterline, as a fan of triangles from any point on it. Cones
+		//from that point to every triangle then give the volume and centroid, the fan's own cones are flat and add nothing.
+		//The average cut point is on the waterline, and close to the hull which keeps the products small
+		FVec3 Apex;
+		int32_t NumCutPoints = 0;
+		for (int32_t i = 0; i < NumUnderWaterTriangles; i++)
+		{
+			for (int32_t Corner = 0; Corner < 3; Corner++)
+			{
+				if (Output[i].CornerDistances[Corner] == 0.0f)
+				{
+					Apex += Corner == 0 ? Output[i].P1 : (Corner == 1 ? Output[i].P2 : Output[i].P3);
+					NumCutPoints++;
+				}
+			}
+		}
+		//A closed hull entirely under water needs no cap, any point does
+		Apex = NumCutPoints > 0 ? Apex / (float)NumCutPoints : (NumUnderWaterTriangles > 0 ? Output[0].P1 : FVec3());
+
+		//Double sums, the cones of a big hull are many small numbers of both signs
+		double Volume = 0.0;
+		double MomentX = 0.0;
+		double MomentY = 0.0;
+		double MomentZ = 0.0;
+		for (int32_t i = 0; i < NumUnderWaterTriangles; i++)
+		{
+			const FVec3 A = Output[i].P1 - Apex;
+			const FVec3 B = Output[i].P2 - Apex;
+			const FVec3 C = Output[i].P3 - Apex;
+			//The clipped triangles are wound the other way round from the hull, see FClipCaseTable
+			const float ConeVolume = -FVec3::Dot(A, FVec3::Cross(B, C)) / 6.0f;
+			const FVec3 ConeMoment = (A + B + C) * (ConeVolume / 4.0f);
+			Volume += ConeVolume;
+			MomentX += ConeMoment.X;
+			MomentY += ConeMoment.Y;
+			MomentZ += ConeMoment.Z;
+		}
+
+		OutVolume = (float)Volume;
+		OutCentroid = Volume != 0.0 ? Apex + FVec3((float)(MomentX / Volume), (float)(MomentY / Volume), (float)(MomentZ / Volume)) : Apex;
+	}
+
+	void FHullClipper::AdvanceHydrodynamicFrame(const FBuoyancyParams& Params)
+	{
+		HydrodynamicWrench = FBuoyancyWrench();
+		if (Params.Hydrodynamics.HasSlamming())
+		{
+			HydrodynamicFrame++;
+		}
+	}
+
+	void FHullClipper::FinishTriangles(const FHullTransform& LocalToWorld, const FBuoyancyParams& Params, FBuoyancyWrench& OutWrench)
+	{
+		FClipStageScope StageScope(Profiler, EClipStage::Integrate);
+		OutWrench = FBuoyancyWrench();
+		FUnderWaterTriangle* Output = UnderWaterTriangles.data();
+		const int32_t* Sources = UnderWaterSources.data();
+
+		//Drag and slamming in the same loop as the buoyancy, the triangles are already world space
+		const bool bHydrodynamics = Params.Hydrodynamics.bEnabled;
+		AdvanceHydrodynamicFrame(Params);
+		//The triangles are world space but the hull's areas are local. Volumes grow with the determinant, so areas with its 2/3 power,
+		//exact for a uniform scale and the mean for any other
+		const float AreaScale = std::pow(std::fabs(LocalToWorld.GetDeterminant()), 2.0f / 3.0f);
+		FHydrodynamicSum Hydrodynamics(Params, *Hull, AreaScale, SlammingFlux.data(), SlammingFrames.data(), HydrodynamicFrame);
+
+		if (Params.Model == EBuoyancyModel::DisplacedVolume)
+		{
+			for (int32_t i = 0; i < NumUnderWaterTriangles; i++)
+			{
+				FUnderWaterTriangle& Triangle = Output[i];
+				Triangle.UpdateDerivedData();
+				if (bHydrodynamics)
+				{
+					Hydrodynamics.Add(Sources[i], Triangle.Center, Triangle.Normal, Triangle.Area);
+				}
+			}
+
+			float Volume;
+			FVec3 CenterOfBuoyancy;
+			SumDisplacedVolume(Volume, CenterOfBuoyancy);
+			AddDisplacedVolume(OutWrench, Params.WaterDensity, Params.GravityZ, Volume, CenterOfBuoyancy, Params.CenterOfMass);
+		}
+		else
+		{
+			for (int32_t i = 0; i < NumUnderWaterTriangles; i++)
+			{
+				FUnderWaterTriangle& Triangle = Output[i];
+				Triangle.UpdateDerivedData();
+				OutWrench.Add(BuoyancyForce(Params.WaterDensity, Params.GravityZ, Triangle.DistanceToSurface, Triangle.Area, Triangle.Normal), Triangle.Center, Params.CenterOfMass);
+				if (bHydrodynamics)
+				{
+					Hydrodynamics.Add(Sources[i], Triangle.Center, Triangle.Normal, Triangle.Area);
+				}
+			}
+		}
+
+		Hydrodynamics.Flush();
+		HydrodynamicWrench = Hydrodynamics.GetWrench();
+		OutWrench.Force += Hydrodynamics.GetWrench().Force;
+		OutWrench.Torque += Hydrodynamics.GetWrench().Torque;
+	}
+
+	void FHullClipper::FinishTrianglesLocal(const FHullTransform& LocalToWorld, const FBuoyancyParams& Params, FBuoyancyWrench& OutWrench)
+	{
+		FClipStageScope StageScope(Profiler, EClipStage::Integrate);
+		//Drag depends on the world velocity of every triangle, so those that get it are brought into world space one by one.
+		//Normals are turned by the linear part over the uniform scale, areas grow with its square
+		const FVec3 Up(LocalToWorld.M[2][0], LocalToWorld.M[2][1], LocalToWorld.M[2][2]);
+		const float Scale = Up.Size();
+		const float InvScale = Scale > 0.0f ? 1.0f / Scale : 0.0f;
+		const bool bHydrodynamics = Params.Hydrodynamics.bEnabled;
+		const int32_t* Sources = UnderWaterSources.data();
+		AdvanceHydrodynamicFrame(Params);
+		FHydrodynamicSum Hydrodynamics(Params, *Hull, Scale * Scale, SlammingFlux.data(), SlammingFrames.data(), HydrodynamicFrame);
+
+		if (Params.Model == EBuoyancyModel::DisplacedVolume)
+		{
+			FUnderWaterTriangle* Triangles = UnderWaterTriangles.data();
+			for (int32_t i = 0; i < NumUnderWaterTriangles; i++)
+			{
+				FUnderWaterTriangle& Triangle = Triangles[i];
+				Triangle.UpdateDerivedData();
+				if (bHydrodynamics)
+				{
+					Hydrodynamics.Add(Sources[i], LocalToWorld.TransformPosition(Triangle.Center), LocalToWorld.TransformVector(Triangle.Normal) * InvScale, Triangle.Area * Scale * Scale);
+				}
+			}
+			Hydrodynamics.Flush();
+			HydrodynamicWrench = Hydrodynamics.GetWrench();
+
+			//Volumes scale with the determinant, the centroid just moves with the hull
+			float Volume;
+			FVec3 CenterOfBuoyancy;
+			SumDisplacedVolume(Volume, CenterOfBuoyancy);
+			OutWrench = Hydrodynamics.GetWrench();
+			AddDisplacedVolume(OutWrench, Params.WaterDensity, Params.GravityZ, Volume * LocalToWorld.GetDeterminant(), LocalToWorld.TransformPosition(CenterOfBuoyancy), Params.CenterOfMass);
+			return;
+		}
+
+		//BuoyancyForce only keeps the world Z part of each force. For rotation R and uniform scale S a triangle's world
+		//area times its normal's world Z is S * S * Area * Dot(Normal, R^T Up), and the third row of the matrix is S * R^T Up
+		const FVec3 ScaledUp = Up * Scale;
+
+		//The forces are all vertical so the torque only needs their sum and their sum weighted by where they act
+		float VerticalForce = 0.0f;
+		FVec3 Moment;
+		FUnderWaterTriangle* Output = UnderWaterTriangles.data();
+		for (int32_t i = 0; i < NumUnderWaterTriangles; i++)
+		{
+			FUnderWaterTriangle& Triangle = Output[i];
+			Triangle.UpdateDerivedData();
+			const float Force = Params.WaterDensity * Params.GravityZ * Triangle.DistanceToSurface * Triangle.Area * FVec3::Dot(Triangle.Normal, ScaledUp);
+			VerticalForce += Force;
+			Moment += Triangle.Center * Force;
+			if (bHydrodynamics)
+			{
+				Hydrodynamics.Add(Sources[i], LocalToWorld.TransformPosition(Triangle.Center), LocalToWorld.TransformVector(Triangle.Normal) * InvScale, Triangle.Area * Scale * Scale);
+			}
+		}
+		Hydrodynamics.Flush();
+		HydrodynamicWrench = Hydrodynamics.GetWrench();
+
+		//Sum of (World center - CenterOfMass) x (0, 0, Force) over every triangle
+		OutWrench = Hydrodynamics.GetWrench();
+		OutWrench.Force.Z += VerticalForce;
+		const FVec3 Lever = LocalToWorld.TransformVector(Moment) + (LocalToWorld.GetOrigin() - Params.CenterOfMass) * VerticalForce;
+		OutWrench.Torque += FVec3::Cross(Lever, FVec3(0.0f, 0.0f, 1.0f));
+	}
+}
@@ -0,0 +1,211 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HullOptimizer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace BuoyancyCore
+{
+	namespace
+	{
+		//Tuning of the vertex scores from Forsyth's paper
+		constexpr float CacheDecayPower = 1.5f;
+		constexpr float LastTriangleScore = 0.75f;
+		constexpr float ValenceBoostScale = 2.0f;
+		constexpr float ValenceBoostPower = 0.5f;
+
+		//How much emitting a triangle that uses this vertex is worth: more the more recently it was used,
+		//and more the fewer triangles are left to use it so lone vertices don't stay behind
+		float GetVertexScore(int32_t CachePosition, int32_t RemainingValence, int32_t CacheSize)
+		{
+			if (RemainingValence == 0)
+			{
+				return -1.0f;
+			}
+
+			float Score = 0.0f;
+			if (CachePosition >= 0)
+			{
+				//The corners of the last triangle all get the same score, whichever order they went in
+				Score = CachePosition < 3 ? LastTriangleScore : std::pow(1.0f - (float)(CachePosition - 3) / (float)(CacheSize - 3), CacheDecayPower);
+			}
+			return Score + ValenceBoostScale * std::pow((float)RemainingValence, -ValenceBoostPower);
+		}
+
+		//Reorders Indexes triangle by triangle, greedily emitting the best scored triangle around the simulated cache
+		void OrderTrianglesForVertexCache(std::vector<int32_t>& Indexes, int32_t NumVertices, int32_t CacheSize)
+		{
+			const int32_t NumTriangles = (int32_t)(Indexes.size() / 3);
+
+			//Triangles of every vertex, the ones not emitted yet first
+			std::vector<int32_t> AdjacencyStart(NumVertices + 1, 0);
+			for (const int32_t Index : Indexes)
+			{
+				AdjacencyStart[Index + 1]++;
+			}
+			for (int32_t Vertex = 0; Vertex < NumVertices; Vertex++)
+			{
+				AdjacencyStart[Vertex + 1] += AdjacencyStart[Vertex];
+			}
+			std::vector<int32_t> Adjacency(Indexes.size());
+			std::vector<int32_t> RemainingValence(NumVertices, 0);
+			for (int32_t Triangle = 0; Triangle < NumTriangles; Triangle++)
+			{
+				for (int32_t Corner = 0; Corner < 3; Corner++)
+				{
+					const int32_t Vertex = Indexes[Triangle * 3 + Corner];
+					Adjacency[AdjacencyStart[Vertex] + RemainingValence[Vertex]++] = Triangle;
+				}
+			}
+
+			std::vector<int32_t> CachePosition(NumVertices, -1);
+			std::vector<float> VertexScores(NumVertices);
+			for (int32_t Vertex = 0; Vertex < NumVertices; Vertex++)
+			{
+				VertexScores[Vertex] = GetVertexScore(-1, RemainingValence[Vertex], CacheSize);
+			}
+			std::vector<float> TriangleScores(NumTriangles);
+			int32_t BestTriangle = -1;
+			float BestScore = -1.0f;
+			for (int32_t Triangle = 0; Triangle < NumTriangles; Triangle++)
+			{
+				TriangleScores[Triangle] = VertexScores[Indexes[Triangle * 3 + 0]] + VertexScores[Indexes[Triangle * 3 + 1]] + VertexScores[Indexes[Triangle * 3 + 2]];
+				if (TriangleScores[Triangle] > BestScore)
+				{
+					BestScore = TriangleScores[Triangle];
+					BestTriangle = Triangle;
+				}
+			}
+
+			std::vector<uint8_t> Emitted(NumTriangles, 0);
+			std::vector<int32_t> Output;
+			Output.reserve(Indexes.size());
+			//The cache is a most recently used list, a triangle pushes its corners to the front and the rest back
+			std::vector<int32_t> Cache;
+			std::vector<int32_t> NewCache;
+			Cache.reserve(CacheSize + 3);
+			NewCache.reserve(CacheSize + 3);
+			int32_t NextUnemitted = 0;
+			for (int32_t NumEmitted = 0; NumEmitted < NumTriangles; NumEmitted++)
+			{
+				if (BestTriangle < 0)
+				{
+					//Nothing left around the cache, carry on with the next triangle in the old order
+					while (Emitted[NextUnemitted])
+					{
+						NextUnemitted++;
+					}
+					BestTriangle = NextUnemitted;
+				}
+
+				Emitted[BestTriangle] = 1;
+				NewCache.clear();
+				for (int32_t Corner = 0; Corner < 3; Corner++)
+				{
+					const int32_t Vertex = Indexes[BestTriangle * 3 + Corner];
+					Output.push_back(Vertex);
+					NewCache.push_back(Vertex);
+
+					//Moves the triangle behind the ones still to go
+					int32_t* const Triangles = Adjacency.data() + AdjacencyStart[Vertex];
+					const int32_t Last = --RemainingValence[Vertex];
+					std::swap(*std::find(Triangles, Triangles + Last + 1, BestTriangle), Triangles[Last]);
+				}
+				for (const int32_t Vertex : Cache)
+				{
+					if (Vertex != NewCache[0] && Vertex != NewCache[1] && Vertex != NewCache[2])
+					{
+						NewCache.push_back(Vertex);
+					}
+				}
+
+				//Rescore everything that was or is in the cache, and the triangles around it
+				BestTriangle = -1;
+				BestScore = -1.0f;
+				for (int32_t Position = 0; Position < (int32_t)NewCache.size(); Position++)
+				{
+					const int32_t Vertex = NewCache[Position];
+					CachePosition[Vertex] = Position < CacheSize ? Position : -1;
+					VertexScores[Vertex] = GetVertexScore(CachePosition[Vertex], RemainingValence[Vertex], CacheSize);
+				}
+				for (const int32_t Vertex : NewCache)
+				{
+					const int32_t* const Triangles = Adjacency.data() + AdjacencyStart[Vertex];
+					for (int32_t i = 0; i < RemainingValence[Vertex]; i++)
+					{
+						const int32_t Triangle = Triangles[i];
+						TriangleScores[Triangle] = VertexScores[Indexes[Triangle * 3 + 0]] + VertexScores[Indexes[Triangle * 3 + 1]] + VertexScores[Indexes[Triangle * 3 + 2]];
+						if (TriangleScores[Triangle] > BestScore)
+						{
+							BestScore = TriangleScores[Triangle];
+							BestTriangle = Triangle;
+						}
+					}
+				}
+
+				NewCache.resize(std::min((int32_t)NewCache.size(), CacheSize));
+				std::swap(Cache, NewCache);
+			}
+
+			Indexes.swap(Output);
+		}
+	}
+
+	void OptimizeHull(const FHullMesh& Source, const FHullOptimizeSettings& Settings, FHullMesh& OutMesh, FHullOptimizeReport& OutReport)
+	{
+		OutReport = FHullOptimizeReport();
+		OutReport.GatherMissesBefore = CountGatherMisses(Source.Indexes, (int32_t)Source.Vertices.size());
+
+		FHullMesh Welded;
+		WeldHullVertices(Source, Settings.WeldDistance, Welded);
+		OutReport.NumDuplicateVertices = (int32_t)(Source.Vertices.size() - Welded.Vertices.size());
+		OutReport.NumDegenerateTriangles = Source.GetNumTriangles() - Welded.GetNumTriangles();
+
+		const int32_t CacheSize = std::max(Settings.VertexCacheSize, 4);
+		OrderTrianglesForVertexCache(Welded.Indexes, (int32_t)Welded.Vertices.size(), CacheSize);
+
+		//Vertices in the order the triangles first use them, so the gathers walk forward through the streams
+		std::vector<int32_t> Remap(Welded.Vertices.size(), -1);
+		OutMesh.Vertices.clear();
+		OutMesh.Vertices.reserve(Welded.Vertices.size());
+		OutMesh.Indexes.resize(Welded.Indexes.size());
+		for (size_t i = 0; i < Welded.Indexes.size(); i++)
+		{
+			int32_t& NewIndex = Remap[Welded.Indexes[i]];
+			if (NewIndex < 0)
+			{
+				NewIndex = (int32_t)OutMesh.Vertices.size();
+				OutMesh.Vertices.push_back(Welded.Vertices[Welded.Indexes[i]]);
+			}
+			OutMesh.Indexes[i] = NewIndex;
+		}
+		OutReport.NumUnusedVertices = (int32_t)(Welded.Vertices.size() - OutMesh.Vertices.size());
+		OutReport.GatherMissesAfter = CountGatherMisses(OutMesh.Indexes, (int32_t)OutMesh.Vertices.size());
+	}
+
+	int64_t CountGatherMisses(const std::vector<int32_t>& Indexes, int32_t NumVertices, int32_t CacheLines)
+	{
+		constexpr int32_t FloatsPerLine = 64 / sizeof(float);
+		std::vector<uint8_t> InCache((NumVertices + FloatsPerLine - 1) / FloatsPerLine, 0);
+		std::vector<int32_t> Lines(std::max(CacheLines, 1), -1);
+		size_t Oldest = 0;
+		int64_t Misses = 0;
+		for (const int32_t Index : Indexes)
+		{
+			const int32_t Line = Index / FloatsPerLine;
+			if (InCache[Line])
+			{
+				continue;
+			}
+			Misses++;
+			if (Lines[Oldest] >= 0)
+			{
+				InCache[Lines[Oldest]] = 0;
+			}
+			Lines[Oldest] = Line;
+			InCache[Line] = 1;
+			Oldest = (Oldest + 1) % Lines.size();
+		}
+		return Misses;
+	}
+}
@@ -0,0 +1,318 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HullPontoons.h"
+#include "HullClipper.h"
+#include <algorithm>
+#include <cmath>
+
+namespace BuoyancyCore
+{
+	namespace
+	{
+		//Where a column's ray crosses the hull, Direction is +1 going in and -1 coming out
+		struct FRayCrossing
+		{
+			float Z;
+			int32_t Direction;
+
+			bool operator<(const FRayCrossing& Other) const { return Z < Other.Z; }
+		};
+
+		//Twice the signed area of A, B, P in the XY plane
+		inline float EdgeFunction(const FVec3& A, const FVec3& B, float PX, float PY)
+		{
+			return (B.X - A.X) * (PY - A.Y) - (B.Y - A.Y) * (PX - A.X);
+		}
+
+		//Rotation by Pitch about Y after Roll about X, like the bench's bobbing hull, about the local point Center which ends up at (0, 0, Height)
+		FHullTransform MakePose(float Pitch, float Roll, const FVec3& Center, float Height)
+		{
+			const float CR = std::cos(Roll), SR = std::sin(Roll);
+			const float CP = std::cos(Pitch), SP = std::sin(Pitch);
+
+			FHullTransform Transform;
+			Transform.M[0][0] = CP;   Transform.M[0][1] = SP * SR; Transform.M[0][2] = SP * CR;
+			Transform.M[1][0] = 0.0f; Transform.M[1][1] = CR;      Transform.M[1][2] = -SR;
+			Transform.M[2][0] = -SP;  Transform.M[2][1] = CP * SR; Transform.M[2][2] = CP * CR;
+			const FVec3 Rotated = Transform.TransformVector(Center);
+			Transform.M[0][3] = -Rotated.X;
+			Transform.M[1][3] = -Rotated.Y;
+			Transform.M[2][3] = Height - Rotated.Z;
+			return Transform;
+		}
+	}
+
+	size_t FHullPontoons::GetAllocatedSize() const
+	{
+		return (Positions.X.capacity() + Positions.Y.capacity() + Positions.Z.capacity() + Volumes.capacity() + HalfHeights.capacity()) * sizeof(float);
+	}
+
+	std::shared_ptr<const FHullPontoons> FHullPontoons::Build(const FHullTopology& Hull, const FPontoonSettings& Settings)
+	{
+		std::shared_ptr<FHullPontoons> Pontoons = std::make_shared<FHullPontoons>();
+		const FVec3 Extent = Hull.BoundsMax - Hull.BoundsMin;
+		const float Longest = std::fmax(Extent.X, std::fmax(Extent.Y, Extent.Z));
+		if (Hull.GetNumTriangles() == 0 || Longest <= 0.0f || Hull.Volume == 0.0f)
+		{
+			return Pontoons;
+		}
+
+		//Cubes centered on the hull's box, the short sides get one more cube only when they are noticeably longer than a whole number of them
+		const float CellSize = Longest / (float)std::max(Settings.Resolution, 1);
+		const int32_t NumX = std::max(1, (int32_t)std::ceil(Extent.X / CellSize - 0.01f));
+		const int32_t NumY = std::max(1, (int32_t)std::ceil(Extent.Y / CellSize - 0.01f));
+		const int32_t NumZ = std::max(1, (int32_t)std::ceil(Extent.Z / CellSize - 0.01f));
+		const FVec3 Origin = (Hull.BoundsMin + Hull.BoundsMax) * 0.5f - FVec3((float)NumX, (float)NumY, (float)NumZ) * (CellSize * 0.5f);
+		Pontoons->CellSize = CellSize;
+
+		//Rays go up through the column centers, moved off them by a small odd fraction of a cell so they don't run exactly
+		//through the edges and vertices of meshes built on a grid and count a crossing twice
+		const float RayOffsetX = CellSize * 0.01234f;
+		const float RayOffsetY = CellSize * 0.00718f;
+		//The triangles face out when the volume is positive
+		const float Orientation = Hull.Volume > 0.0f ? 1.0f : -1.0f;
+		std::vector<std::vector<FRayCrossing>> Columns(NumX * NumY);
+		for (int32_t Triangle = 0; Triangle < Hull.GetNumTriangles(); Triangle++)
+		{
+			const FVec3 P0 = Hull.Vertices.Get(Hull.Triangles[Triangle * 3 + 0]);
+			const FVec3 P1 = Hull.Vertices.Get(Hull.Triangles[Triangle * 3 + 1]);
+			const FVec3 P2 = Hull.Vertices.Get(Hull.Triangles[Triangle * 3 + 2]);
+			const float DoubleArea = EdgeFunction(P0, P1, P2.X, P2.Y);
+			if (DoubleArea == 0.0f)
+			{
+				//Vertical, a vertical ray can't cross it
+				continue;
+			}
+
+			//Only the columns whose ray is inside the triangle's XY box
+			const float MinX = std::fmin(P0.X, std::fmin(P1.X, P2.X));
+			const float MaxX = std::fmax(P0.X, std::fmax(P1.X, P2.X));
+			const float MinY = std::fmin(P0.Y, std::fmin(P1.Y, P2.Y));
+			const float MaxY = std::fmax(P0.Y, std::fmax(P1.Y, P2.Y));
+			const int32_t BeginX = std::max(0, (int32_t)std::ceil((MinX - Origin.X - RayOffsetX) / CellSize - 0.5f));
+			const int32_t EndX = std::min(NumX - 1, (int32_t)std::floor((MaxX - Origin.X - RayOffsetX) / CellSize - 0.5f));
+			const int32_t BeginY = std::max(0, (int32_t)std::ceil((MinY - Origin.Y - RayOffsetY) / CellSize - 0.5f));
+			const int32_t EndY = std::min(NumY - 1, (int32_t)std::floor((MaxY - Origin.Y - RayOffsetY) / CellSize - 0.5f));
+
+			//A triangle whose outward normal points down is where an upward ray goes in
+			const int32_t Direction = DoubleArea * Orientation < 0.0f ? 1 : -1;
+			for (int32_t Y = BeginY; Y <= EndY; Y++)
+			{
+				const float RayY = Origin.Y + ((float)Y + 0.5f) * CellSize + RayOffsetY;
+				for (int32_t X = BeginX; X <= EndX; X++)
+				{
+					const float RayX = Origin.X + ((float)X + 0.5f) * CellSize + RayOffsetX;
+					//Barycentric coordinates, all of them with the sign of the area when the ray is inside
+					const float W0 = EdgeFunction(P1, P2, RayX, RayY) / DoubleArea;
+					const float W1 = EdgeFunction(P2, P0, RayX, RayY) / DoubleArea;
+					const float W2 = 1.0f - W0 - W1;
+					if (W0 < 0.0f || W1 < 0.0f || W2 < 0.0f)
+					{
+						continue;
+					}
+					Columns[Y * NumX + X].push_back(FRayCrossing{ W0 * P0.Z + W1 * P1.Z + W2 * P2.Z, Direction });
+				}
+			}
+		}
+
+		//The inside spans of every column, cut up by the cells along it
+		std::vector<FVec3> Positions;
+		std::vector<std::pair<float, float>> Spans;
+		double TotalVolume = 0.0;
+		for (int32_t Y = 0; Y < NumY; Y++)
+		{
+			for (int32_t X = 0; X < NumX; X++)
+			{
+				std::vector<FRayCrossing>& Crossings = Columns[Y * NumX + X];
+				std::sort(Crossings.begin(), Crossings.end());
+				Spans.clear();
+				int32_t Depth = 0;
+				float SpanBegin = 0.0f;
+				for (const FRayCrossing& Crossing : Crossings)
+				{
+					const int32_t NewDepth = Depth + Crossing.Direction;
+					if (Depth <= 0 && NewDepth > 0)
+					{
+						SpanBegin = Crossing.Z;
+					}
+					else if (Depth > 0 && NewDepth <= 0)
+					{
+						Spans.push_back(std::make_pair(SpanBegin, Crossing.Z));
+					}
+					Depth = NewDepth;
+				}
+
+				for (int32_t Z = 0; Z < NumZ; Z++)
+				{
+					const float CellBottom = Origin.Z + (float)Z * CellSize;
+					const float CellTop = CellBottom + CellSize;
+					float Length = 0.0f;
+					float Moment = 0.0f;
+					for (const std::pair<float, float>& Span : Spans)
+					{
+						const float Bottom = std::fmax(Span.first, CellBottom);
+						const float Top = std::fmin(Span.second, CellTop);
+						if (Top > Bottom)
+						{
+							Length += Top - Bottom;
+							Moment += (Top - Bottom) * (Top + Bottom) * 0.5f;
+						}
+					}
+					//Slivers are left out, the volumes are scaled to the hull's below anyway
+					if (Length < CellSize * 0.01f)
+					{
+						continue;
+					}
+					Positions.push_back(FVec3(Origin.X + ((float)X + 0.5f) * CellSize, Origin.Y + ((float)Y + 0.5f) * CellSize, Moment / Length));
+					Pontoons->Volumes.push_back(CellSize * CellSize * Length);
+					Pontoons->HalfHeights.push_back(Length * 0.5f);
+					TotalVolume += CellSize * CellSize * Length;
+				}
+			}
+		}
+
+		//The rays only see the middle of every column, a submerged hull has to displace exactly its volume. Signed like it,
+		//so a hull wound inside out pushes the same way as when it is clipped
+		const float VolumeScale = TotalVolume > 0.0 ? (float)(Hull.Volume / TotalVolume) : 0.0f;
+		for (float& Volume : Pontoons->Volumes)
+		{
+			Volume *= VolumeScale;
+		}
+		Pontoons->Positions.SetNum((int32_t)Positions.size());
+		for (int32_t i = 0; i < (int32_t)Positions.size(); i++)
+		{
+			Pontoons->Positions.Set(i, Positions[i]);
+		}
+		return Pontoons;
+	}
+
+	void FPontoonSolver::SetPontoons(std::shared_ptr<const FHullPontoons> InPontoons)
+	{
+		Pontoons = std::move(InPontoons);
+		const int32_t Num = Pontoons ? Pontoons->GetNum() : 0;
+		WorldPositions.SetNum(Num);
+		Heights.assign(WorldPositions.GetPaddedNum(), 0.0f);
+		WaterHeights.assign(WorldPositions.GetPaddedNum(), 0.0f);
+	}
+
+	void FPontoonSolver::SetWaterSurface(const IWaterSurface* Surface, float Time)
+	{
+		WaterSurface = Surface;
+		WaterTime = Time;
+	}
+
+	void FPontoonSolver::ComputeForces(const FHullTransform& LocalToWorld, const FBuoyancyParams& Params, FBuoyancyWrench& OutWrench)
+	{
+		OutWrench = FBuoyancyWrench();
+		if (!Pontoons || Pontoons->GetNum() == 0)
+		{
+			return;
+		}
+
+		{
+			//Same vectorized transform as the hull vertices, then one query for every pontoon
+			FClipStageScope StageScope(Profiler, EClipStage::Transform);
+			TransformVerticesAndDistances(LocalToWorld, Pontoons->Positions, 0.0f, WorldPositions, Heights.data());
+			if (WaterSurface)
+			{
+				const int32_t PaddedNum = WorldPositions.GetPaddedNum();
+				WaterSurface->GetHeights(WorldPositions.X.data(), WorldPositions.Y.data(), PaddedNum, WaterTime, WaterHeights.data());
+				for (int32_t i = 0; i < PaddedNum; i++)
+				{
+					Heights[i] -= WaterHeights[i];
+				}
+			}
+		}
+
+		FClipStageScope StageScope(Profiler, EClipStage::Integrate);
+		//World height of a voxel part is the box projected on the up axis, the width and depth part is the same for all of them
+		const float HalfCellHeight = (std::fabs(LocalToWorld.M[2][0]) + std::fabs(LocalToWorld.M[2][1])) * Pontoons->CellSize * 0.5f;
+		const float AbsUpZ = std::fabs(LocalToWorld.M[2][2]);
+		const float VolumeScale = LocalToWorld.GetDeterminant();
+		const float* Volumes = Pontoons->Volumes.data();
+		const float* HalfHeights = Pontoons->HalfHeights.data();
+
+		//Every force is vertical, so like FinishTrianglesLocal only their sum and their sum weighted by where they act are needed
+		float Displaced = 0.0f;
+		FVec3 Moment;
+		for (int32_t i = 0; i < Pontoons->GetNum(); i++)
+		{
+			const float Height = Heights[i];
+			const float HalfHeight = HalfCellHeight + AbsUpZ * HalfHeights[i];
+			const float Bottom = Height - HalfHeight;
+			const float Top = std::fmin(Height + HalfHeight, 0.0f);
+			if (Top <= Bottom)
+			{
+				continue;
+			}
+
+			//The wet part is the bottom of the voxel, it pushes at its own center
+			const float Volume = Volumes[i] * (Top - Bottom) / (2.0f * HalfHeight);
+			const FVec3 Center(WorldPositions.X[i], WorldPositions.Y[i], WorldPositions.Z[i] + (Bottom + Top) * 0.5f - Height);
+			Displaced += Volume;
+			Moment += Center * Volume;
+		}
+
+		const float VerticalForce = -Params.WaterDensity * Params.GravityZ * Displaced * VolumeScale;
+		OutWrench.Force.Z = VerticalForce;
+		OutWrench.Torque = FVec3::Cross((Moment * VolumeScale * -Params.WaterDensity * Params.GravityZ) - Params.CenterOfMass * VerticalForce, FVec3(0.0f, 0.0f, 1.0f));
+	}
+
+	void ComparePontoons(const std::shared_ptr<const FHullTopology>& Hull, const std::shared_ptr<const FHullPontoons>& Pontoons, FPontoonErrorReport& OutReport)
+	{
+		OutReport = FPontoonErrorReport();
+		if (!Hull || !Pontoons)
+		{
+			return;
+		}
+		FBuoyancyParams Params;
+		Params.Model = EBuoyancyModel::DisplacedVolume;
+		const float Weight = std::fabs(Params.WaterDensity * Params.GravityZ * Hull->Volume);
+		if (Weight <= 0.0f || Hull->BoundingRadius <= 0.0f)
+		{
+			return;
+		}
+
+		FHullClipper Clipper;
+		Clipper.SetHull(Hull);
+		FPontoonSolver Solver;
+		Solver.SetPontoons(Pontoons);
+
+		//From barely wet to just under, upright and tilted both ways
+		const float Angles[] = { 0.0f, 0.1f, -0.25f };
+		const int32_t NumDrafts = 7;
+		const FVec3 Center = (Hull->BoundsMin + Hull->BoundsMax) * 0.5f;
+		const FVec3 HalfExtent = (Hull->BoundsMax - Hull->BoundsMin) * 0.5f;
+		double SumForceError = 0.0;
+		double SumTorqueError = 0.0;
+		for (const float Pitch : Angles)
+		{
+			for (const float Roll : Angles)
+			{
+				const FHullTransform Upright = MakePose(Pitch, Roll, Center, 0.0f);
+				const float HalfHeight = std::fabs(Upright.M[2][0]) * HalfExtent.X + std::fabs(Upright.M[2][1]) * HalfExtent.Y + std::fabs(Upright.M[2][2]) * HalfExtent.Z;
+				for (int32_t Draft = 0; Draft < NumDrafts; Draft++)
+				{
+					const float Height = HalfHeight * (0.9f - 2.0f * (float)Draft / (float)(NumDrafts - 1));
+					const FHullTransform Pose = MakePose(Pitch, Roll, Center, Height);
+					Params.CenterOfMass = FVec3(0.0f, 0.0f, Height);
+
+					FBuoyancyWrench Clipped;
+					FBuoyancyWrench Sampled;
+					Clipper.GenerateUnderWaterMesh(Pose, Params, Clipped);
+					Solver.ComputeForces(Pose, Params, Sampled);
+
+					const float ForceError = (Clipped.Force - Sampled.Force).Size() / Weight;
+					const float TorqueError = (Clipped.Torque - Sampled.Torque).Size() / (Weight * Hull->BoundingRadius);
+					OutReport.MaxForceError = std::fmax(OutReport.MaxForceError, ForceError);
+					OutReport.MaxTorqueError = std::fmax(OutReport.MaxTorqueError, TorqueError);
+					SumForceError += ForceError;
+					SumTorqueError += TorqueError;
+					OutReport.NumPoses++;
+				}
+			}
+		}
+		OutReport.MeanForceError = (float)(SumForceError / OutReport.NumPoses);
+		OutReport.MeanTorqueError = (float)(SumTorqueError / OutReport.NumPoses);
+	}
+}
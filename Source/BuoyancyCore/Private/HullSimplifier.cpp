@@ -0,0 +1,603 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HullSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <unordered_map>
+
+namespace BuoyancyCore
+{
+	namespace
+	{
+		struct FDoubleVec
+		{
+			double X = 0.0, Y = 0.0, Z = 0.0;
+
+			FDoubleVec() {}
+			FDoubleVec(double InX, double InY, double InZ) : X(InX), Y(InY), Z(InZ) {}
+			explicit FDoubleVec(const FVec3& V) : X(V.X), Y(V.Y), Z(V.Z) {}
+
+			FDoubleVec operator+(const FDoubleVec& O) const { return FDoubleVec(X + O.X, Y + O.Y, Z + O.Z); }
+			FDoubleVec operator-(const FDoubleVec& O) const { return FDoubleVec(X - O.X, Y - O.Y, Z - O.Z); }
+			FDoubleVec operator*(double S) const { return FDoubleVec(X * S, Y * S, Z * S); }
+			double Dot(const FDoubleVec& O) const { return X * O.X + Y * O.Y + Z * O.Z; }
+			FDoubleVec Cross(const FDoubleVec& O) const { return FDoubleVec(Y * O.Z - Z * O.Y, Z * O.X - X * O.Z, X * O.Y - Y * O.X); }
+			double Size() const { return std::sqrt(Dot(*this)); }
+			FVec3 ToFloat() const { return FVec3((float)X, (float)Y, (float)Z); }
+		};
+
+		//Signed volume of the tetrahedron to the origin and its first moment, summed over a closed mesh they give volume and centroid
+		inline void TetraContribution(const FDoubleVec& P0, const FDoubleVec& P1, const FDoubleVec& P2, double& OutVolume, FDoubleVec& OutMoment)
+		{
+			OutVolume = P0.Dot(P1.Cross(P2)) / 6.0;
+			OutMoment = (P0 + P1 + P2) * (OutVolume / 4.0);
+		}
+
+		//Symmetric 4x4 error quadric, the sum of squared distances to a set of planes
+		struct FQuadric
+		{
+			//a2 ab ac ad b2 bc bd c2 cd d2
+			double Q[10] = {};
+
+			static FQuadric FromPlane(const FDoubleVec& Normal, double D, double Weight)
+			{
+				FQuadric Result;
+				const double A = Normal.X, B = Normal.Y, C = Normal.Z;
+				Result.Q[0] = A * A * Weight; Result.Q[1] = A * B * Weight; Result.Q[2] = A * C * Weight; Result.Q[3] = A * D * Weight;
+				Result.Q[4] = B * B * Weight; Result.Q[5] = B * C * Weight; Result.Q[6] = B * D * Weight;
+				Result.Q[7] = C * C * Weight; Result.Q[8] = C * D * Weight;
+				Result.Q[9] = D * D * Weight;
+				return Result;
+			}
+
+			FQuadric& operator+=(const FQuadric& O)
+			{
+				for (int32_t i = 0; i < 10; i++)
+				{
+					Q[i] += O.Q[i];
+				}
+				return *this;
+			}
+
+			double Evaluate(const FDoubleVec& P) const
+			{
+				return Q[0] * P.X * P.X + 2.0 * Q[1] * P.X * P.Y + 2.0 * Q[2] * P.X * P.Z + 2.0 * Q[3] * P.X
+					+ Q[4] * P.Y * P.Y + 2.0 * Q[5] * P.Y * P.Z + 2.0 * Q[6] * P.Y
+					+ Q[7] * P.Z * P.Z + 2.0 * Q[8] * P.Z
+					+ Q[9];
+			}
+
+			//Point with the least error, false when the system is close to singular (flat or straight neighbourhoods)
+			bool FindOptimal(FDoubleVec& Out) const
+			{
+				const double A00 = Q[0], A01 = Q[1], A02 = Q[2];
+				const double A11 = Q[4], A12 = Q[5], A22 = Q[7];
+				const double Det = A00 * (A11 * A22 - A12 * A12) - A01 * (A01 * A22 - A12 * A02) + A02 * (A01 * A12 - A11 * A02);
+				const double Scale = std::fabs(A00) + std::fabs(A11) + std::fabs(A22);
+				if (std::fabs(Det) <= 1e-10 * Scale * Scale * Scale || Scale == 0.0)
+				{
+					return false;
+				}
+
+				//Cramer's rule on A * x = -b
+				const double B0 = -Q[3], B1 = -Q[6], B2 = -Q[8];
+				Out.X = (B0 * (A11 * A22 - A12 * A12) - A01 * (B1 * A22 - A12 * B2) + A02 * (B1 * A12 - A11 * B2)) / Det;
+				Out.Y = (A00 * (B1 * A22 - A12 * B2) - B0 * (A01 * A22 - A12 * A02) + A02 * (A01 * B2 - B1 * A02)) / Det;
+				Out.Z = (A00 * (A11 * B2 - B1 * A12) - A01 * (A01 * B2 - B1 * A02) + B0 * (A01 * A12 - A11 * A02)) / Det;
+				return true;
+			}
+		};
+
+		struct FCollapse
+		{
+			double Cost;
+			int32_t Keep;
+			int32_t Remove;
+			//Vertex stamps when this was queued, a collapse is stale once either vertex has changed
+			uint32_t KeepStamp;
+			uint32_t RemoveStamp;
+			FDoubleVec Target;
+
+			//Cheapest on top of std::priority_queue
+			bool operator<(const FCollapse& O) const { return Cost > O.Cost; }
+		};
+
+		struct FWeldKey
+		{
+			int64_t X, Y, Z;
+			bool operator==(const FWeldKey& O) const { return X == O.X && Y == O.Y && Z == O.Z; }
+		};
+
+		struct FWeldKeyHash
+		{
+			size_t operator()(const FWeldKey& Key) const
+			{
+				return (size_t)(Key.X * 73856093 ^ Key.Y * 19349663 ^ Key.Z * 83492791);
+			}
+		};
+
+		class FSimplifier
+		{
+		public:
+			FSimplifier(const FHullMesh& Source, const FHullSimplifySettings& InSettings)
+				: Settings(InSettings)
+			{
+				Weld(Source);
+				BuildAdjacency();
+				BuildQuadrics();
+
+				for (int32_t Face = 0; Face < (int32_t)Faces.size(); Face++)
+				{
+					double Volume;
+					FDoubleVec Moment;
+					TetraContribution(P[Faces[Face].V[0]], P[Faces[Face].V[1]], P[Faces[Face].V[2]], Volume, Moment);
+					TotalVolume += Volume;
+					TotalMoment = TotalMoment + Moment;
+				}
+				SourceVolume = TotalVolume;
+				SourceCentroid = SourceVolume != 0.0 ? TotalMoment * (1.0 / SourceVolume) : FDoubleVec();
+
+				FDoubleVec Min(1e30, 1e30, 1e30), Max(-1e30, -1e30, -1e30);
+				for (const FDoubleVec& V : P)
+				{
+					Min = FDoubleVec(std::min(Min.X, V.X), std::min(Min.Y, V.Y), std::min(Min.Z, V.Z));
+					Max = FDoubleVec(std::max(Max.X, V.X), std::max(Max.Y, V.Y), std::max(Max.Z, V.Z));
+				}
+				Diagonal = P.empty() ? 1.0 : std::max((Max - Min).Size(), 1e-6);
+			}
+
+			void Run(FHullSimplifyResult& OutResult)
+			{
+				for (int32_t Face = 0; Face < (int32_t)Faces.size(); Face++)
+				{
+					for (int32_t Corner = 0; Corner < 3; Corner++)
+					{
+						const int32_t A = Faces[Face].V[Corner];
+						const int32_t B = Faces[Face].V[(Corner + 1) % 3];
+						//Every interior edge is in two faces, queue it once
+						if (A < B || IsBoundaryEdge(A, B))
+						{
+							QueueCollapse(A, B);
+						}
+					}
+				}
+
+				while (NumLiveFaces > Settings.TargetTriangles && !Heap.empty())
+				{
+					const FCollapse Collapse = Heap.top();
+					Heap.pop();
+					if (Removed[Collapse.Keep] || Removed[Collapse.Remove] || Stamps[Collapse.Keep] != Collapse.KeepStamp || Stamps[Collapse.Remove] != Collapse.RemoveStamp)
+					{
+						continue;
+					}
+					TryCollapse(Collapse);
+				}
+
+				WriteResult(OutResult);
+			}
+
+		private:
+			struct FFace
+			{
+				int32_t V[3];
+				bool bRemoved;
+			};
+
+			FHullSimplifySettings Settings;
+			std::vector<FDoubleVec> P;
+			std::vector<FQuadric> Quadrics;
+			std::vector<uint32_t> Stamps;
+			std::vector<bool> Removed;
+			std::vector<FFace> Faces;
+			std::vector<std::vector<int32_t>> VertexFaces;
+			std::priority_queue<FCollapse> Heap;
+			int32_t NumLiveFaces = 0;
+
+			double TotalVolume = 0.0;
+			FDoubleVec TotalMoment;
+			double SourceVolume = 0.0;
+			FDoubleVec SourceCentroid;
+			double Diagonal = 1.0;
+
+			void Weld(const FHullMesh& Source)
+			{
+				FHullMesh Welded;
+				WeldHullVertices(Source, Settings.WeldDistance, Welded);
+
+				P.reserve(Welded.Vertices.size());
+				for (const FVec3& V : Welded.Vertices)
+				{
+					P.push_back(FDoubleVec(V));
+				}
+				Faces.reserve(Welded.GetNumTriangles());
+				for (size_t i = 0; i + 2 < Welded.Indexes.size(); i += 3)
+				{
+					Faces.push_back(FFace{ { Welded.Indexes[i + 0], Welded.Indexes[i + 1], Welded.Indexes[i + 2] }, false });
+				}
+				NumLiveFaces = (int32_t)Faces.size();
+
+				Stamps.assign(P.size(), 0);
+				Removed.assign(P.size(), false);
+			}
+
+			void BuildAdjacency()
+			{
+				VertexFaces.assign(P.size(), std::vector<int32_t>());
+				for (int32_t Face = 0; Face < (int32_t)Faces.size(); Face++)
+				{
+					for (int32_t Corner = 0; Corner < 3; Corner++)
+					{
+						VertexFaces[Faces[Face].V[Corner]].push_back(Face);
+					}
+				}
+			}
+
+			FDoubleVec FaceNormal(int32_t Face, int32_t Moved = -1, const FDoubleVec& MovedTo = FDoubleVec()) const
+			{
+				const int32_t* V = Faces[Face].V;
+				const FDoubleVec P0 = V[0] == Moved ? MovedTo : P[V[0]];
+				const FDoubleVec P1 = V[1] == Moved ? MovedTo : P[V[1]];
+				const FDoubleVec P2 = V[2] == Moved ? MovedTo : P[V[2]];
+				return (P1 - P0).Cross(P2 - P0);
+			}
+
+			bool IsBoundaryEdge(int32_t A, int32_t B) const
+			{
+				int32_t Shared = 0;
+				for (int32_t Face : VertexFaces[A])
+				{
+					if (!Faces[Face].bRemoved && (Faces[Face].V[0] == B || Faces[Face].V[1] == B || Faces[Face].V[2] == B))
+					{
+						Shared++;
+					}
+				}
+				return Shared == 1;
+			}
+
+			void BuildQuadrics()
+			{
+				Quadrics.assign(P.size(), FQuadric());
+				for (int32_t Face = 0; Face < (int32_t)Faces.size(); Face++)
+				{
+					const FDoubleVec Cross = FaceNormal(Face);
+					const double DoubleArea = Cross.Size();
+					if (DoubleArea <= 0.0)
+					{
+						continue;
+					}
+					const FDoubleVec Normal = Cross * (1.0 / DoubleArea);
+					//Area weighted so big flat panels hold their shape better than small details
+					const FQuadric Plane = FQuadric::FromPlane(Normal, -Normal.Dot(P[Faces[Face].V[0]]), DoubleArea * 0.5);
+					for (int32_t Corner = 0; Corner < 3; Corner++)
+					{
+						Quadrics[Faces[Face].V[Corner]] += Plane;
+					}
+
+					//Open edges get a perpendicular plane so the border stays where it is
+					for (int32_t Corner = 0; Corner < 3; Corner++)
+					{
+						const int32_t A = Faces[Face].V[Corner];
+						const int32_t B = Faces[Face].V[(Corner + 1) % 3];
+						if (IsBoundaryEdge(A, B))
+						{
+							const FDoubleVec Edge = P[B] - P[A];
+							FDoubleVec Side = Edge.Cross(Normal);
+							const double SideSize = Side.Size();
+							if (SideSize > 0.0)
+							{
+								Side = Side * (1.0 / SideSize);
+								const FQuadric Border = FQuadric::FromPlane(Side, -Side.Dot(P[A]), Edge.Dot(Edge) * 10.0);
+								Quadrics[A] += Border;
+								Quadrics[B] += Border;
+							}
+						}
+					}
+				}
+			}
+
+			void QueueCollapse(int32_t A, int32_t B)
+			{
+				FQuadric Sum = Quadrics[A];
+				Sum += Quadrics[B];
+
+				//The optimal point if there is one, otherwise the best of the two ends and the middle
+				FDoubleVec Target;
+				double Cost;
+				if (Sum.FindOptimal(Target))
+				{
+					Cost = Sum.Evaluate(Target);
+				}
+				else
+				{
+					const FDoubleVec Candidates[3] = { P[A], P[B], (P[A] + P[B]) * 0.5 };
+					Target = Candidates[0];
+					Cost = Sum.Evaluate(Candidates[0]);
+					for (int32_t i = 1; i < 3; i++)
+					{
+						const double CandidateCost = Sum.Evaluate(Candidates[i]);
+						if (CandidateCost < Cost)
+						{
+							Cost = CandidateCost;
+							Target = Candidates[i];
+						}
+					}
+				}
+
+				Heap.push(FCollapse{ std::max(Cost, 0.0), A, B, Stamps[A], Stamps[B], Target });
+			}
+
+			void TryCollapse(const FCollapse& Collapse)
+			{
+				const int32_t Keep = Collapse.Keep;
+				const int32_t Remove = Collapse.Remove;
+
+				//Link condition: an interior edge may share exactly 2 neighbours, more would pinch the surface
+				std::vector<int32_t> KeepNeighbours;
+				for (int32_t Face : VertexFaces[Keep])
+				{
+					if (!Faces[Face].bRemoved)
+					{
+						for (int32_t Corner = 0; Corner < 3; Corner++)
+						{
+							KeepNeighbours.push_back(Faces[Face].V[Corner]);
+						}
+					}
+				}
+				std::sort(KeepNeighbours.begin(), KeepNeighbours.end());
+				KeepNeighbours.erase(std::unique(KeepNeighbours.begin(), KeepNeighbours.end()), KeepNeighbours.end());
+
+				std::vector<int32_t> Shared;
+				for (int32_t Face : VertexFaces[Remove])
+				{
+					if (Faces[Face].bRemoved)
+					{
+						continue;
+					}
+					for (int32_t Corner = 0; Corner < 3; Corner++)
+					{
+						const int32_t V = Faces[Face].V[Corner];
+						if (V != Keep && V != Remove && std::binary_search(KeepNeighbours.begin(), KeepNeighbours.end(), V))
+						{
+							Shared.push_back(V);
+						}
+					}
+				}
+				std::sort(Shared.begin(), Shared.end());
+				Shared.erase(std::unique(Shared.begin(), Shared.end()), Shared.end());
+				if (Shared.size() > 2)
+				{
+					return;
+				}
+
+				//No triangle that survives may flip or collapse, and the volume and centroid must stay in bounds
+				double NewVolume = TotalVolume;
+				FDoubleVec NewMoment = TotalMoment;
+				int32_t NumDying = 0;
+				const int32_t Ends[2] = { Keep, Remove };
+				for (int32_t End : Ends)
+				{
+					for (int32_t Face : VertexFaces[End])
+					{
+						const FFace& F = Faces[Face];
+						if (F.bRemoved)
+						{
+							continue;
+						}
+						const bool bHasKeep = F.V[0] == Keep || F.V[1] == Keep || F.V[2] == Keep;
+						const bool bHasRemove = F.V[0] == Remove || F.V[1] == Remove || F.V[2] == Remove;
+						//Faces with both ends are visited twice, count them once
+						if (bHasKeep && bHasRemove && End == Remove)
+						{
+							continue;
+						}
+
+						double OldVolume;
+						FDoubleVec OldMoment;
+						TetraContribution(P[F.V[0]], P[F.V[1]], P[F.V[2]], OldVolume, OldMoment);
+						NewVolume -= OldVolume;
+						NewMoment = NewMoment - OldMoment;
+
+						if (bHasKeep && bHasRemove)
+						{
+							NumDying++;
+							continue;
+						}
+
+						const FDoubleVec OldNormal = FaceNormal(Face);
+						const FDoubleVec NewNormal = FaceNormal(Face, End, Collapse.Target);
+						if (NewNormal.Dot(OldNormal) <= 0.0 || NewNormal.Size() <= 1e-12 * OldNormal.Size())
+						{
+							return;
+						}
+
+						FDoubleVec Corners[3];
+						for (int32_t Corner = 0; Corner < 3; Corner++)
+						{
+							Corners[Corner] = F.V[Corner] == End ? Collapse.Target : P[F.V[Corner]];
+						}
+						double Volume;
+						FDoubleVec Moment;
+						TetraContribution(Corners[0], Corners[1], Corners[2], Volume, Moment);
+						NewVolume += Volume;
+						NewMoment = NewMoment + Moment;
+					}
+				}
+
+				if (GetVolumeError(NewVolume) > Settings.MaxVolumeError || GetCentroidError(NewVolume, NewMoment) > Settings.MaxCentroidError)
+				{
+					return;
+				}
+
+				//Commit
+				P[Keep] = Collapse.Target;
+				Quadrics[Keep] += Quadrics[Remove];
+				Removed[Remove] = true;
+				Stamps[Keep]++;
+				Stamps[Remove]++;
+				TotalVolume = NewVolume;
+				TotalMoment = NewMoment;
+
+				for (int32_t Face : VertexFaces[Remove])
+				{
+					FFace& F = Faces[Face];
+					if (F.bRemoved)
+					{
+						continue;
+					}
+					if (F.V[0] == Keep || F.V[1] == Keep || F.V[2] == Keep)
+					{
+						F.bRemoved = true;
+						continue;
+					}
+					for (int32_t Corner = 0; Corner < 3; Corner++)
+					{
+						if (F.V[Corner] == Remove)
+						{
+							F.V[Corner] = Keep;
+						}
+					}
+					VertexFaces[Keep].push_back(Face);
+				}
+				NumLiveFaces -= NumDying;
+				VertexFaces[Remove].clear();
+
+				//Drop dead faces from the kept vertex and queue its edges again with the new position
+				std::vector<int32_t>& KeepFaces = VertexFaces[Keep];
+				KeepFaces.erase(std::remove_if(KeepFaces.begin(), KeepFaces.end(), [this](int32_t Face) { return Faces[Face].bRemoved; }), KeepFaces.end());
+				std::vector<int32_t> Neighbours;
+				for (int32_t Face : KeepFaces)
+				{
+					for (int32_t Corner = 0; Corner < 3; Corner++)
+					{
+						if (Faces[Face].V[Corner] != Keep)
+						{
+							Neighbours.push_back(Faces[Face].V[Corner]);
+						}
+					}
+				}
+				std::sort(Neighbours.begin(), Neighbours.end());
+				Neighbours.erase(std::unique(Neighbours.begin(), Neighbours.end()), Neighbours.end());
+				for (int32_t Neighbour : Neighbours)
+				{
+					QueueCollapse(Keep, Neighbour);
+				}
+			}
+
+			double GetVolumeError(double Volume) const
+			{
+				return SourceVolume != 0.0 ? std::fabs(Volume - SourceVolume) / std::fabs(SourceVolume) : 0.0;
+			}
+
+			double GetCentroidError(double Volume, const FDoubleVec& Moment) const
+			{
+				if (Volume == 0.0 || SourceVolume == 0.0)
+				{
+					return 0.0;
+				}
+				return (Moment * (1.0 / Volume) - SourceCentroid).Size() / Diagonal;
+			}
+
+			void WriteResult(FHullSimplifyResult& OutResult) const
+			{
+				OutResult.Mesh.Vertices.clear();
+				OutResult.Mesh.Indexes.clear();
+
+				//Only the vertices that are still used, in their original order
+				std::vector<int32_t> Remap(P.size(), -1);
+				for (const FFace& F : Faces)
+				{
+					if (F.bRemoved)
+					{
+						continue;
+					}
+					for (int32_t Corner = 0; Corner < 3; Corner++)
+					{
+						Remap[F.V[Corner]] = 0;
+					}
+				}
+				for (size_t i = 0; i < P.size(); i++)
+				{
+					if (Remap[i] == 0)
+					{
+						Remap[i] = (int32_t)OutResult.Mesh.Vertices.size();
+						OutResult.Mesh.Vertices.push_back(P[i].ToFloat());
+					}
+				}
+				for (const FFace& F : Faces)
+				{
+					if (!F.bRemoved)
+					{
+						OutResult.Mesh.Indexes.push_back(Remap[F.V[0]]);
+						OutResult.Mesh.Indexes.push_back(Remap[F.V[1]]);
+						OutResult.Mesh.Indexes.push_back(Remap[F.V[2]]);
+					}
+				}
+
+				OutResult.VolumeError = (float)GetVolumeError(TotalVolume);
+				OutResult.CentroidError = (float)GetCentroidError(TotalVolume, TotalMoment);
+				OutResult.bReachedTarget = NumLiveFaces <= Settings.TargetTriangles;
+			}
+		};
+	}
+
+	void WeldHullVertices(const FHullMesh& Source, float WeldDistance, FHullMesh& OutMesh)
+	{
+		OutMesh.Vertices.clear();
+		OutMesh.Indexes.clear();
+
+		const double Cell = std::max((double)WeldDistance, 1e-6);
+		std::unordered_map<FWeldKey, int32_t, FWeldKeyHash> Welded;
+		std::vector<int32_t> Remap(Source.Vertices.size());
+		for (size_t i = 0; i < Source.Vertices.size(); i++)
+		{
+			const FVec3& V = Source.Vertices[i];
+			const FWeldKey Key = { (int64_t)std::llround(V.X / Cell), (int64_t)std::llround(V.Y / Cell), (int64_t)std::llround(V.Z / Cell) };
+			auto Found = Welded.find(Key);
+			if (Found == Welded.end())
+			{
+				Found = Welded.emplace(Key, (int32_t)OutMesh.Vertices.size()).first;
+				OutMesh.Vertices.push_back(V);
+			}
+			Remap[i] = Found->second;
+		}
+
+		OutMesh.Indexes.reserve(Source.Indexes.size());
+		for (size_t i = 0; i + 2 < Source.Indexes.size(); i += 3)
+		{
+			const int32_t I0 = Remap[Source.Indexes[i + 0]];
+			const int32_t I1 = Remap[Source.Indexes[i + 1]];
+			const int32_t I2 = Remap[Source.Indexes[i + 2]];
+			//Triangles that welding made degenerate carry no surface
+			if (I0 != I1 && I1 != I2 && I2 != I0)
+			{
+				OutMesh.Indexes.push_back(I0);
+				OutMesh.Indexes.push_back(I1);
+				OutMesh.Indexes.push_back(I2);
+			}
+		}
+	}
+
+	void ComputeVolumeAndCentroid(const FHullMesh& Mesh, float& OutVolume, FVec3& OutCentroid)
+	{
+		double Volume = 0.0;
+		FDoubleVec Moment;
+		for (size_t i = 0; i + 2 < Mesh.Indexes.size(); i += 3)
+		{
+			double TetraVolume;
+			FDoubleVec TetraMoment;
+			TetraContribution(FDoubleVec(Mesh.Vertices[Mesh.Indexes[i + 0]]), FDoubleVec(Mesh.Vertices[Mesh.Indexes[i + 1]]), FDoubleVec(Mesh.Vertices[Mesh.Indexes[i + 2]]), TetraVolume, TetraMoment);
+			Volume += TetraVolume;
+			Moment = Moment + TetraMoment;
+		}
+
+		OutVolume = (float)Volume;
+		OutCentroid = Volume != 0.0 ? (Moment * (1.0 / Volume)).ToFloat() : FVec3();
+	}
+
+	void SimplifyHull(const FHullMesh& Source, const FHullSimplifySettings& Settings, FHullSimplifyResult& OutResult)
+	{
+		FSimplifier Simplifier(Source, Settings);
+		Simplifier.Run(OutResult);
+	}
+}
@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HullTopology.h"
+
+namespace BuoyancyCore
+{
+	namespace
+	{
+		float GetBoundingRadius(const FVertexStream& Vertices)
+		{
+			float MaxSizeSquared = 0.0f;
+			for (int32_t i = 0; i < Vertices.Num; i++)
+			{
+				MaxSizeSquared = std::fmax(MaxSizeSquared, Vertices.Get(i).SizeSquared());
+			}
+			return std::sqrt(MaxSizeSquared);
+		}
+
+		void ComputeBounds(FHullTopology& Hull)
+		{
+			if (Hull.Vertices.Num == 0)
+			{
+				return;
+			}
+			Hull.BoundsMin = Hull.Vertices.Get(0);
+			Hull.BoundsMax = Hull.BoundsMin;
+			for (int32_t i = 1; i < Hull.Vertices.Num; i++)
+			{
+				const FVec3 P = Hull.Vertices.Get(i);
+				Hull.BoundsMin = FVec3(std::fmin(Hull.BoundsMin.X, P.X), std::fmin(Hull.BoundsMin.Y, P.Y), std::fmin(Hull.BoundsMin.Z, P.Z));
+				Hull.BoundsMax = FVec3(std::fmax(Hull.BoundsMax.X, P.X), std::fmax(Hull.BoundsMax.Y, P.Y), std::fmax(Hull.BoundsMax.Z, P.Z));
+			}
+		}
+
+		void ComputeTriangleAreas(FHullTopology& Hull)
+		{
+			const int32_t NumTriangles = Hull.GetNumTriangles();
+			Hull.TriangleAreas.resize(NumTriangles);
+			double SurfaceArea = 0.0;
+			for (int32_t Triangle = 0; Triangle < NumTriangles; Triangle++)
+			{
+				const FVec3 P0 = Hull.Vertices.Get(Hull.Triangles[Triangle * 3 + 0]);
+				const FVec3 P1 = Hull.Vertices.Get(Hull.Triangles[Triangle * 3 + 1]);
+				const FVec3 P2 = Hull.Vertices.Get(Hull.Triangles[Triangle * 3 + 2]);
+				Hull.TriangleAreas[Triangle] = FVec3::Cross(P1 - P0, P2 - P0).Size() * 0.5f;
+				SurfaceArea += Hull.TriangleAreas[Triangle];
+			}
+			Hull.SurfaceArea = (float)SurfaceArea;
+		}
+	}
+
+	size_t FHullTopology::GetAllocatedSize() const
+	{
+		return (Vertices.X.capacity() + Vertices.Y.capacity() + Vertices.Z.capacity()) * sizeof(float) + Triangles.capacity() * sizeof(int32_t) + TriangleAreas.capacity() * sizeof(float) + BoundsTree.GetAllocatedSize();
+	}
+
+	void FHullTopology::ToHullMesh(FHullMesh& OutMesh) const
+	{
+		OutMesh.Vertices.resize(Vertices.Num);
+		for (int32_t i = 0; i < Vertices.Num; i++)
+		{
+			OutMesh.Vertices[i] = Vertices.Get(i);
+		}
+		OutMesh.Indexes = Triangles;
+	}
+
+	std::shared_ptr<const FHullTopology> FHullTopology::Make(const FVec3* LocalVertices, int32_t NumVertices, const int32_t* TriangleIndexes, int32_t NumIndexes)
+	{
+		std::shared_ptr<FHullTopology> Hull = std::make_shared<FHullTopology>();
+		Hull->Vertices.SetNum(NumVertices);
+		for (int32_t i = 0; i < NumVertices; i++)
+		{
+			Hull->Vertices.Set(i, LocalVertices[i]);
+		}
+		Hull->Triangles.assign(TriangleIndexes, TriangleIndexes + NumIndexes);
+		Hull->BoundingRadius = GetBoundingRadius(Hull->Vertices);
+		ComputeBounds(*Hull);
+		Hull->BoundsTree.Build(Hull->Vertices, Hull->Triangles.data(), (int32_t)Hull->Triangles.size());
+		ComputeTriangleAreas(*Hull);
+
+		FHullMesh Mesh;
+		Mesh.Vertices.assign(LocalVertices, LocalVertices + NumVertices);
+		Mesh.Indexes = Hull->Triangles;
+		ComputeVolumeAndCentroid(Mesh, Hull->Volume, Hull->Centroid);
+		return Hull;
+	}
+
+	std::shared_ptr<const FHullTopology> FHullTopology::Make(const FCookedHullView& Cooked)
+	{
+		std::shared_ptr<FHullTopology> Hull = std::make_shared<FHullTopology>();
+		const int32_t PaddedNum = Cooked.GetPaddedNumVertices();
+		Hull->Vertices.Num = Cooked.GetNumVertices();
+		Hull->Vertices.X.assign(Cooked.X, Cooked.X + PaddedNum);
+		Hull->Vertices.Y.assign(Cooked.Y, Cooked.Y + PaddedNum);
+		Hull->Vertices.Z.assign(Cooked.Z, Cooked.Z + PaddedNum);
+		Hull->Triangles.assign(Cooked.Indexes, Cooked.Indexes + Cooked.GetNumIndexes());
+		//Everything derived was cooked along, loading is copies only
+		const FCookedHullHeader& Header = *Cooked.Header;
+		Hull->BoundingRadius = Header.BoundingRadius;
+		Hull->BoundsMin = FVec3(Header.BoundsMinX, Header.BoundsMinY, Header.BoundsMinZ);
+		Hull->BoundsMax = FVec3(Header.BoundsMaxX, Header.BoundsMaxY, Header.BoundsMaxZ);
+		Hull->Volume = Header.Volume;
+		Hull->Centroid = FVec3(Header.CentroidX, Header.CentroidY, Header.CentroidZ);
+		Hull->TriangleAreas.assign(Cooked.TriangleAreas, Cooked.TriangleAreas + Cooked.GetNumTriangles());
+		Hull->SurfaceArea = Header.SurfaceArea;
+		//Built by the cooker, an empty tree there means the hull was too small for one
+		if (Cooked.GetNumTreeNodes() > 0)
+		{
+			Hull->BoundsTree.Nodes.assign(Cooked.TreeNodes, Cooked.TreeNodes + Cooked.GetNumTreeNodes());
+			Hull->BoundsTree.Triangles.assign(Cooked.TreeTriangles, Cooked.TreeTriangles + Cooked.GetNumTriangles());
+		}
+		return Hull;
+	}
+
+	const std::shared_ptr<const FHullTopology>& FHullTopology::GetEmpty()
+	{
+		static const std::shared_ptr<const FHullTopology> Empty = std::make_shared<FHullTopology>();
+		return Empty;
+	}
+}
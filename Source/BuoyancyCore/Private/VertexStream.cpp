@@ -0,0 +1,187 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "VertexStream.h"
+
+namespace BuoyancyCore
+{
+	void FVertexStream::SetNum(int32_t NewNum)
+	{
+		Num = NewNum;
+
+		//Padding lanes stay zero so the kernels can always run full vectors
+		const int32_t PaddedNum = PadToSimdLanes(NewNum);
+		X.assign(PaddedNum, 0.0f);
+		Y.assign(PaddedNum, 0.0f);
+		Z.assign(PaddedNum, 0.0f);
+	}
+
+	void TransformVerticesAndDistancesScalar(const FHullTransform& LocalToWorld, const FVertexStream& Local, float WaterLevel, FVertexStream& World, float* Distances, int32_t Begin, int32_t End)
+	{
+		const float(&M)[3][4] = LocalToWorld.M;
+		for (int32_t i = Begin; i < End; i++)
+		{
+			const float LX = Local.X[i];
+			const float LY = Local.Y[i];
+			const float LZ = Local.Z[i];
+
+			World.X[i] = M[0][0] * LX + M[0][1] * LY + M[0][2] * LZ + M[0][3];
+			World.Y[i] = M[1][0] * LX + M[1][1] * LY + M[1][2] * LZ + M[1][3];
+			const float WZ = M[2][0] * LX + M[2][1] * LY + M[2][2] * LZ + M[2][3];
+			World.Z[i] = WZ;
+			Distances[i] = WZ - WaterLevel;
+		}
+	}
+
+	void TransformVerticesAndDistances(const FHullTransform& LocalToWorld, const FVertexStream& Local, float WaterLevel, FVertexStream& World, float* Distances)
+	{
+		const int32_t PaddedNum = Local.GetPaddedNum();
+		const float* InX = Local.X.data();
+		const float* InY = Local.Y.data();
+		const float* InZ = Local.Z.data();
+		float* OutX = World.X.data();
+		float* OutY = World.Y.data();
+		float* OutZ = World.Z.data();
+		const float(&M)[3][4] = LocalToWorld.M;
+
+#if BUOYANCY_SIMD_AVX2
+		//8 vertices per iteration, the matrix is splatted once for the whole hull
+		const __m256 M00 = _mm256_set1_ps(M[0][0]), M01 = _mm256_set1_ps(M[0][1]), M02 = _mm256_set1_ps(M[0][2]), M03 = _mm256_set1_ps(M[0][3]);
+		const __m256 M10 = _mm256_set1_ps(M[1][0]), M11 = _mm256_set1_ps(M[1][1]), M12 = _mm256_set1_ps(M[1][2]), M13 = _mm256_set1_ps(M[1][3]);
+		const __m256 M20 = _mm256_set1_ps(M[2][0]), M21 = _mm256_set1_ps(M[2][1]), M22 = _mm256_set1_ps(M[2][2]), M23 = _mm256_set1_ps(M[2][3]);
+		const __m256 Water = _mm256_set1_ps(WaterLevel);
+
+		for (int32_t i = 0; i < PaddedNum; i += 8)
+		{
+			const __m256 LX = _mm256_loadu_ps(InX + i);
+			const __m256 LY = _mm256_loadu_ps(InY + i);
+			const __m256 LZ = _mm256_loadu_ps(InZ + i);
+
+			const __m256 WX = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(M00, LX), _mm256_mul_ps(M01, LY)), _mm256_add_ps(_mm256_mul_ps(M02, LZ), M03));
+			const __m256 WY = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(M10, LX), _mm256_mul_ps(M11, LY)), _mm256_add_ps(_mm256_mul_ps(M12, LZ), M13));
+			const __m256 WZ = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(M20, LX), _mm256_mul_ps(M21, LY)), _mm256_add_ps(_mm256_mul_ps(M22, LZ), M23));
+
+			_mm256_storeu_ps(OutX + i, WX);
+			_mm256_storeu_ps(OutY + i, WY);
+			_mm256_storeu_ps(OutZ + i, WZ);
+			_mm256_storeu_ps(Distances + i, _mm256_sub_ps(WZ, Water));
+		}
+#elif BUOYANCY_SIMD_SSE
+		//4 vertices per iteration
+		const __m128 M00 = _mm_set1_ps(M[0][0]), M01 = _mm_set1_ps(M[0][1]), M02 = _mm_set1_ps(M[0][2]), M03 = _mm_set1_ps(M[0][3]);
+		const __m128 M10 = _mm_set1_ps(M[1][0]), M11 = _mm_set1_ps(M[1][1]), M12 = _mm_set1_ps(M[1][2]), M13 = _mm_set1_ps(M[1][3]);
+		const __m128 M20 = _mm_set1_ps(M[2][0]), M21 = _mm_set1_ps(M[2][1]), M22 = _mm_set1_ps(M[2][2]), M23 = _mm_set1_ps(M[2][3]);
+		const __m128 Water = _mm_set1_ps(WaterLevel);
+
+		for (int32_t i = 0; i < PaddedNum; i += 4)
+		{
+			const __m128 LX = _mm_loadu_ps(InX + i);
+			const __m128 LY = _mm_loadu_ps(InY + i);
+			const __m128 LZ = _mm_loadu_ps(InZ + i);
+
+			const __m128 WX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(M00, LX), _mm_mul_ps(M01, LY)), _mm_add_ps(_mm_mul_ps(M02, LZ), M03));
+			const __m128 WY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(M10, LX), _mm_mul_ps(M11, LY)), _mm_add_ps(_mm_mul_ps(M12, LZ), M13));
+			const __m128 WZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(M20, LX), _mm_mul_ps(M21, LY)), _mm_add_ps(_mm_mul_ps(M22, LZ), M23));
+
+			_mm_storeu_ps(OutX + i, WX);
+			_mm_storeu_ps(OutY + i, WY);
+			_mm_storeu_ps(OutZ + i, WZ);
+			_mm_storeu_ps(Distances + i, _mm_sub_ps(WZ, Water));
+		}
+#elif BUOYANCY_SIMD_NEON
+		//4 vertices per iteration
+		const float32x4_t M03 = vdupq_n_f32(M[0][3]);
+		const float32x4_t M13 = vdupq_n_f32(M[1][3]);
+		const float32x4_t M23 = vdupq_n_f32(M[2][3]);
+		const float32x4_t Water = vdupq_n_f32(WaterLevel);
+
+		for (int32_t i = 0; i < PaddedNum; i += 4)
+		{
+			const float32x4_t LX = vld1q_f32(InX + i);
+			const float32x4_t LY = vld1q_f32(InY + i);
+			const float32x4_t LZ = vld1q_f32(InZ + i);
+
+			const float32x4_t WX = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(M03, LX, M[0][0]), LY, M[0][1]), LZ, M[0][2]);
+			const float32x4_t WY = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(M13, LX, M[1][0]), LY, M[1][1]), LZ, M[1][2]);
+			const float32x4_t WZ = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(M23, LX, M[2][0]), LY, M[2][1]), LZ, M[2][2]);
+
+			vst1q_f32(OutX + i, WX);
+			vst1q_f32(OutY + i, WY);
+			vst1q_f32(OutZ + i, WZ);
+			vst1q_f32(Distances + i, vsubq_f32(WZ, Water));
+		}
+#else
+		(void)InX; (void)InY; (void)InZ; (void)OutX; (void)OutY; (void)OutZ; (void)M;
+		TransformVerticesAndDistancesScalar(LocalToWorld, Local, WaterLevel, World, Distances, 0, PaddedNum);
+#endif
+	}
+
+	void ComputePlaneDistances(const FVertexStream& Local, const FVec3& Axis, float Offset, float* Distances)
+	{
+		const int32_t PaddedNum = Local.GetPaddedNum();
+		const float* InX = Local.X.data();
+		const float* InY = Local.Y.data();
+		const float* InZ = Local.Z.data();
+		const FSimdFloat AxisX = FSimdFloat::Splat(Axis.X);
+		const FSimdFloat AxisY = FSimdFloat::Splat(Axis.Y);
+		const FSimdFloat AxisZ = FSimdFloat::Splat(Axis.Z);
+		const FSimdFloat PlaneOffset = FSimdFloat::Splat(Offset);
+		for (int32_t i = 0; i < PaddedNum; i += FSimdFloat::Width)
+		{
+			(AxisX * FSimdFloat::Load(InX + i) + AxisY * FSimdFloat::Load(InY + i) + AxisZ * FSimdFloat::Load(InZ + i) + PlaneOffset).Store(Distances + i);
+		}
+	}
+
+	void ClassifyVertices(const float* Distances, int32_t PaddedNum, uint8_t* AboveBits, uint8_t* BelowBits)
+	{
+#if BUOYANCY_SIMD_AVX2
+		const __m256 Zero = _mm256_setzero_ps();
+		for (int32_t i = 0; i < PaddedNum; i += 8)
+		{
+			const __m256 D = _mm256_loadu_ps(Distances + i);
+			AboveBits[i >> 3] = (uint8_t)_mm256_movemask_ps(_mm256_cmp_ps(D, Zero, _CMP_GT_OQ));
+			BelowBits[i >> 3] = (uint8_t)_mm256_movemask_ps(_mm256_cmp_ps(D, Zero, _CMP_LT_OQ));
+		}
+#elif BUOYANCY_SIMD_SSE
+		const __m128 Zero = _mm_setzero_ps();
+		for (int32_t i = 0; i < PaddedNum; i += 8)
+		{
+			const __m128 Low = _mm_loadu_ps(Distances + i);
+			const __m128 High = _mm_loadu_ps(Distances + i + 4);
+			AboveBits[i >> 3] = (uint8_t)(_mm_movemask_ps(_mm_cmpgt_ps(Low, Zero)) | (_mm_movemask_ps(_mm_cmpgt_ps(High, Zero)) << 4));
+			BelowBits[i >> 3] = (uint8_t)(_mm_movemask_ps(_mm_cmplt_ps(Low, Zero)) | (_mm_movemask_ps(_mm_cmplt_ps(High, Zero)) << 4));
+		}
+#elif BUOYANCY_SIMD_NEON
+		//No movemask on NEON, mask the compare lanes with their bit weight and add them up instead
+		static const uint32_t LowWeights[4] = { 1, 2, 4, 8 };
+		static const uint32_t HighWeights[4] = { 16, 32, 64, 128 };
+		const uint32x4_t LowWeight = vld1q_u32(LowWeights);
+		const uint32x4_t HighWeight = vld1q_u32(HighWeights);
+		const float32x4_t Zero = vdupq_n_f32(0.0f);
+		for (int32_t i = 0; i < PaddedNum; i += 8)
+		{
+			const float32x4_t Low = vld1q_f32(Distances + i);
+			const float32x4_t High = vld1q_f32(Distances + i + 4);
+			const uint32x4_t Above = vaddq_u32(vandq_u32(vcgtq_f32(Low, Zero), LowWeight), vandq_u32(vcgtq_f32(High, Zero), HighWeight));
+			const uint32x4_t Below = vaddq_u32(vandq_u32(vcltq_f32(Low, Zero), LowWeight), vandq_u32(vcltq_f32(High, Zero), HighWeight));
+			//Horizontal add that also works on 32 bit ARM
+			const uint32x2_t AbovePair = vpadd_u32(vget_low_u32(Above), vget_high_u32(Above));
+			const uint32x2_t BelowPair = vpadd_u32(vget_low_u32(Below), vget_high_u32(Below));
+			AboveBits[i >> 3] = (uint8_t)vget_lane_u32(vpadd_u32(AbovePair, AbovePair), 0);
+			BelowBits[i >> 3] = (uint8_t)vget_lane_u32(vpadd_u32(BelowPair, BelowPair), 0);
+		}
+#else
+		for (int32_t i = 0; i < PaddedNum; i += 8)
+		{
+			uint8_t Above = 0;
+			uint8_t Below = 0;
+			for (int32_t Lane = 0; Lane < 8; Lane++)
+			{
+				Above |= (uint8_t)((Distances[i + Lane] > 0.0f) << Lane);
+				Below |= (uint8_t)((Distances[i + Lane] < 0.0f) << Lane);
+			}
+			AboveBits[i >> 3] = Above;
+			BelowBits[i >> 3] = Below;
+		}
+#endif
+	}
+}
@@ -0,0 +1,235 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "WaterHeightfieldCache.h"
+#include <cmath>
+
+namespace BuoyancyCore
+{
+	namespace
+	{
+		//Floor division, tiles left of and below the origin have negative coordinates
+		inline int32_t FloorDiv(int32_t Value, int32_t Divisor)
+		{
+			return Value >= 0 ? Value / Divisor : -((-Value + Divisor - 1) / Divisor);
+		}
+	}
+
+	void FWaterHeightfieldCache::SetSource(const IWaterSurface* InSource, const FSettings& InSettings)
+	{
+		std::lock_guard<std::shared_timed_mutex> Lock(Mutex);
+
+		Source = InSource;
+		Settings = InSettings;
+		Settings.CellSize = std::fmax(Settings.CellSize, 1.0f);
+		Settings.TileResolution = Settings.TileResolution < 1 ? 1 : Settings.TileResolution;
+		//Two so the tile a query is reading from is never the least recently used one
+		Settings.MaxTiles = Settings.MaxTiles < 2 ? 2 : Settings.MaxTiles;
+		Settings.TimeStep = std::fmax(Settings.TimeStep, 0.0f);
+
+		//All the memory the cache will ever use, sized up front
+		const int32_t Stride = Settings.TileResolution + 1;
+		Tiles.assign(Settings.MaxTiles, FTile());
+		for (FTile& Tile : Tiles)
+		{
+			Tile.Heights.assign(PadToSimdLanes(Stride * Stride), 0.0f);
+		}
+		TileLastUse.reset(new std::atomic<uint64_t>[Settings.MaxTiles]);
+		for (int32_t Index = 0; Index < Settings.MaxTiles; Index++)
+		{
+			TileLastUse[Index].store(0, std::memory_order_relaxed);
+		}
+
+		int32_t NumBuckets = 1;
+		while (NumBuckets < Settings.MaxTiles * 2)
+		{
+			NumBuckets *= 2;
+		}
+		Buckets.assign(NumBuckets, -1);
+
+		ScratchX.assign(PadToSimdLanes(Stride * Stride), 0.0f);
+		ScratchY.assign(PadToSimdLanes(Stride * Stride), 0.0f);
+
+		UseCounter.store(0, std::memory_order_relaxed);
+		NumTileBuilds = 0;
+	}
+
+	void FWaterHeightfieldCache::Invalidate()
+	{
+		std::lock_guard<std::shared_timed_mutex> Lock(Mutex);
+
+		for (FTile& Tile : Tiles)
+		{
+			Tile.bInUse = false;
+			Tile.NextInBucket = -1;
+		}
+		for (int32_t& Bucket : Buckets)
+		{
+			Bucket = -1;
+		}
+	}
+
+	void FWaterHeightfieldCache::GetHeights(const float* X, const float* Y, int32_t Num, float InTime, float* OutHeights) const
+	{
+		//In double, float times lose the step long before the game has run for a day
+		const float Time = Settings.TimeStep > 0.0f ? (float)(std::floor((double)InTime / Settings.TimeStep + 0.5) * Settings.TimeStep) : InTime;
+
+		//Normally every tile is already there and any number of hulls sample at once
+		{
+			std::shared_lock<std::shared_timed_mutex> SharedLock(Mutex);
+			if (Source == nullptr)
+			{
+				for (int32_t i = 0; i < Num; i++)
+				{
+					OutHeights[i] = 0.0f;
+				}
+				return;
+			}
+			if (Sample(X, Y, Num, Time, OutHeights, false))
+			{
+				return;
+			}
+		}
+
+		//First hull to reach a tile this step builds it, the others wait for the lock
+		std::lock_guard<std::shared_timed_mutex> Lock(Mutex);
+		Sample(X, Y, Num, Time, OutHeights, true);
+	}
+
+	bool FWaterHeightfieldCache::Sample(const float* X, const float* Y, int32_t Num, float Time, float* OutHeights, bool bBuildTiles) const
+	{
+		const float InvCellSize = 1.0f / Settings.CellSize;
+		const int32_t Resolution = Settings.TileResolution;
+		const int32_t Stride = Resolution + 1;
+
+		//The vertices of one hull are close together, so the tile only changes a few times per query
+		const FTile* Tile = nullptr;
+		int32_t TileX = 0;
+		int32_t TileY = 0;
+
+		for (int32_t i = 0; i < Num; i++)
+		{
+			const float CellX = X[i] * InvCellSize;
+			const float CellY = Y[i] * InvCellSize;
+			//Truncate and step down for negatives, std::floor is a library call without SSE4.1
+			const int32_t IndexX = (int32_t)CellX - (CellX < (float)(int32_t)CellX ? 1 : 0);
+			const int32_t IndexY = (int32_t)CellY - (CellY < (float)(int32_t)CellY ? 1 : 0);
+
+			const int32_t NewTileX = FloorDiv(IndexX, Resolution);
+			const int32_t NewTileY = FloorDiv(IndexY, Resolution);
+			if (Tile == nullptr || NewTileX != TileX || NewTileY != TileY)
+			{
+				TileX = NewTileX;
+				TileY = NewTileY;
+				Tile = FindTile(TileX, TileY, Time, bBuildTiles);
+				if (Tile == nullptr)
+				{
+					return false;
+				}
+			}
+
+			const float* H = Tile->Heights.data() + (IndexY - TileY * Resolution) * Stride + (IndexX - TileX * Resolution);
+			const float FracX = CellX - (float)IndexX;
+			const float FracY = CellY - (float)IndexY;
+			const float Bottom = H[0] + FracX * (H[1] - H[0]);
+			const float Top = H[Stride] + FracX * (H[Stride + 1] - H[Stride]);
+			OutHeights[i] = Bottom + FracY * (Top - Bottom);
+		}
+		return true;
+	}
+
+	uint32_t FWaterHeightfieldCache::GetBucket(int32_t TileX, int32_t TileY) const
+	{
+		const uint32_t Hash = (uint32_t)TileX * 73856093u ^ (uint32_t)TileY * 19349663u;
+		return Hash & (uint32_t)(Buckets.size() - 1);
+	}
+
+	const FWaterHeightfieldCache::FTile* FWaterHeightfieldCache::FindTile(int32_t TileX, int32_t TileY, float Time, bool bBuild) const
+	{
+		const uint32_t Bucket = GetBucket(TileX, TileY);
+		for (int32_t Index = Buckets[Bucket]; Index >= 0; Index = Tiles[Index].NextInBucket)
+		{
+			FTile& Tile = Tiles[Index];
+			//The same tile at other times is in the same bucket until it gets recycled
+			if (Tile.TileX == TileX && Tile.TileY == TileY && Tile.Time == Time)
+			{
+				TileLastUse[Index].store(UseCounter.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				return &Tile;
+			}
+		}
+
+		if (!bBuild)
+		{
+			return nullptr;
+		}
+
+		//A free slot if there is one, otherwise recycle the tile that was used longest ago
+		int32_t Slot = -1;
+		uint64_t OldestUse = ~(uint64_t)0;
+		for (int32_t Index = 0; Index < (int32_t)Tiles.size(); Index++)
+		{
+			if (!Tiles[Index].bInUse)
+			{
+				Slot = Index;
+				break;
+			}
+			const uint64_t LastUse = TileLastUse[Index].load(std::memory_order_relaxed);
+			if (LastUse < OldestUse)
+			{
+				OldestUse = LastUse;
+				Slot = Index;
+			}
+		}
+		if (Tiles[Slot].bInUse)
+		{
+			UnlinkTile(Slot);
+		}
+
+		FTile& Tile = Tiles[Slot];
+		BuildTile(Tile, TileX, TileY, Time);
+		Tile.bInUse = true;
+		TileLastUse[Slot].store(UseCounter.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		Tile.NextInBucket = Buckets[Bucket];
+		Buckets[Bucket] = Slot;
+		return &Tile;
+	}
+
+	void FWaterHeightfieldCache::BuildTile(FTile& Tile, int32_t TileX, int32_t TileY, float Time) const
+	{
+		const int32_t Resolution = Settings.TileResolution;
+		const int32_t Stride = Resolution + 1;
+
+		//Grid points of the tile including the shared last row and column, evaluated in one batch
+		float* PointX = ScratchX.data();
+		float* PointY = ScratchY.data();
+		for (int32_t Row = 0; Row < Stride; Row++)
+		{
+			const float PositionY = (float)(TileY * Resolution + Row) * Settings.CellSize;
+			for (int32_t Column = 0; Column < Stride; Column++)
+			{
+				PointX[Row * Stride + Column] = (float)(TileX * Resolution + Column) * Settings.CellSize;
+				PointY[Row * Stride + Column] = PositionY;
+			}
+		}
+		Source->GetHeights(PointX, PointY, (int32_t)ScratchX.size(), Time, Tile.Heights.data());
+
+		Tile.TileX = TileX;
+		Tile.TileY = TileY;
+		Tile.Time = Time;
+		NumTileBuilds++;
+	}
+
+	void FWaterHeightfieldCache::UnlinkTile(int32_t Index) const
+	{
+		const FTile& Tile = Tiles[Index];
+		int32_t* Link = &Buckets[GetBucket(Tile.TileX, Tile.TileY)];
+		while (*Link >= 0)
+		{
+			if (*Link == Index)
+			{
+				*Link = Tile.NextInBucket;
+				break;
+			}
+			Link = &Tiles[*Link].NextInBucket;
+		}
+	}
+}
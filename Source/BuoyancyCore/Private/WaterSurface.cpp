@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "WaterSurface.h"
+
+namespace BuoyancyCore
+{
+	FWaterPlane FWaterPlane::Fit(const IWaterSurface* Surface, float Time, float CenterX, float CenterY, float Radius)
+	{
+		FWaterPlane Plane;
+		Plane.CenterX = CenterX;
+		Plane.CenterY = CenterY;
+		if (Surface == nullptr)
+		{
+			return Plane;
+		}
+
+		//Center, +X, -X, +Y, -Y. Symmetric around the center, so the least squares fit is the mean and two central differences
+		const float X[5] = { CenterX, CenterX + Radius, CenterX - Radius, CenterX, CenterX };
+		const float Y[5] = { CenterY, CenterY, CenterY, CenterY + Radius, CenterY - Radius };
+		float Heights[5];
+		Surface->GetHeights(X, Y, 5, Time, Heights);
+
+		Plane.Height = (Heights[0] + Heights[1] + Heights[2] + Heights[3] + Heights[4]) / 5.0f;
+		if (Radius > 0.0f)
+		{
+			Plane.SlopeX = (Heights[1] - Heights[2]) / (2.0f * Radius);
+			Plane.SlopeY = (Heights[3] - Heights[4]) / (2.0f * Radius);
+		}
+		return Plane;
+	}
+
+	void FFlatWaterSurface::GetHeights(const float* X, const float* Y, int32_t Num, float Time, float* OutHeights) const
+	{
+		(void)X; (void)Y; (void)Time;
+		for (int32_t i = 0; i < Num; i++)
+		{
+			OutHeights[i] = Height;
+		}
+	}
+
+	void FGerstnerWaterSurface::SetWaves(const FGerstnerWave* Waves, int32_t NumWaves, float InMeanHeight, float InGravity)
+	{
+		MeanHeight = InMeanHeight;
+		Prepared.clear();
+		Prepared.reserve(NumWaves);
+
+		for (int32_t i = 0; i < NumWaves; i++)
+		{
+			const FGerstnerWave& Wave = Waves[i];
+			const float DirectionSize = std::sqrt(Wave.DirectionX * Wave.DirectionX + Wave.DirectionY * Wave.DirectionY);
+			if (Wave.Wavelength <= 0.0f || DirectionSize <= 0.0f)
+			{
+				continue;
+			}
+
+			const float DX = Wave.DirectionX / DirectionSize;
+			const float DY = Wave.DirectionY / DirectionSize;
+			const float K = 6.28318531f / Wave.Wavelength;
+			//Steepness is shared out between the waves so the sum never loops over itself
+			const float Sideways = std::fmin(std::fmax(Wave.Steepness, 0.0f), 1.0f) / (K * (float)NumWaves);
+
+			FPreparedWave Out;
+			Out.KX = DX * K;
+			Out.KY = DY * K;
+			Out.Omega = std::sqrt(InGravity * K);
+			Out.Phase = Wave.Phase;
+			Out.Amplitude = Wave.Amplitude;
+			Out.SidewaysX = DX * Sideways;
+			Out.SidewaysY = DY * Sideways;
+			Prepared.push_back(Out);
+		}
+	}
+
+	void FGerstnerWaterSurface::GetHeights(const float* X, const float* Y, int32_t Num, float Time, float* OutHeights) const
+	{
+		const int32_t NumFull = Num - Num % FSimdFloat::Width;
+		GetHeightsSimd(X, Y, 0, NumFull, Time, OutHeights);
+
+		//Callers normally pass padded streams, anything left over goes through one register worth of scratch
+		if (NumFull < Num)
+		{
+			float TailX[FSimdFloat::Width] = {};
+			float TailY[FSimdFloat::Width] = {};
+			float TailHeights[FSimdFloat::Width] = {};
+			for (int32_t i = NumFull; i < Num; i++)
+			{
+				TailX[i - NumFull] = X[i];
+				TailY[i - NumFull] = Y[i];
+			}
+			GetHeightsSimd(TailX, TailY, 0, FSimdFloat::Width, Time, TailHeights);
+			for (int32_t i = NumFull; i < Num; i++)
+			{
+				OutHeights[i] = TailHeights[i - NumFull];
+			}
+		}
+	}
+
+	void FGerstnerWaterSurface::GetHeightsSimd(const float* X, const float* Y, int32_t Begin, int32_t End, float Time, float* OutHeights) const
+	{
+		const FPreparedWave* Waves = Prepared.data();
+		const int32_t NumWaves = (int32_t)Prepared.size();
+
+		for (int32_t i = Begin; i < End; i += FSimdFloat::Width)
+		{
+			const FSimdFloat PX = FSimdFloat::Load(X + i);
+			const FSimdFloat PY = FSimdFloat::Load(Y + i);
+
+			//Undisplaced position whose water ends up above PX, PY
+			FSimdFloat UX = PX;
+			FSimdFloat UY = PY;
+			for (int32_t Iteration = 0; Iteration < InversionIterations; Iteration++)
+			{
+				FSimdFloat OffsetX = FSimdFloat::Splat(0.0f);
+				FSimdFloat OffsetY = FSimdFloat::Splat(0.0f);
+				for (int32_t w = 0; w < NumWaves; w++)
+				{
+					const FPreparedWave& Wave = Waves[w];
+					const FSimdFloat Angle = UX * FSimdFloat::Splat(Wave.KX) + UY * FSimdFloat::Splat(Wave.KY) + FSimdFloat::Splat(Wave.Phase - Wave.Omega * Time);
+					const FSimdFloat Cosine = Cos(Angle);
+					OffsetX = OffsetX + Cosine * FSimdFloat::Splat(Wave.SidewaysX);
+					OffsetY = OffsetY + Cosine * FSimdFloat::Splat(Wave.SidewaysY);
+				}
+				UX = PX - OffsetX;
+				UY = PY - OffsetY;
+			}
+
+			FSimdFloat Height = FSimdFloat::Splat(MeanHeight);
+			for (int32_t w = 0; w < NumWaves; w++)
+			{
+				const FPreparedWave& Wave = Waves[w];
+				const FSimdFloat Angle = UX * FSimdFloat::Splat(Wave.KX) + UY * FSimdFloat::Splat(Wave.KY) + FSimdFloat::Splat(Wave.Phase - Wave.Omega * Time);
+				Height = Height + Sin(Angle) * FSimdFloat::Splat(Wave.Amplitude);
+			}
+			Height.Store(OutHeights + i);
+		}
+	}
+
+	float FGerstnerWaterSurface::GetHeightReference(float X, float Y, float Time) const
+	{
+		float UX = X;
+		float UY = Y;
+		for (int32_t Iteration = 0; Iteration < InversionIterations; Iteration++)
+		{
+			float OffsetX = 0.0f;
+			float OffsetY = 0.0f;
+			for (const FPreparedWave& Wave : Prepared)
+			{
+				const float Cos = std::cos(UX * Wave.KX + UY * Wave.KY + Wave.Phase - Wave.Omega * Time);
+				OffsetX += Cos * Wave.SidewaysX;
+				OffsetY += Cos * Wave.SidewaysY;
+			}
+			UX = X - OffsetX;
+			UY = Y - OffsetY;
+		}
+
+		float Height = MeanHeight;
+		for (const FPreparedWave& Wave : Prepared)
+		{
+			Height += Wave.Amplitude * std::sin(UX * Wave.KX + UY * Wave.KY + Wave.Phase - Wave.Omega * Time);
+		}
+		return Height;
+	}
+}
@@ -0,0 +1,206 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "WaterVolumes.h"
+#include <algorithm>
+#include <cmath>
+
+namespace BuoyancyCore
+{
+	namespace
+	{
+		inline uint64_t MakeCellKey(int32_t X, int32_t Y)
+		{
+			return ((uint64_t)(uint32_t)X << 32) | (uint64_t)(uint32_t)Y;
+		}
+
+		inline bool BoxesOverlap(const FVec3& MinA, const FVec3& MaxA, const FVec3& MinB, const FVec3& MaxB)
+		{
+			return MinA.X <= MaxB.X && MaxA.X >= MinB.X && MinA.Y <= MaxB.Y && MaxA.Y >= MinB.Y && MinA.Z <= MaxB.Z && MaxA.Z >= MinB.Z;
+		}
+	}
+
+	FWaterVolumeRegistry::FWaterVolumeRegistry(float InCellSize)
+		: CellSize(std::fmax(InCellSize, 1.0f))
+	{
+	}
+
+	int32_t FWaterVolumeRegistry::GetCell(float Coordinate) const
+	{
+		//Clamped so volumes and bodies far out still land in a valid cell, the box test sorts them out
+		const float Cell = std::floor(Coordinate / CellSize);
+		return (int32_t)std::fmax(std::fmin(Cell, 1.0e9f), -1.0e9f);
+	}
+
+	int32_t FWaterVolumeRegistry::Add(const FWaterVolume& Volume)
+	{
+		int32_t Handle;
+		if (!FreeSlots.empty())
+		{
+			Handle = FreeSlots.back();
+			FreeSlots.pop_back();
+		}
+		else
+		{
+			Handle = (int32_t)Slots.size();
+			Slots.emplace_back();
+		}
+		Slots[Handle].Volume = Volume;
+		Slots[Handle].bUsed = true;
+		NumVolumes++;
+		Link(Handle);
+		return Handle;
+	}
+
+	void FWaterVolumeRegistry::Update(int32_t Handle, const FWaterVolume& Volume)
+	{
+		Unlink(Handle);
+		Slots[Handle].Volume = Volume;
+		Link(Handle);
+	}
+
+	void FWaterVolumeRegistry::Remove(int32_t Handle)
+	{
+		Unlink(Handle);
+		Slots[Handle] = FSlot();
+		FreeSlots.push_back(Handle);
+		NumVolumes--;
+	}
+
+	void FWaterVolumeRegistry::Link(int32_t Handle)
+	{
+		FSlot& Slot = Slots[Handle];
+		const int32_t MinX = GetCell(Slot.Volume.BoundsMin.X);
+		const int32_t MinY = GetCell(Slot.Volume.BoundsMin.Y);
+		const int32_t MaxX = GetCell(Slot.Volume.BoundsMax.X);
+		const int32_t MaxY = GetCell(Slot.Volume.BoundsMax.Y);
+		if ((int64_t)(MaxX - MinX + 1) * (MaxY - MinY + 1) > MaxCellsPerVolume)
+		{
+			LargeVolumes.push_back(Handle);
+			return;
+		}
+
+		Slot.CellMinX = MinX;
+		Slot.CellMinY = MinY;
+		Slot.CellMaxX = MaxX;
+		Slot.CellMaxY = MaxY;
+		for (int32_t Y = MinY; Y <= MaxY; Y++)
+		{
+			for (int32_t X = MinX; X <= MaxX; X++)
+			{
+				Cells[MakeCellKey(X, Y)].push_back(Handle);
+			}
+		}
+	}
+
+	void FWaterVolumeRegistry::Unlink(int32_t Handle)
+	{
+		FSlot& Slot = Slots[Handle];
+		const auto Large = std::find(LargeVolumes.begin(), LargeVolumes.end(), Handle);
+		if (Large != LargeVolumes.end())
+		{
+			LargeVolumes.erase(Large);
+			return;
+		}
+
+		for (int32_t Y = Slot.CellMinY; Y <= Slot.CellMaxY; Y++)
+		{
+			for (int32_t X = Slot.CellMinX; X <= Slot.CellMaxX; X++)
+			{
+				const auto Cell = Cells.find(MakeCellKey(X, Y));
+				std::vector<int32_t>& Handles = Cell->second;
+				Handles.erase(std::find(Handles.begin(), Handles.end(), Handle));
+				if (Handles.empty())
+				{
+					Cells.erase(Cell);
+				}
+			}
+		}
+		Slot.CellMaxX = Slot.CellMinX - 1;
+		Slot.CellMaxY = Slot.CellMinY - 1;
+	}
+
+	template<typename FunctionType>
+	void FWaterVolumeRegistry::ForEachOverlapping(const FVec3& BoxMin, const FVec3& BoxMax, FunctionType Function) const
+	{
+		for (const int32_t Handle : LargeVolumes)
+		{
+			const FWaterVolume& Volume = Slots[Handle].Volume;
+			if (BoxesOverlap(BoxMin, BoxMax, Volume.BoundsMin, Volume.BoundsMax))
+			{
+				Function(Handle);
+			}
+		}
+
+		const int32_t MinX = GetCell(BoxMin.X);
+		const int32_t MinY = GetCell(BoxMin.Y);
+		const int32_t MaxX = GetCell(BoxMax.X);
+		const int32_t MaxY = GetCell(BoxMax.Y);
+		if ((int64_t)(MaxX - MinX + 1) * (MaxY - MinY + 1) > (int64_t)Slots.size())
+		{
+			//A box bigger than the world's water, fewer volumes to test than cells
+			for (int32_t Handle = 0; Handle < (int32_t)Slots.size(); Handle++)
+			{
+				const FSlot& Slot = Slots[Handle];
+				if (Slot.bUsed && Slot.CellMaxX >= Slot.CellMinX && BoxesOverlap(BoxMin, BoxMax, Slot.Volume.BoundsMin, Slot.Volume.BoundsMax))
+				{
+					Function(Handle);
+				}
+			}
+			return;
+		}
+
+		for (int32_t Y = MinY; Y <= MaxY; Y++)
+		{
+			for (int32_t X = MinX; X <= MaxX; X++)
+			{
+				const auto Cell = Cells.find(MakeCellKey(X, Y));
+				if (Cell == Cells.end())
+				{
+					continue;
+				}
+				for (const int32_t Handle : Cell->second)
+				{
+					//A volume over several of the cells is only looked at in the first cell both cover
+					const FSlot& Slot = Slots[Handle];
+					if (X == std::max(MinX, Slot.CellMinX) && Y == std::max(MinY, Slot.CellMinY)
+						&& BoxesOverlap(BoxMin, BoxMax, Slot.Volume.BoundsMin, Slot.Volume.BoundsMax))
+					{
+						Function(Handle);
+					}
+				}
+			}
+		}
+	}
+
+	int32_t FWaterVolumeRegistry::FindOverlapping(const FVec3& BoxMin, const FVec3& BoxMax, int32_t* OutHandles, int32_t MaxHandles) const
+	{
+		int32_t NumFound = 0;
+		ForEachOverlapping(BoxMin, BoxMax, [&](int32_t Handle)
+		{
+			if (NumFound < MaxHandles)
+			{
+				OutHandles[NumFound] = Handle;
+			}
+			NumFound++;
+		});
+		return NumFound;
+	}
+
+	int32_t FWaterVolumeRegistry::FindBest(const FVec3& BoxMin, const FVec3& BoxMax) const
+	{
+		int32_t Best = -1;
+		float BestArea = 0.0f;
+		ForEachOverlapping(BoxMin, BoxMax, [&](int32_t Handle)
+		{
+			const FWaterVolume& Volume = Slots[Handle].Volume;
+			const float Area = (Volume.BoundsMax.X - Volume.BoundsMin.X) * (Volume.BoundsMax.Y - Volume.BoundsMin.Y);
+			const int32_t BestPriority = Best >= 0 ? Slots[Best].Volume.Priority : 0;
+			if (Best < 0 || Volume.Priority > BestPriority || (Volume.Priority == BestPriority && (Area < BestArea || (Area == BestArea && Handle < Best))))
+			{
+				Best = Handle;
+				BestArea = Area;
+			}
+		});
+		return Best;
+	}
+}
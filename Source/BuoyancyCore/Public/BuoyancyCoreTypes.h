@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+//Set by UnrealBuildTool when compiled as an engine module, empty for the headless benchmark build
+#ifndef BUOYANCYCORE_API
+#define BUOYANCYCORE_API
+#endif
+
+/**
+ * Engine independent math used by the buoyancy code.
+ * Mirrors the bits of FVector / FTransform we need so the hull clipping can run without UObjects.
+ */
+namespace BuoyancyCore
+{
+	struct FVec3
+	{
+		float X;
+		float Y;
+		float Z;
+
+		FVec3() : X(0.0f), Y(0.0f), Z(0.0f) {}
+		FVec3(float InX, float InY, float InZ) : X(InX), Y(InY), Z(InZ) {}
+
+		FVec3 operator+(const FVec3& V) const { return FVec3(X + V.X, Y + V.Y, Z + V.Z); }
+		FVec3 operator-(const FVec3& V) const { return FVec3(X - V.X, Y - V.Y, Z - V.Z); }
+		FVec3 operator-() const { return FVec3(-X, -Y, -Z); }
+		FVec3 operator*(float Scale) const { return FVec3(X * Scale, Y * Scale, Z * Scale); }
+		FVec3 operator/(float Scale) const { const float Inv = 1.0f / Scale; return FVec3(X * Inv, Y * Inv, Z * Inv); }
+		FVec3& operator+=(const FVec3& V) { X += V.X; Y += V.Y; Z += V.Z; return *this; }
+		FVec3& operator-=(const FVec3& V) { X -= V.X; Y -= V.Y; Z -= V.Z; return *this; }
+
+		float Size() const { return std::sqrt(X * X + Y * Y + Z * Z); }
+		float SizeSquared() const { return X * X + Y * Y + Z * Z; }
+
+		static float Dot(const FVec3& A, const FVec3& B) { return A.X * B.X + A.Y * B.Y + A.Z * B.Z; }
+		static FVec3 Cross(const FVec3& A, const FVec3& B)
+		{
+			return FVec3(A.Y * B.Z - A.Z * B.Y, A.Z * B.X - A.X * B.Z, A.X * B.Y - A.Y * B.X);
+		}
+		static float Distance(const FVec3& A, const FVec3& B) { return (A - B).Size(); }
+
+		//Same as FVector::GetClampedToSize
+		FVec3 GetClampedToSize(float Min, float Max) const
+		{
+			float VecSize = Size();
+			const FVec3 VecDir = (VecSize > 1.e-8f) ? (*this / VecSize) : FVec3();
+			VecSize = VecSize < Min ? Min : (VecSize > Max ? Max : VecSize);
+			return VecDir * VecSize;
+		}
+	};
+
+	inline FVec3 operator*(float Scale, const FVec3& V) { return V * Scale; }
+
+	/**
+	 * Affine local to world transform, stored as the three rows of a 3x4 matrix so
+	 * World.X = M[0][0] * x + M[0][1] * y + M[0][2] * z + M[0][3] etc.
+	 * Built once per frame from the component transform (rotation, scale and translation baked together).
+	 */
+	struct FHullTransform
+	{
+		float M[3][4];
+
+		FHullTransform()
+		{
+			for (int Row = 0; Row < 3; Row++)
+			{
+				for (int Col = 0; Col < 4; Col++)
+				{
+					M[Row][Col] = Row == Col ? 1.0f : 0.0f;
+				}
+			}
+		}
+
+		FVec3 TransformPosition(const FVec3& P) const
+		{
+			return FVec3(
+				M[0][0] * P.X + M[0][1] * P.Y + M[0][2] * P.Z + M[0][3],
+				M[1][0] * P.X + M[1][1] * P.Y + M[1][2] * P.Z + M[1][3],
+				M[2][0] * P.X + M[2][1] * P.Y + M[2][2] * P.Z + M[2][3]);
+		}
+
+		FVec3 TransformVector(const FVec3& V) const
+		{
+			return FVec3(
+				M[0][0] * V.X + M[0][1] * V.Y + M[0][2] * V.Z,
+				M[1][0] * V.X + M[1][1] * V.Y + M[1][2] * V.Z,
+				M[2][0] * V.X + M[2][1] * V.Y + M[2][2] * V.Z);
+		}
+
+		FVec3 GetOrigin() const { return FVec3(M[0][3], M[1][3], M[2][3]); }
+
+		//Of the linear part, how much the transform scales volumes
+		float GetDeterminant() const
+		{
+			return M[0][0] * (M[1][1] * M[2][2] - M[1][2] * M[2][1]) - M[0][1] * (M[1][0] * M[2][2] - M[1][2] * M[2][0]) + M[0][2] * (M[1][0] * M[2][1] - M[1][1] * M[2][0]);
+		}
+	};
+}
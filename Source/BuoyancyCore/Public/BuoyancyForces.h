@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "BuoyancyCoreTypes.h"
+
+namespace BuoyancyCore
+{
+	//How the clipped hull is turned into a force
+	enum class EBuoyancyModel : uint8_t
+	{
+		//Water pressure on every under water triangle, see BuoyancyForce
+		Pressure,
+		//Weight of the displaced water at its centroid, from the volume the under water triangles close off (divergence theorem)
+		DisplacedVolume
+	};
+
+	/**
+	 * Forces from the water moving along the hull, see https://www.habrador.com/tutorials/unity-boat-tutorial/5-resistance-forces/
+	 * Every under water triangle moves with the velocity of the body at its center, LinearVelocity + AngularVelocity x (Center - CenterOfMass).
+	 */
+	struct FHydrodynamicParams
+	{
+		bool bEnabled = false;
+		//Of the body in world space, the angular one in radians per second
+		FVec3 LinearVelocity;
+		FVec3 AngularVelocity;
+
+		//Skin friction against the flow along the triangles, see ViscousResistanceCoefficient
+		float ResistanceCoefficient = 0.0f;
+
+		//Drag on triangles moving into the water, (Linear * V + Quadratic * V^2) * Area * Cos^Falloff with V the speed over
+		//ReferenceSpeed and Cos the cosine between the triangle's velocity and normal
+		float PressureDragLinear = 10.0f;
+		float PressureDragQuadratic = 10.0f;
+		float PressureDragFalloff = 0.5f;
+		//Same for the suction on triangles moving away from the water
+		float SuctionDragLinear = 10.0f;
+		float SuctionDragQuadratic = 10.0f;
+		float SuctionDragFalloff = 0.5f;
+		float ReferenceSpeed = 100.0f;
+
+		//Slamming, the force it takes to stop the water a triangle runs into. Needs the time since the last frame and the
+		//body's mass, it is off while either is 0
+		float DeltaTime = 0.0f;
+		float Mass = 0.0f;
+		//How fast the submerged area times velocity of a hull triangle has to change for the full stopping force,
+		//below it the force is scaled by (Change / MaxSlammingAcceleration)^SlammingPower
+		float MaxSlammingAcceleration = 1000.0f;
+		float SlammingPower = 2.0f;
+
+		bool HasSlamming() const { return DeltaTime > 0.0f && Mass > 0.0f && MaxSlammingAcceleration > 0.0f; }
+	};
+
+	//Everything the force calculation needs to know about the body and the water
+	struct FBuoyancyParams
+	{
+		EBuoyancyModel Model = EBuoyancyModel::Pressure;
+		//Note RHO of water in real life is normally 1000kg/m^3
+		float WaterDensity = 1.0f;
+		//World gravity, negative like UWorld::GetGravityZ
+		float GravityZ = -980.0f;
+		//World space center of mass, the torque is taken about this point
+		FVec3 CenterOfMass;
+		//Drag and slamming, summed in the same pass as the buoyancy
+		FHydrodynamicParams Hydrodynamics;
+	};
+
+	//Net force and torque of all under water triangles, applied with one AddForce and one AddTorque
+	struct FBuoyancyWrench
+	{
+		FVec3 Force;
+		FVec3 Torque;
+
+		void Add(const FVec3& InForce, const FVec3& Location, const FVec3& CenterOfMass)
+		{
+			Force += InForce;
+			Torque += FVec3::Cross(Location - CenterOfMass, InForce);
+		}
+	};
+
+	//Archimedes, the weight of Volume of water pushing up at CenterOfBuoyancy
+	inline void AddDisplacedVolume(FBuoyancyWrench& Wrench, float Rho, float GravityZ, float Volume, const FVec3& CenterOfBuoyancy, const FVec3& CenterOfMass)
+	{
+		Wrench.Add(FVec3(0.0f, 0.0f, -Rho * GravityZ * Volume), CenterOfBuoyancy, CenterOfMass);
+	}
+
+	// found here formula found here https://www.habrador.com/tutorials/unity-boat-tutorial/3-buoyancy/
+	// F_buoyancy = rho * g * V, with V = z * S * n (distance to surface, surface area, normal)
+	inline FVec3 BuoyancyForce(float Rho, float GravityZ, float DistanceToSurface, float Area, const FVec3& Normal)
+	{
+		FVec3 Force = Normal * (Rho * GravityZ * DistanceToSurface * Area);
+
+		//The vertical component of the hydrostatic forces don't cancel out but the horizontal do
+		Force.X = 0.0f;
+		Force.Y = 0.0f;
+
+		return Force;
+	}
+
+	//std::pow for the exponents the defaults use is most of the cost of the drag, those are done by hand
+	inline float PowFast(float Base, float Exponent)
+	{
+		if (Exponent == 0.5f)
+		{
+			return std::sqrt(Base);
+		}
+		if (Exponent == 1.0f)
+		{
+			return Base;
+		}
+		if (Exponent == 2.0f)
+		{
+			return Base * Base;
+		}
+		return std::pow(Base, Exponent);
+	}
+
+	//Frictional resistance coefficient of the ITTC 1957 line, Cf = 0.075 / (log10(Rn) - 2)^2 with the Reynolds number Rn = Speed * Length / KinematicViscosity.
+	//Water is about 0.01 cm^2/s. Reynolds numbers under 1000, where the line stops making sense, are taken as 1000
+	inline float ViscousResistanceCoefficient(float Speed, float Length, float KinematicViscosity)
+	{
+		const float Reynolds = KinematicViscosity > 0.0f ? Speed * Length / KinematicViscosity : 0.0f;
+		const float LogTerm = std::log10(Reynolds > 1000.0f ? Reynolds : 1000.0f) - 2.0f;
+		return 0.075f / (LogTerm * LogTerm);
+	}
+
+	//F = 0.5 * rho * Cf * S * |v|^2 against the part of the velocity along the triangle, NormalSpeed is Dot(Velocity, Normal)
+	inline FVec3 ViscousResistanceForce(float Rho, float Coefficient, const FVec3& Velocity, float NormalSpeed, const FVec3& Normal, float Area)
+	{
+		const float SpeedSquared = Velocity.SizeSquared();
+		const float TangentSquared = SpeedSquared - NormalSpeed * NormalSpeed;
+		if (TangentSquared <= 1.e-8f)
+		{
+			return FVec3();
+		}
+		return (Velocity - Normal * NormalSpeed) * (-0.5f * Rho * Coefficient * Area * SpeedSquared / std::sqrt(TangentSquared));
+	}
+
+	//Pressure drag along the normal, or suction against it, Speed and CosTheta are of the triangle's velocity.
+	//Picks the coefficients instead of branching, which side a triangle faces is close to random along the hull
+	inline FVec3 PressureDragForce(const FHydrodynamicParams& Params, float Speed, float CosTheta, const FVec3& Normal, float Area)
+	{
+		const float V = Speed / Params.ReferenceSpeed;
+		const bool bPressure = CosTheta > 0.0f;
+		const float Linear = bPressure ? -Params.PressureDragLinear : Params.SuctionDragLinear;
+		const float Quadratic = bPressure ? -Params.PressureDragQuadratic : Params.SuctionDragQuadratic;
+		const float Falloff = bPressure ? Params.PressureDragFalloff : Params.SuctionDragFalloff;
+		return Normal * ((Linear * V + Quadratic * V * V) * Area * PowFast(std::fabs(CosTheta), Falloff));
+	}
+
+	//Slamming on a triangle moving into the water, the stopping force Mass * Velocity * 2 * Area / HullArea scaled by how
+	//fast the wet area of its hull triangle changes (Acceleration) and by CosTheta
+	inline FVec3 SlammingForce(const FHydrodynamicParams& Params, float Acceleration, float CosTheta, const FVec3& Velocity, float Area, float HullArea)
+	{
+		if (CosTheta <= 0.0f || HullArea <= 0.0f)
+		{
+			return FVec3();
+		}
+		const float Ratio = Acceleration / Params.MaxSlammingAcceleration;
+		const float Scale = Ratio >= 1.0f ? 1.0f : PowFast(Ratio, Params.SlammingPower);
+		return Velocity * (-Scale * CosTheta * Params.Mass * 2.0f * Area / HullArea);
+	}
+}
@@ -0,0 +1,168 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+
+/**
+ * Picks the widest vector instruction set the compiler is allowed to use.
+ * Decided at compile time: UnrealBuildTool builds x64 with SSE2 (AVX2 when bUseAVX / -mavx2 is on), ARM64 always has NEON.
+ * Define BUOYANCY_SIMD_DISABLED to force the scalar paths, handy when checking the kernels against each other.
+ */
+#if defined(BUOYANCY_SIMD_DISABLED)
+	#define BUOYANCY_SIMD_AVX2 0
+	#define BUOYANCY_SIMD_SSE 0
+	#define BUOYANCY_SIMD_NEON 0
+#elif defined(__AVX2__)
+	#define BUOYANCY_SIMD_AVX2 1
+	#define BUOYANCY_SIMD_SSE 1
+	#define BUOYANCY_SIMD_NEON 0
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define BUOYANCY_SIMD_AVX2 0
+	#define BUOYANCY_SIMD_SSE 1
+	#define BUOYANCY_SIMD_NEON 0
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+	#define BUOYANCY_SIMD_AVX2 0
+	#define BUOYANCY_SIMD_SSE 0
+	#define BUOYANCY_SIMD_NEON 1
+#else
+	#define BUOYANCY_SIMD_AVX2 0
+	#define BUOYANCY_SIMD_SSE 0
+	#define BUOYANCY_SIMD_NEON 0
+#endif
+
+#if BUOYANCY_SIMD_AVX2 || BUOYANCY_SIMD_SSE
+	#include <immintrin.h>
+#elif BUOYANCY_SIMD_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace BuoyancyCore
+{
+	//Number of floats the kernels process per iteration, SoA streams are padded to a multiple of this
+	constexpr int32_t SimdLaneCount = 8;
+
+	inline int32_t PadToSimdLanes(int32_t Num)
+	{
+		return (Num + SimdLaneCount - 1) & ~(SimdLaneCount - 1);
+	}
+
+	//Name of the active kernel, reported by the benchmark
+	inline const char* GetSimdName()
+	{
+#if BUOYANCY_SIMD_AVX2
+		return "AVX2";
+#elif BUOYANCY_SIMD_SSE
+		return "SSE";
+#elif BUOYANCY_SIMD_NEON
+		return "NEON";
+#else
+		return "Scalar";
+#endif
+	}
+
+	/**
+	 * Thin wrapper over one vector register for kernels that are mostly arithmetic (the wave evaluators),
+	 * so the math is written once instead of once per instruction set. Width floats per register, 1 for scalar.
+	 * Hot loops that are mostly loads and stores (transform, classify) keep their hand written intrinsics.
+	 */
+	struct FSimdFloat
+	{
+#if BUOYANCY_SIMD_AVX2
+		static constexpr int32_t Width = 8;
+		__m256 V;
+
+		static FSimdFloat Load(const float* Src) { return { _mm256_loadu_ps(Src) }; }
+		static FSimdFloat Splat(float Value) { return { _mm256_set1_ps(Value) }; }
+		void Store(float* Dst) const { _mm256_storeu_ps(Dst, V); }
+
+		friend FSimdFloat operator+(FSimdFloat A, FSimdFloat B) { return { _mm256_add_ps(A.V, B.V) }; }
+		friend FSimdFloat operator-(FSimdFloat A, FSimdFloat B) { return { _mm256_sub_ps(A.V, B.V) }; }
+		friend FSimdFloat operator*(FSimdFloat A, FSimdFloat B) { return { _mm256_mul_ps(A.V, B.V) }; }
+		static FSimdFloat Min(FSimdFloat A, FSimdFloat B) { return { _mm256_min_ps(A.V, B.V) }; }
+		static FSimdFloat Max(FSimdFloat A, FSimdFloat B) { return { _mm256_max_ps(A.V, B.V) }; }
+		static FSimdFloat Round(FSimdFloat A) { return { _mm256_round_ps(A.V, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC) }; }
+#elif BUOYANCY_SIMD_SSE
+		static constexpr int32_t Width = 4;
+		__m128 V;
+
+		static FSimdFloat Load(const float* Src) { return { _mm_loadu_ps(Src) }; }
+		static FSimdFloat Splat(float Value) { return { _mm_set1_ps(Value) }; }
+		void Store(float* Dst) const { _mm_storeu_ps(Dst, V); }
+
+		friend FSimdFloat operator+(FSimdFloat A, FSimdFloat B) { return { _mm_add_ps(A.V, B.V) }; }
+		friend FSimdFloat operator-(FSimdFloat A, FSimdFloat B) { return { _mm_sub_ps(A.V, B.V) }; }
+		friend FSimdFloat operator*(FSimdFloat A, FSimdFloat B) { return { _mm_mul_ps(A.V, B.V) }; }
+		static FSimdFloat Min(FSimdFloat A, FSimdFloat B) { return { _mm_min_ps(A.V, B.V) }; }
+		static FSimdFloat Max(FSimdFloat A, FSimdFloat B) { return { _mm_max_ps(A.V, B.V) }; }
+		//SSE2 has no round instruction, the int conversion rounds to nearest. Only valid for |A| < 2^31
+		static FSimdFloat Round(FSimdFloat A) { return { _mm_cvtepi32_ps(_mm_cvtps_epi32(A.V)) }; }
+#elif BUOYANCY_SIMD_NEON
+		static constexpr int32_t Width = 4;
+		float32x4_t V;
+
+		static FSimdFloat Load(const float* Src) { return { vld1q_f32(Src) }; }
+		static FSimdFloat Splat(float Value) { return { vdupq_n_f32(Value) }; }
+		void Store(float* Dst) const { vst1q_f32(Dst, V); }
+
+		friend FSimdFloat operator+(FSimdFloat A, FSimdFloat B) { return { vaddq_f32(A.V, B.V) }; }
+		friend FSimdFloat operator-(FSimdFloat A, FSimdFloat B) { return { vsubq_f32(A.V, B.V) }; }
+		friend FSimdFloat operator*(FSimdFloat A, FSimdFloat B) { return { vmulq_f32(A.V, B.V) }; }
+		static FSimdFloat Min(FSimdFloat A, FSimdFloat B) { return { vminq_f32(A.V, B.V) }; }
+		static FSimdFloat Max(FSimdFloat A, FSimdFloat B) { return { vmaxq_f32(A.V, B.V) }; }
+		//floor(A + 0.5) from a truncating conversion (vrndnq is ARMv8 only). Only valid for |A| < 2^31
+		static FSimdFloat Round(FSimdFloat A)
+		{
+			const float32x4_t Half = vaddq_f32(A.V, vdupq_n_f32(0.5f));
+			const float32x4_t Truncated = vcvtq_f32_s32(vcvtq_s32_f32(Half));
+			const uint32x4_t TooBig = vcgtq_f32(Truncated, Half);
+			return { vsubq_f32(Truncated, vreinterpretq_f32_u32(vandq_u32(TooBig, vreinterpretq_u32_f32(vdupq_n_f32(1.0f))))) };
+		}
+#else
+		static constexpr int32_t Width = 1;
+		float V;
+
+		static FSimdFloat Load(const float* Src) { return { *Src }; }
+		static FSimdFloat Splat(float Value) { return { Value }; }
+		void Store(float* Dst) const { *Dst = V; }
+
+		friend FSimdFloat operator+(FSimdFloat A, FSimdFloat B) { return { A.V + B.V }; }
+		friend FSimdFloat operator-(FSimdFloat A, FSimdFloat B) { return { A.V - B.V }; }
+		friend FSimdFloat operator*(FSimdFloat A, FSimdFloat B) { return { A.V * B.V }; }
+		static FSimdFloat Min(FSimdFloat A, FSimdFloat B) { return { A.V < B.V ? A.V : B.V }; }
+		static FSimdFloat Max(FSimdFloat A, FSimdFloat B) { return { A.V > B.V ? A.V : B.V }; }
+		static FSimdFloat Round(FSimdFloat A) { return { std::floor(A.V + 0.5f) }; }
+#endif
+	};
+
+	static_assert(SimdLaneCount % FSimdFloat::Width == 0, "Padded streams must hold a whole number of registers");
+
+	/**
+	 * Sine of every lane with no table and no branch: the angle is reduced to [-pi, pi], folded into
+	 * [-pi/2, pi/2] with min/max and fed to a degree 11 polynomial (error around 1e-7).
+	 * Meant for wave phases, which stay well inside the range where the reduction is exact enough.
+	 */
+	inline FSimdFloat Sin(FSimdFloat Angle)
+	{
+		const FSimdFloat Pi = FSimdFloat::Splat(3.14159265f);
+
+		//A - 2pi * round(A / 2pi) is in [-pi, pi], then sin(A) = sin(pi - A) = sin(-pi - A) puts it in [-pi/2, pi/2]
+		const FSimdFloat R = Angle - FSimdFloat::Splat(6.28318531f) * FSimdFloat::Round(Angle * FSimdFloat::Splat(0.159154943f));
+		const FSimdFloat F = FSimdFloat::Max(FSimdFloat::Min(R, Pi - R), FSimdFloat::Splat(0.0f) - Pi - R);
+
+		const FSimdFloat F2 = F * F;
+		FSimdFloat P = FSimdFloat::Splat(-2.50521084e-8f);
+		P = P * F2 + FSimdFloat::Splat(2.75573192e-6f);
+		P = P * F2 + FSimdFloat::Splat(-1.98412698e-4f);
+		P = P * F2 + FSimdFloat::Splat(8.33333333e-3f);
+		P = P * F2 + FSimdFloat::Splat(-1.66666667e-1f);
+		P = P * F2 + FSimdFloat::Splat(1.0f);
+		return P * F;
+	}
+
+	inline FSimdFloat Cos(FSimdFloat Angle)
+	{
+		return Sin(Angle + FSimdFloat::Splat(1.57079633f));
+	}
+}
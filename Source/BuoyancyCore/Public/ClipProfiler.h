@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "BuoyancyCoreTypes.h"
+
+namespace BuoyancyCore
+{
+	//The parts of a FHullClipper step, in the order they run
+	enum class EClipStage : uint8_t
+	{
+		//Vertices to world space (or the water plane to local space) and the water height under every vertex
+		Transform,
+		//Vertex signs, bounds tree walk and the coherent band
+		Classify,
+		//Cutting the triangles at the waterline
+		Clip,
+		//Center, normal and area of the under water triangles and the force sum, or the displaced volume fast path
+		Integrate,
+		Num
+	};
+
+	/**
+	 * Told when each stage of a clip starts and ends, for engine profilers. Stages never nest, a step may enter the same
+	 * stage more than once. Called on whatever thread the clip runs on, one shared by several clippers has to be thread safe.
+	 */
+	class BUOYANCYCORE_API IClipProfiler
+	{
+	public:
+		virtual ~IClipProfiler() {}
+
+		virtual void BeginStage(EClipStage Stage) = 0;
+		virtual void EndStage(EClipStage Stage) = 0;
+	};
+
+	//Reports one stage to a profiler for as long as it lives, one pointer test without a profiler
+	class FClipStageScope
+	{
+	public:
+		FClipStageScope(IClipProfiler* InProfiler, EClipStage InStage)
+			: Profiler(InProfiler)
+			, Stage(InStage)
+		{
+			if (Profiler)
+			{
+				Profiler->BeginStage(Stage);
+			}
+		}
+		~FClipStageScope()
+		{
+			if (Profiler)
+			{
+				Profiler->EndStage(Stage);
+			}
+		}
+
+	private:
+		IClipProfiler* const Profiler;
+		const EClipStage Stage;
+	};
+}
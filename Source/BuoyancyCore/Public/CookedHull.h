@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "HullSimplifier.h"
+#include "HullBoundsTree.h"
+#include <cstddef>
+#include <vector>
+
+namespace BuoyancyCore
+{
+	//"BHUL" read as a little endian uint32, also catches data written on a big endian machine
+	constexpr uint32_t CookedHullMagic = 0x4C554842;
+	//Bump whenever the layout or what the cooker does changes, older data is ignored and the hull is read from PhysX again
+	constexpr uint32_t CookedHullVersion = 5;
+	//Proxies (see BuildProxyHull) that can be cooked after a hull
+	constexpr int32_t MaxCookedProxies = 2;
+
+	/**
+	 * Start of a cooked hull. Every section after it starts on a 16 byte boundary, offsets are in bytes
+	 * from the start of the header. The vertices are stored the way FVertexStream keeps them (one zero
+	 * padded array per component) so loading them is a copy of three blocks, the bounds tree is stored as it is in memory too.
+	 * The proxies follow the hull's own sections as whole cooked hulls of their own, each with its own header.
+	 */
+	struct FCookedHullHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t TotalSize;
+		int32_t NumVertices;
+		//PadToSimdLanes(NumVertices) at cook time, the data is rejected if the padding changed since
+		int32_t PaddedNumVertices;
+		int32_t NumIndexes;
+		//Of the welded hull, see ComputeVolumeAndCentroid
+		float Volume;
+		float CentroidX;
+		float CentroidY;
+		float CentroidZ;
+		//The rest of what FHullTopology derives from the vertices, so loading doesn't have to touch every one of them
+		float BoundingRadius;
+		float BoundsMinX;
+		float BoundsMinY;
+		float BoundsMinZ;
+		float BoundsMaxX;
+		float BoundsMaxY;
+		float BoundsMaxZ;
+		float SurfaceArea;
+		uint32_t VertexXOffset;
+		uint32_t VertexYOffset;
+		uint32_t VertexZOffset;
+		uint32_t IndexOffset;
+		//Per triangle area, in local space like the vertices
+		uint32_t TriangleAreaOffset;
+		//FHullBoundsTree as it is in memory, no nodes for hulls too small to get one. The tree triangles are
+		//NumIndexes / 3 triangle indexes when there are nodes
+		int32_t NumTreeNodes;
+		uint32_t TreeNodeOffset;
+		uint32_t TreeTriangleOffset;
+		//Past TotalSize, 0 for none. Always 0 in a proxy
+		uint32_t ProxyOffsets[MaxCookedProxies];
+		//Only set in a proxy, the FHullSimplifySettings it was built with
+		int32_t ProxyTargetTriangles;
+		float ProxyMaxVolumeError;
+		float ProxyMaxCentroidError;
+	};
+
+	//Points into cooked data without copying it, only valid as long as the data is
+	struct BUOYANCYCORE_API FCookedHullView
+	{
+		const FCookedHullHeader* Header = nullptr;
+		const float* X = nullptr;
+		const float* Y = nullptr;
+		const float* Z = nullptr;
+		const int32_t* Indexes = nullptr;
+		const float* TriangleAreas = nullptr;
+		const FHullBoundsNode* TreeNodes = nullptr;
+		const int32_t* TreeTriangles = nullptr;
+		//Headers of the proxies cooked after the hull, already checked by ReadCookedHull
+		const FCookedHullHeader* Proxies[MaxCookedProxies] = {};
+
+		bool IsValid() const { return Header != nullptr; }
+		int32_t GetNumVertices() const { return Header->NumVertices; }
+		int32_t GetPaddedNumVertices() const { return Header->PaddedNumVertices; }
+		int32_t GetNumIndexes() const { return Header->NumIndexes; }
+		int32_t GetNumTriangles() const { return Header->NumIndexes / 3; }
+		int32_t GetNumTreeNodes() const { return Header->NumTreeNodes; }
+		FVec3 GetVertex(int32_t Index) const { return FVec3(X[Index], Y[Index], Z[Index]); }
+		//Copies the hull back out, for tools and for building proxies
+		void ToHullMesh(FHullMesh& OutMesh) const;
+		//View into the proxy cooked with the target and error limits of Settings, false when there is none
+		bool FindProxy(const FHullSimplifySettings& Settings, FCookedHullView& OutProxy) const;
+	};
+
+	//SimplifyHull and then OptimizeHull with the default settings, how every proxy is built whether it is cooked or not.
+	//Meant for preprocessing, it allocates freely
+	BUOYANCYCORE_API void BuildProxyHull(const FHullMesh& Source, const FHullSimplifySettings& Settings, FHullMesh& OutMesh, FHullSimplifyResult& OutResult);
+
+	//Welds and reorders Source (see OptimizeHull) and writes it in the cooked format to OutData, replacing what was there
+	BUOYANCYCORE_API void CookHull(const FHullMesh& Source, float WeldDistance, std::vector<uint8_t>& OutData);
+	//Same, and cooks a proxy of the welded hull after it for each of the NumProxies (at most MaxCookedProxies) ProxySettings
+	BUOYANCYCORE_API void CookHull(const FHullMesh& Source, float WeldDistance, const FHullSimplifySettings* ProxySettings, int32_t NumProxies, std::vector<uint8_t>& OutData);
+
+	/**
+	 * Checks the header and every section of Data and of the proxies after it and points OutView into it, no per element work.
+	 * Returns false (and leaves OutView invalid) for anything that is not cooked hull data of this version,
+	 * so callers can fall back to reading the collision mesh. Data must be at least 4 byte aligned.
+	 */
+	BUOYANCYCORE_API bool ReadCookedHull(const void* Data, size_t Size, FCookedHullView& OutView);
+}
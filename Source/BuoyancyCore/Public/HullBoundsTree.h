@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "BuoyancyCoreTypes.h"
+#include "VertexStream.h"
+#include <vector>
+
+namespace BuoyancyCore
+{
+	//One box of FHullBoundsTree, in the hull's local space
+	struct FHullBoundsNode
+	{
+		FVec3 Min;
+		FVec3 Max;
+		//Every node covers Triangles[FirstTriangle, FirstTriangle + NumTriangles) of the tree, children included
+		int32_t FirstTriangle;
+		int32_t NumTriangles;
+		//The first child is the next node, this is the second one, -1 for a leaf
+		int32_t SecondChild;
+
+		bool IsLeaf() const { return SecondChild < 0; }
+	};
+
+	/**
+	 * Bounding box hierarchy over the triangles of a hull, built once in local space. The triangles are kept
+	 * in tree order so every node, not just the leaves, covers one contiguous range of them: a node that is
+	 * entirely above or below the water takes all of its triangles in one go.
+	 * Lets FHullClipper only classify the triangles near the waterline.
+	 */
+	struct BUOYANCYCORE_API FHullBoundsTree
+	{
+		//Depth first, the root is node 0
+		std::vector<FHullBoundsNode> Nodes;
+		//Triangle indexes of the hull in tree order
+		std::vector<int32_t> Triangles;
+
+		//Nodes are split until they hold at most this many triangles
+		static constexpr int32_t MaxLeafTriangles = 16;
+		//Deepest a tree can get, every split halves the triangles so this is never reached for a 32 bit triangle count
+		static constexpr int32_t MaxDepth = 64;
+
+		bool IsEmpty() const { return Nodes.empty(); }
+		size_t GetAllocatedSize() const { return Nodes.capacity() * sizeof(FHullBoundsNode) + Triangles.capacity() * sizeof(int32_t); }
+
+		//Replaces the tree with one over the NumIndexes / 3 triangles, left empty for hulls that fit in a single leaf
+		void Build(const FVertexStream& Vertices, const int32_t* TriangleIndexes, int32_t NumIndexes);
+	};
+}
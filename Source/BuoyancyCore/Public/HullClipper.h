@@ -0,0 +1,249 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "BuoyancyCoreTypes.h"
+#include "VertexStream.h"
+#include "BuoyancyForces.h"
+#include "WaterSurface.h"
+#include "HullTopology.h"
+#include "ClipProfiler.h"
+#include <memory>
+#include <vector>
+
+namespace BuoyancyCore
+{
+	//Engine independent version of FTriangleData, one triangle of the part of the hull that is under water
+	struct BUOYANCYCORE_API FUnderWaterTriangle
+	{
+		FVec3 P1;
+		FVec3 P2;
+		FVec3 P3;
+		FVec3 Center;
+		//Signed height of P1, P2, P3 above the water, cut points are on the surface so theirs is 0
+		float CornerDistances[3];
+		//Depth of the center below the water
+		float DistanceToSurface;
+		FVec3 Normal;
+		float Area;
+
+		//Calculates center, normal, area etc, this is what the FTriangleData constructor used to do.
+		//Without a water surface to go on the depths are taken against the plane Z = 0
+		static FUnderWaterTriangle Make(const FVec3& P1, const FVec3& P2, const FVec3& P3);
+
+		//Same as Make but for a triangle whose corners are already filled in
+		void UpdateDerivedData();
+	};
+
+	//Thresholds of FHullClipper::GenerateUnderWaterMeshCoherent, all in cm
+	struct FClipCoherenceSettings
+	{
+		//The last result is reused as it is while no vertex has moved further than this since it was computed...
+		float SkipMovement = 0.5f;
+		//...and no vertex depth has changed by more than this, which covers the water moving as well
+		float SkipDepthChange = 0.5f;
+		//While no vertex depth has changed by more than this since the last full clip, the triangles that were
+		//at least this far above the water then are known to still be dry and are skipped
+		float BandMargin = 10.0f;
+	};
+
+	//What the last GenerateUnderWaterMeshCoherent did
+	enum class EClipPath : uint8_t
+	{
+		Full,
+		//Only the triangles near or below the waterline of the last full clip
+		Band,
+		//Reused the last result. Never taken with the hydrodynamic forces on
+		Skipped
+	};
+
+	/**
+	 * Cuts a closed triangle hull against the water surface and keeps the triangles that are below it.
+	 * The surface is sampled once per vertex with one batched IWaterSurface query, between vertices it is
+	 * taken as linear. Without a surface the water is the plane Z = 0 in world space.
+	 * Full clips walk the hull's FHullBoundsTree first, so only the triangles near the waterline are classified
+	 * one by one, boxes that are entirely dry are skipped and entirely submerged ones are taken whole.
+	 * Shares the local hull (see FHullTopology) and owns the per frame scratch buffers, which are all sized for the worst
+	 * case once in SetHull. None of the clips allocate after that.
+	 */
+	class BUOYANCYCORE_API FHullClipper
+	{
+	public:
+		//Clips this hull from now on, only the scratch buffers are allocated
+		void SetHull(std::shared_ptr<const FHullTopology> InHull);
+		//Makes an unshared hull from a copy of the local space hull, TriangleIndexes holds 3 indexes per triangle
+		void SetHull(const FVec3* LocalVertices, int32_t NumVertices, const int32_t* TriangleIndexes, int32_t NumIndexes);
+		const std::shared_ptr<const FHullTopology>& GetHull() const { return Hull; }
+		//Drops what the next clip would take from the earlier ones (classification, coherent and slamming state) without
+		//touching the scratch buffers, for a clipper that is used again after it sat idle for a while
+		void ForgetHistory();
+
+		//Surface to clip against from now on and the time to sample it at, nullptr for the plane Z = 0. Not owned
+		void SetWaterSurface(const IWaterSurface* Surface, float Time);
+		//Told about every stage of the following clips, nullptr for none. Not owned
+		void SetProfiler(IClipProfiler* InProfiler) { Profiler = InProfiler; }
+
+		//Transforms the hull to world space and rebuilds the list of under water triangles
+		void GenerateUnderWaterMesh(const FHullTransform& LocalToWorld);
+
+		/**
+		 * Same as above but also sums the buoyancy of every triangle into one force and torque while finishing the triangles,
+		 * and with Params.Hydrodynamics enabled the drag and slamming forces in that same loop.
+		 * With EBuoyancyModel::DisplacedVolume a hull entirely above or below the water isn't clipped at all: the force is
+		 * zero or that of the hull's precomputed volume, and there are no under water triangles. Hydrodynamic forces need
+		 * the triangles, so with those a submerged hull is clipped anyway.
+		 */
+		void GenerateUnderWaterMesh(const FHullTransform& LocalToWorld, const FBuoyancyParams& Params, FBuoyancyWrench& OutWrench);
+
+		/**
+		 * Cheaper version for substeps: keeps which triangles were wet and how they were cut in the last
+		 * GenerateUnderWaterMesh and only moves the cut points to the new depths.
+		 * Falls back to a full GenerateUnderWaterMesh when nothing was classified yet.
+		 */
+		void UpdateUnderWaterMesh(const FHullTransform& LocalToWorld, const FBuoyancyParams& Params, FBuoyancyWrench& OutWrench);
+
+		/**
+		 * GenerateUnderWaterMesh for bodies that are almost at rest, gives the same triangles unless it skips.
+		 * A frame where the hull and the water barely moved reuses the last result (triangles, force and torque),
+		 * one where they moved a little only clips the triangles that were near or below the waterline at the
+		 * last full clip. Anything more is a full clip. See FClipCoherenceSettings.
+		 */
+		void GenerateUnderWaterMeshCoherent(const FHullTransform& LocalToWorld, const FBuoyancyParams& Params, const FClipCoherenceSettings& Settings, FBuoyancyWrench& OutWrench);
+		EClipPath GetLastClipPath() const { return LastClipPath; }
+		//The drag and slamming part of the last wrench, zero without hydrodynamics. Taking it out leaves the hydrostatic part,
+		//which unlike drag can be applied again while the body moves on
+		const FBuoyancyWrench& GetLastHydrodynamicWrench() const { return HydrodynamicWrench; }
+
+		/**
+		 * Clips in the hull's own space against a plane fitted to the water around it (see FWaterPlane::Fit), the plane
+		 * is brought into local space once instead of every vertex into world space. The under water triangles come out
+		 * in local space with world depths, and the force is summed there and turned into world space once at the end.
+		 * Same forces as GenerateUnderWaterMesh on flat water for rotation, translation and uniform scale, a non uniform
+		 * scale is treated as the scale along the world up axis.
+		 */
+		void GenerateUnderWaterMeshLocal(const FHullTransform& LocalToWorld, const FBuoyancyParams& Params, FBuoyancyWrench& OutWrench);
+		//Whether the under water triangles are in local space, from GenerateUnderWaterMeshLocal
+		bool IsLocalSpace() const { return bLocalSpace; }
+
+		/**
+		 * No clip at all, for bodies too far away to see what the water does to them. The hull is taken as its local box cut
+		 * into 2 x 2 columns, each holding a quarter of the hull's volume, and every column gets the weight of the water its
+		 * wet part displaces against the plane GenerateUnderWaterMeshLocal uses. That keeps the body floating at about the
+		 * right depth and upright, with no under water triangles and no hydrodynamic forces.
+		 */
+		void GenerateAnalyticForces(const FHullTransform& LocalToWorld, const FBuoyancyParams& Params, FBuoyancyWrench& OutWrench);
+
+		const FUnderWaterTriangle* GetUnderWaterTriangles() const { return UnderWaterTriangles.data(); }
+		int32_t GetNumUnderWaterTriangles() const { return NumUnderWaterTriangles; }
+		//Hull triangle each under water triangle was cut from
+		const int32_t* GetUnderWaterTriangleSources() const { return UnderWaterSources.data(); }
+		//Not updated by GenerateUnderWaterMeshLocal
+		const FVertexStream& GetGlobalVertices() const { return MeshVerticesGlobal; }
+		const std::vector<float>& GetDistancesToWater() const { return AllDistancesToWater; }
+		int32_t GetNumVertices() const { return Hull->GetNumVertices(); }
+		int32_t GetNumTriangles() const { return Hull->GetNumTriangles(); }
+		//Memory held by the scratch buffers, sized in SetHull and never changed by a clip
+		size_t GetScratchSize() const;
+
+	private:
+		std::shared_ptr<const FHullTopology> Hull = FHullTopology::GetEmpty();
+		FVertexStream MeshVerticesGlobal;
+		//The last clip was done on the local vertices instead of MeshVerticesGlobal
+		bool bLocalSpace = false;
+		//Padded like the vertex streams
+		std::vector<float> AllDistancesToWater;
+		//One bit per vertex each, see ClassifyVertices
+		std::vector<uint8_t> AboveWaterBits;
+		std::vector<uint8_t> BelowWaterBits;
+
+		const IWaterSurface* WaterSurface = nullptr;
+		float WaterTime = 0.0f;
+		IClipProfiler* Profiler = nullptr;
+		//Surface height under every vertex, padded like the vertex streams
+		std::vector<float> WaterHeights;
+
+		//Worst case every triangle is cut into 2, plus room for the unused second slot of the last triangle
+		std::vector<FUnderWaterTriangle> UnderWaterTriangles;
+		//Same slots, written next to the triangles
+		std::vector<int32_t> UnderWaterSources;
+		int32_t NumUnderWaterTriangles = 0;
+
+		//Triangles that produced something in the last full clip and their case in the clip table
+		std::vector<int32_t> WetTriangles;
+		std::vector<uint8_t> WetTriangleCases;
+		int32_t NumWetTriangles = 0;
+		//The first NumWetSubmerged of them came whole from AddSubmergedTriangles
+		int32_t NumWetSubmerged = 0;
+		bool bHasClassification = false;
+
+		//Triangles the last FHullBoundsTree walk found entirely under water or not decided, in tree order
+		std::vector<int32_t> SubmergedTriangles;
+		std::vector<int32_t> WaterlineTriangles;
+		int32_t NumSubmergedTriangles = 0;
+		int32_t NumWaterlineTriangles = 0;
+
+		//Sizes everything else after Hull was set
+		void ResetScratchBuffers();
+		//Coherent mode state
+		//Triangles that were not certainly dry at the last full coherent clip, reserved for every triangle
+		std::vector<int32_t> CandidateTriangles;
+		//Depths at the last full coherent clip and at the last computed result, padded like the vertex streams
+		std::vector<float> ReferenceDistances;
+		std::vector<float> ResultDistances;
+		FHullTransform ResultTransform;
+		FBuoyancyWrench ResultWrench;
+		bool bHasCoherentState = false;
+		EClipPath LastClipPath = EClipPath::Full;
+
+		//Slamming state, per hull triangle its submerged area times velocity and the frame that was in, so triangles
+		//that were dry last frame count as 0
+		std::vector<FVec3> SlammingFlux;
+		std::vector<uint32_t> SlammingFrames;
+		//Starts past 1 so the zeroed frames above are never the last one
+		uint32_t HydrodynamicFrame = 1;
+		FBuoyancyWrench HydrodynamicWrench;
+		//Moves on to the next frame of slamming state, call once per result that has hydrodynamic forces
+		//Also clears HydrodynamicWrench, every path that makes a wrench calls it first
+		void AdvanceHydrodynamicFrame(const FBuoyancyParams& Params);
+
+		//World positions plus the distance of every vertex to the water
+		void TransformAndMeasure(const FHullTransform& LocalToWorld);
+		void TransformAndClassify(const FHullTransform& LocalToWorld);
+		//Sign of every vertex from AllDistancesToWater, see ClassifyVertices
+		void ClassifyAllVertices();
+		//Writes the corners of the under water part of one triangle to Out (always 2 slots), returns how many are used
+		int32_t ClipTriangle(int32_t Triangle, uint32_t CaseIndex, FUnderWaterTriangle* Out) const;
+		//Clears the under water triangles and clips the whole hull again, after the vertices were classified
+		void ClipTriangles(const FHullTransform& LocalToWorld);
+		//Same with the vertex heights given as Dot(HeightAxis, Local) + HeightOffset and the water anywhere between WaterMin and WaterMax
+		void ClipTriangles(const FVec3& HeightAxis, float HeightOffset, float WaterMin, float WaterMax);
+		//Fills SubmergedTriangles and WaterlineTriangles from the bounds tree, heights and water like ClipTriangles
+		void CullTriangles(const FVec3& HeightAxis, float HeightOffset, float WaterMin, float WaterMax);
+		//Lowest and highest water under the vertices of the last TransformAndMeasure
+		void GetWaterHeightRange(float& OutMin, float& OutMax) const;
+		//Only fill in the corners, the derived data is done by the caller. Both append to the under water triangles.
+		//Clips the NumCandidates triangles in Candidates, or all with nullptr
+		void AddTriangles(const int32_t* Candidates = nullptr, int32_t NumCandidates = 0);
+		//Triangles known to be entirely under water, copied without looking at their vertices' classification
+		void AddSubmergedTriangles(const int32_t* Triangles, int32_t Num);
+		//Writes their corners and sources only
+		void CopySubmergedTriangles(const int32_t* Triangles, int32_t Num, FUnderWaterTriangle* Output, int32_t* Sources) const;
+		//Largest change of a vertex depth between AllDistancesToWater and Other
+		float GetMaxDepthChange(const std::vector<float>& Other) const;
+		void SaveCoherentResult(const FHullTransform& LocalToWorld, const FBuoyancyWrench& Wrench);
+		void UpdateTriangles();
+		//LocalToWorld only for how much it grows the hull's local areas
+		void FinishTriangles(const FHullTransform& LocalToWorld, const FBuoyancyParams& Params, FBuoyancyWrench& OutWrench);
+		//Displaced volume fast paths for a hull entirely above or below the water, from bounds on the vertex heights.
+		//Returns false when the hull might cross the water and has to be clipped
+		bool TryDisplacedVolumeFastPath(const FHullTransform& LocalToWorld, float MinHeight, float MaxHeight, const FBuoyancyParams& Params, FBuoyancyWrench& OutWrench);
+		//Volume the under water triangles close off with the waterline and its centroid, in the space of the triangles
+		void SumDisplacedVolume(float& OutVolume, FVec3& OutCentroid) const;
+		//Height of a local point above the water plane fitted around the hull is Dot(OutHeightAxis, Local) + OutHeightOffset
+		void GetLocalWaterPlane(const FHullTransform& LocalToWorld, FVec3& OutHeightAxis, float& OutHeightOffset) const;
+		//FinishTriangles for local space triangles
+		void FinishTrianglesLocal(const FHullTransform& LocalToWorld, const FBuoyancyParams& Params, FBuoyancyWrench& OutWrench);
+		//What the clip reads the corners from
+		const FVertexStream& GetClipVertices() const { return bLocalSpace ? Hull->Vertices : MeshVerticesGlobal; }
+	};
+}
@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "HullSimplifier.h"
+#include <vector>
+
+namespace BuoyancyCore
+{
+	struct FHullOptimizeSettings
+	{
+		//Vertices closer than this (cm) are merged, see WeldHullVertices
+		float WeldDistance = 0.01f;
+		//Entries of the vertex cache the triangle order is tuned for
+		int32_t VertexCacheSize = 32;
+	};
+
+	//What OptimizeHull removed, the gather misses are counted with CountGatherMisses
+	struct FHullOptimizeReport
+	{
+		//Vertices merged into another one by the weld
+		int32_t NumDuplicateVertices = 0;
+		//Vertices no triangle uses, dropped by the reorder
+		int32_t NumUnusedVertices = 0;
+		//Triangles the weld collapsed
+		int32_t NumDegenerateTriangles = 0;
+		int64_t GatherMissesBefore = 0;
+		int64_t GatherMissesAfter = 0;
+	};
+
+	/**
+	 * Load time layout for the clipper: welds coincident vertices, orders the triangles for a vertex cache
+	 * (Forsyth's linear speed vertex cache optimisation) and then numbers the vertices in the order the triangles
+	 * first use them. The clipper transforms every vertex once and gathers the three corners of every triangle
+	 * from the vertex and distance streams, so after this no vertex is transformed twice and the gathers mostly
+	 * hit lines that were just loaded. Keeps the winding of every triangle. Meant for preprocessing, it allocates freely.
+	 */
+	BUOYANCYCORE_API void OptimizeHull(const FHullMesh& Source, const FHullOptimizeSettings& Settings, FHullMesh& OutMesh, FHullOptimizeReport& OutReport);
+
+	/**
+	 * Cache lines a walk over the triangles in order misses while gathering their corners from one float stream,
+	 * through a first in first out cache of CacheLines 64 byte lines. The clipper gathers from four streams
+	 * (X, Y, Z and the distance to the water) with the same index, so they all miss alike.
+	 */
+	BUOYANCYCORE_API int64_t CountGatherMisses(const std::vector<int32_t>& Indexes, int32_t NumVertices, int32_t CacheLines = 128);
+}
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "BuoyancyCoreTypes.h"
+#include "VertexStream.h"
+#include "BuoyancyForces.h"
+#include "WaterSurface.h"
+#include "HullTopology.h"
+#include "ClipProfiler.h"
+#include <memory>
+#include <vector>
+
+namespace BuoyancyCore
+{
+	struct FPontoonSettings
+	{
+		//Voxels along the longest side of the hull's box, the other sides get as many of the same cubes as it takes to cover them
+		int32_t Resolution = 8;
+	};
+
+	/**
+	 * The hull voxelized into weighted sample points, a cheap stand-in for clipping it. Every voxel that is at least partly
+	 * inside the hull is one pontoon at the center of its inside part, weighted by the volume of that part. The weights add
+	 * up to the hull's volume, so a submerged body gets exactly the clipped force.
+	 * Immutable once built, shared like FHullTopology.
+	 */
+	struct BUOYANCYCORE_API FHullPontoons
+	{
+		//Local positions, padded like every vertex stream
+		FVertexStream Positions;
+		//Local volume of the inside part of every voxel, negative for a hull wound inside out like FHullTopology::Volume
+		std::vector<float> Volumes;
+		//Half height of that inside part, the half width and depth are all CellSize / 2
+		std::vector<float> HalfHeights;
+		float CellSize = 0.0f;
+
+		int32_t GetNum() const { return Positions.Num; }
+		size_t GetAllocatedSize() const;
+
+		//Casts one vertical ray per voxel column through the hull, the inside spans of the ray give the volume in each voxel.
+		//Needs a closed hull, holes let the inside leak out of the columns they are in
+		static std::shared_ptr<const FHullPontoons> Build(const FHullTopology& Hull, const FPontoonSettings& Settings);
+	};
+
+	/**
+	 * Buoyancy from pontoons, O(pontoons) instead of O(triangles): one batched water query for all of them, then every
+	 * pontoon displaces the part of its voxel that is below the water at that point. No under water mesh and no
+	 * hydrodynamic forces. Owns the per frame scratch buffers, sized in SetPontoons.
+	 */
+	class BUOYANCYCORE_API FPontoonSolver
+	{
+	public:
+		void SetPontoons(std::shared_ptr<const FHullPontoons> InPontoons);
+		const std::shared_ptr<const FHullPontoons>& GetPontoons() const { return Pontoons; }
+		//Surface to float on from now on and the time to sample it at, nullptr for the plane Z = 0. Not owned
+		void SetWaterSurface(const IWaterSurface* Surface, float Time);
+		//Told about the transform and integrate stages of every step, nullptr for none. Not owned
+		void SetProfiler(IClipProfiler* InProfiler) { Profiler = InProfiler; }
+
+		//Params.Model and Params.Hydrodynamics are not used
+		void ComputeForces(const FHullTransform& LocalToWorld, const FBuoyancyParams& Params, FBuoyancyWrench& OutWrench);
+		//Memory held by the scratch buffers, doesn't change between SetPontoons calls
+		size_t GetScratchSize() const { return WorldPositions.GetAllocatedSize() + (Heights.capacity() + WaterHeights.capacity()) * sizeof(float); }
+
+	private:
+		std::shared_ptr<const FHullPontoons> Pontoons;
+		FVertexStream WorldPositions;
+		//Height of every pontoon above the water, padded like the streams
+		std::vector<float> Heights;
+		std::vector<float> WaterHeights;
+		const IWaterSurface* WaterSurface = nullptr;
+		float WaterTime = 0.0f;
+		IClipProfiler* Profiler = nullptr;
+	};
+
+	//How far the pontoons are from the clipped hull, see ComparePontoons
+	struct FPontoonErrorReport
+	{
+		int32_t NumPoses = 0;
+		//Force difference over the weight of the water the whole hull displaces, so nearly dry poses don't blow it up
+		float MaxForceError = 0.0f;
+		float MeanForceError = 0.0f;
+		//Torque difference over that weight times the hull's bounding radius
+		float MaxTorqueError = 0.0f;
+		float MeanTorqueError = 0.0f;
+	};
+
+	/**
+	 * Floats the hull on flat water at a range of drafts, pitches and rolls and compares the net force and torque of the
+	 * pontoons against the displaced volume clip of the full hull. Clips the hull dozens of times, meant for load time
+	 * reports and tools rather than for a running game.
+	 */
+	BUOYANCYCORE_API void ComparePontoons(const std::shared_ptr<const FHullTopology>& Hull, const std::shared_ptr<const FHullPontoons>& Pontoons, FPontoonErrorReport& OutReport);
+}
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "BuoyancyCoreTypes.h"
+#include <vector>
+
+namespace BuoyancyCore
+{
+	//Plain indexed triangle mesh, 3 indexes per triangle
+	struct BUOYANCYCORE_API FHullMesh
+	{
+		std::vector<FVec3> Vertices;
+		std::vector<int32_t> Indexes;
+
+		int32_t GetNumTriangles() const { return (int32_t)(Indexes.size() / 3); }
+	};
+
+	/**
+	 * Enclosed volume and its centroid from the divergence theorem, one signed tetrahedron per triangle.
+	 * Exact for a closed mesh, for an open one it is the volume of the cone to the origin.
+	 * OutCentroid is left at the origin when the volume is zero.
+	 */
+	BUOYANCYCORE_API void ComputeVolumeAndCentroid(const FHullMesh& Mesh, float& OutVolume, FVec3& OutCentroid);
+
+	/**
+	 * Merges vertices closer than WeldDistance (on a grid of that size) and drops the triangles that become degenerate.
+	 * Collision meshes repeat a vertex for every split normal or uv seam, this makes the hull one connected surface again.
+	 * Vertices keep the order of their first use, triangles keep their order.
+	 */
+	BUOYANCYCORE_API void WeldHullVertices(const FHullMesh& Source, float WeldDistance, FHullMesh& OutMesh);
+
+	struct FHullSimplifySettings
+	{
+		//Stop once the proxy has this many triangles or fewer
+		int32_t TargetTriangles = 1000;
+		//Largest allowed change of the enclosed volume, as a fraction of the source volume
+		float MaxVolumeError = 0.02f;
+		//Largest allowed movement of the centroid, as a fraction of the source bounding box diagonal
+		float MaxCentroidError = 0.01f;
+		//Vertices closer than this (cm) are merged before simplifying so split normals/uvs don't cut the hull apart
+		float WeldDistance = 0.01f;
+	};
+
+	struct FHullSimplifyResult
+	{
+		FHullMesh Mesh;
+		//Relative errors of the result, same units as the settings
+		float VolumeError = 0.0f;
+		float CentroidError = 0.0f;
+		//False when the error limits stopped it before TargetTriangles
+		bool bReachedTarget = false;
+	};
+
+	/**
+	 * Builds a buoyancy proxy of Source with quadric error edge collapses (Garland and Heckbert).
+	 * Collapses are taken cheapest first and rejected when they would flip a triangle, make the surface
+	 * non manifold or push the enclosed volume or centroid past the limits in Settings, which are checked
+	 * exactly after every collapse since those are what the buoyancy depends on.
+	 * Meant for preprocessing, it allocates freely.
+	 */
+	BUOYANCYCORE_API void SimplifyHull(const FHullMesh& Source, const FHullSimplifySettings& Settings, FHullSimplifyResult& OutResult);
+}
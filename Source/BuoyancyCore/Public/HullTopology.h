@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "VertexStream.h"
+#include "CookedHull.h"
+#include "HullBoundsTree.h"
+#include <memory>
+#include <vector>
+
+namespace BuoyancyCore
+{
+	/**
+	 * The immutable part of a hull: local vertices and triangles. Built once per mesh and shared by every
+	 * clipper floating that mesh, each clipper only owns its per frame scratch buffers.
+	 * Never changed after Make, so it can be read from any number of threads.
+	 */
+	struct BUOYANCYCORE_API FHullTopology
+	{
+		FVertexStream Vertices;
+		//3 indexes per triangle
+		std::vector<int32_t> Triangles;
+		//Largest distance of a vertex from the local origin
+		float BoundingRadius = 0.0f;
+		//Local box around the vertices
+		FVec3 BoundsMin;
+		FVec3 BoundsMax;
+		//Boxes over the triangles for culling them against the water, empty for very small hulls
+		FHullBoundsTree BoundsTree;
+		//Of the whole hull in local space, what a fully submerged body displaces. See ComputeVolumeAndCentroid
+		float Volume = 0.0f;
+		FVec3 Centroid;
+		//Local area of every triangle and of the whole hull, for the slamming forces
+		std::vector<float> TriangleAreas;
+		float SurfaceArea = 0.0f;
+
+		int32_t GetNumVertices() const { return Vertices.Num; }
+		int32_t GetNumTriangles() const { return (int32_t)(Triangles.size() / 3); }
+		//Approximate heap memory held, for the registry's stats
+		size_t GetAllocatedSize() const;
+		//Copies the hull back out, for building proxies
+		void ToHullMesh(FHullMesh& OutMesh) const;
+
+		static std::shared_ptr<const FHullTopology> Make(const FVec3* LocalVertices, int32_t NumVertices, const int32_t* TriangleIndexes, int32_t NumIndexes);
+		//From cooked data, already laid out like the vertex stream so it is copied block by block
+		static std::shared_ptr<const FHullTopology> Make(const FCookedHullView& Hull);
+		//Shared hull with nothing in it, what a clipper has before SetHull
+		static const std::shared_ptr<const FHullTopology>& GetEmpty();
+	};
+}
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "BuoyancyCoreTypes.h"
+#include "BuoyancySimd.h"
+#include <vector>
+
+namespace BuoyancyCore
+{
+	/**
+	 * Structure of arrays vertex store, one contiguous array per component so the transform kernel can
+	 * load 4 or 8 vertices per instruction. The arrays are zero padded to a multiple of SimdLaneCount,
+	 * Num is the real vertex count.
+	 */
+	struct BUOYANCYCORE_API FVertexStream
+	{
+		std::vector<float> X;
+		std::vector<float> Y;
+		std::vector<float> Z;
+		int32_t Num = 0;
+
+		void SetNum(int32_t NewNum);
+		void Set(int32_t Index, const FVec3& V) { X[Index] = V.X; Y[Index] = V.Y; Z[Index] = V.Z; }
+		FVec3 Get(int32_t Index) const { return FVec3(X[Index], Y[Index], Z[Index]); }
+		int32_t GetPaddedNum() const { return (int32_t)X.size(); }
+		size_t GetAllocatedSize() const { return (X.capacity() + Y.capacity() + Z.capacity()) * sizeof(float); }
+	};
+
+	/**
+	 * Transforms every vertex of Local into World and writes the signed height of each vertex above the
+	 * water plane Z = WaterLevel into Distances, all in a single pass over the data.
+	 * World must already have the same size as Local and Distances must hold Local.GetPaddedNum() floats.
+	 */
+	BUOYANCYCORE_API void TransformVerticesAndDistances(const FHullTransform& LocalToWorld, const FVertexStream& Local, float WaterLevel, FVertexStream& World, float* Distances);
+
+	/**
+	 * Distances[i] = Dot(Axis, Local[i]) + Offset for every vertex, padding included. With a world space water plane
+	 * brought into local space this is the height above the water without transforming the vertices.
+	 */
+	BUOYANCYCORE_API void ComputePlaneDistances(const FVertexStream& Local, const FVec3& Axis, float Offset, float* Distances);
+
+	/**
+	 * Packs one bit per vertex for Distance > 0 into AboveBits and one for Distance < 0 into BelowBits,
+	 * vertex i is bit i % 8 of byte i / 8. A vertex exactly on the surface has neither bit set.
+	 * Both arrays must hold PaddedNum / 8 bytes.
+	 */
+	BUOYANCYCORE_API void ClassifyVertices(const float* Distances, int32_t PaddedNum, uint8_t* AboveBits, uint8_t* BelowBits);
+
+	//Reference version of TransformVerticesAndDistances, also used for the tail when SIMD is off
+	BUOYANCYCORE_API void TransformVerticesAndDistancesScalar(const FHullTransform& LocalToWorld, const FVertexStream& Local, float WaterLevel, FVertexStream& World, float* Distances, int32_t Begin, int32_t End);
+}
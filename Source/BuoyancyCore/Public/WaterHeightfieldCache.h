@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "WaterSurface.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+namespace BuoyancyCore
+{
+	/**
+	 * Water surface that samples another one on a grid of fixed resolution tiles and answers queries
+	 * with bilinear interpolation. Meant to be shared by every hull floating on the same water, so the
+	 * expensive surface is evaluated once per grid point per time step instead of once per hull vertex.
+	 *
+	 * Query times are snapped to multiples of TimeStep, so substeps and bodies stepped a little earlier or later in the
+	 * same frame share the tiles instead of each evaluating them again. A tile is built lazily the first time a query
+	 * touches it at a new snapped time, tiles of other times stay until they are the least recently used. That is recycled
+	 * once MaxTiles are in use, so after the first frames nothing is allocated. Hulls on other threads can share it: queries whose tiles are
+	 * all up to date only take a shared lock, building a tile takes the lock exclusively.
+	 */
+	class BUOYANCYCORE_API FWaterHeightfieldCache : public IWaterSurface
+	{
+	public:
+		struct FSettings
+		{
+			//Distance between grid points in cm, keep it well under the shortest wavelength
+			float CellSize = 50.0f;
+			//Cells along each side of a tile
+			int32_t TileResolution = 32;
+			//Tiles kept at once, the least recently used one is rebuilt when a new one is needed. Leave room for two times,
+			//bodies stepped asynchronously sample the end of the last frame while the others sample this one
+			int32_t MaxTiles = 256;
+			//Seconds the query times are snapped to, the water lags or leads by up to half of it. 0 samples every time exactly,
+			//which rebuilds the tiles for every substep
+			float TimeStep = 1.0f / 60.0f;
+		};
+
+		//Surface the tiles are built from (not owned), drops all tiles
+		void SetSource(const IWaterSurface* InSource, const FSettings& InSettings);
+		//Drops all tiles, call when the source changed without the cache knowing
+		void Invalidate();
+
+		virtual void GetHeights(const float* X, const float* Y, int32_t Num, float Time, float* OutHeights) const override;
+
+		const IWaterSurface* GetSource() const { return Source; }
+		const FSettings& GetSettings() const { return Settings; }
+		//How many tiles were evaluated from the source since SetSource, for profiling
+		int64_t GetNumTileBuilds() const { return NumTileBuilds; }
+
+	private:
+		struct FTile
+		{
+			int32_t TileX = 0;
+			int32_t TileY = 0;
+			float Time = 0.0f;
+			bool bInUse = false;
+			//Next tile in the same hash bucket, -1 ends the chain
+			int32_t NextInBucket = -1;
+			//(TileResolution + 1)^2 heights, the last row and column repeat the first of the neighbours
+			std::vector<float> Heights;
+		};
+
+		const IWaterSurface* Source = nullptr;
+		FSettings Settings;
+
+		//Everything below is filled in lazily from const queries, guarded by Mutex
+		mutable std::shared_timed_mutex Mutex;
+		mutable std::vector<FTile> Tiles;
+		mutable std::vector<int32_t> Buckets;
+		//Touched under the shared lock too, so kept apart from the tiles as atomics
+		mutable std::unique_ptr<std::atomic<uint64_t>[]> TileLastUse;
+		mutable std::atomic<uint64_t> UseCounter{ 0 };
+		mutable int64_t NumTileBuilds = 0;
+		//Grid point positions of one tile, padded for the batched source query
+		mutable std::vector<float> ScratchX;
+		mutable std::vector<float> ScratchY;
+
+		uint32_t GetBucket(int32_t TileX, int32_t TileY) const;
+		//Samples every position at an already snapped time, returns false without finishing if a tile is missing and bBuildTiles is off
+		bool Sample(const float* X, const float* Y, int32_t Num, float Time, float* OutHeights, bool bBuildTiles) const;
+		//nullptr if the tile is not there at this time and bBuild is off
+		const FTile* FindTile(int32_t TileX, int32_t TileY, float Time, bool bBuild) const;
+		void BuildTile(FTile& Tile, int32_t TileX, int32_t TileY, float Time) const;
+		void UnlinkTile(int32_t Index) const;
+	};
+}
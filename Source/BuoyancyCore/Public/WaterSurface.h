@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "BuoyancyCoreTypes.h"
+#include "BuoyancySimd.h"
+#include <vector>
+
+namespace BuoyancyCore
+{
+	/**
+	 * Where the water is. Queried once per hull per step with every vertex at once,
+	 * so implementations pay for one virtual call and can vectorize over the whole batch.
+	 */
+	class BUOYANCYCORE_API IWaterSurface
+	{
+	public:
+		virtual ~IWaterSurface() {}
+
+		//World Z of the water surface above (or below) each of the Num XY positions at the given time
+		virtual void GetHeights(const float* X, const float* Y, int32_t Num, float Time, float* OutHeights) const = 0;
+	};
+
+	/**
+	 * The water near one point taken as a plane, Z = Height + SlopeX * (X - CenterX) + SlopeY * (Y - CenterY) in world space.
+	 * What FHullClipper::GenerateUnderWaterMeshLocal clips against, exact for flat water and close enough for
+	 * waves much longer than the hull.
+	 */
+	struct BUOYANCYCORE_API FWaterPlane
+	{
+		float CenterX = 0.0f;
+		float CenterY = 0.0f;
+		float Height = 0.0f;
+		float SlopeX = 0.0f;
+		float SlopeY = 0.0f;
+
+		float GetHeight(float X, float Y) const { return Height + SlopeX * (X - CenterX) + SlopeY * (Y - CenterY); }
+
+		//Least squares plane through the surface at the center and Radius away from it either way along X and Y,
+		//one GetHeights call. nullptr is the plane Z = 0
+		static FWaterPlane Fit(const IWaterSurface* Surface, float Time, float CenterX, float CenterY, float Radius);
+	};
+
+	//Still water at a fixed height, what the hard coded Z = 0 used to be
+	class BUOYANCYCORE_API FFlatWaterSurface : public IWaterSurface
+	{
+	public:
+		explicit FFlatWaterSurface(float InHeight = 0.0f) : Height(InHeight) {}
+
+		void SetHeight(float InHeight) { Height = InHeight; }
+		float GetHeight() const { return Height; }
+
+		virtual void GetHeights(const float* X, const float* Y, int32_t Num, float Time, float* OutHeights) const override;
+
+	private:
+		float Height;
+	};
+
+	//One wave of a Gerstner sum
+	struct FGerstnerWave
+	{
+		//Direction of travel in the XY plane, normalized by FGerstnerWaterSurface
+		float DirectionX = 1.0f;
+		float DirectionY = 0.0f;
+		//Crest to crest distance in cm
+		float Wavelength = 2000.0f;
+		//Crest height above the mean level in cm
+		float Amplitude = 50.0f;
+		//0 gives a plain sine wave, 1 the sharpest crest the sum can have before it loops over itself
+		float Steepness = 0.5f;
+		//Phase offset in radians so waves of the same length don't line up
+		float Phase = 0.0f;
+	};
+
+	/**
+	 * Sum of Gerstner waves around a mean height, speeds follow the deep water dispersion relation.
+	 * Gerstner waves move the water sideways as well as up, so the height at a given XY is found by undoing the
+	 * sideways motion a few times (fixed point iteration) and then evaluating the vertical part there.
+	 * GetHeights runs the whole batch through FSimdFloat with the polynomial Sin/Cos, wave by wave over the batch,
+	 * no per vertex virtual call and no per vertex std::sin.
+	 */
+	class BUOYANCYCORE_API FGerstnerWaterSurface : public IWaterSurface
+	{
+	public:
+		void SetWaves(const FGerstnerWave* Waves, int32_t NumWaves, float InMeanHeight = 0.0f, float InGravity = 980.0f);
+		//How many times the sideways displacement is undone before evaluating the height, 0 skips it
+		void SetInversionIterations(int32_t Iterations) { InversionIterations = Iterations; }
+		int32_t GetNumWaves() const { return (int32_t)Prepared.size(); }
+
+		virtual void GetHeights(const float* X, const float* Y, int32_t Num, float Time, float* OutHeights) const override;
+
+		//One position with std::sin/std::cos, the reference the batched version is checked against
+		float GetHeightReference(float X, float Y, float Time) const;
+
+	private:
+		//Everything per wave that does not depend on the position, precomputed in SetWaves
+		struct FPreparedWave
+		{
+			//Direction times wave number
+			float KX;
+			float KY;
+			//Angular frequency
+			float Omega;
+			float Phase;
+			float Amplitude;
+			//Sideways displacement along the direction, Q * A in the usual notation
+			float SidewaysX;
+			float SidewaysY;
+		};
+
+		std::vector<FPreparedWave> Prepared;
+		float MeanHeight = 0.0f;
+		int32_t InversionIterations = 1;
+
+		//Full registers only, Begin to End must be a multiple of FSimdFloat::Width
+		void GetHeightsSimd(const float* X, const float* Y, int32_t Begin, int32_t End, float Time, float* OutHeights) const;
+	};
+}
@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "BuoyancyCoreTypes.h"
+#include "WaterSurface.h"
+#include <unordered_map>
+#include <vector>
+
+namespace BuoyancyCore
+{
+	//One body of water, like a harbor, a river or a lake, and what floating in it means
+	struct FWaterVolume
+	{
+		//World box, its top should be above the highest crest. Bodies whose box misses it don't float in this water
+		FVec3 BoundsMin;
+		FVec3 BoundsMax;
+		//nullptr for the plane Z = 0. Not owned
+		const IWaterSurface* Surface = nullptr;
+		float Density = 1.0f;
+		//Of the water in cm/s, the hydrodynamic forces see the velocity of a body relative to it
+		FVec3 CurrentVelocity;
+		//Where volumes overlap a body floats in the one with the highest priority, then in the one with the smallest area
+		int32_t Priority = 0;
+	};
+
+	/**
+	 * The water volumes of a world, with a uniform grid over their XY extent as the broadphase. There are few volumes and they
+	 * rarely change, but every body looks them up every frame. So a change updates the cells of that volume, and a lookup
+	 * only visits the cells under the body's box. Volumes over more than MaxCellsPerVolume cells, like an ocean, are kept
+	 * in a list that every lookup checks instead.
+	 * Lookups never allocate and can run on any number of threads, as long as no volume is added, moved or removed meanwhile.
+	 */
+	class BUOYANCYCORE_API FWaterVolumeRegistry
+	{
+	public:
+		static constexpr int32_t MaxCellsPerVolume = 64;
+
+		//Side of a grid cell in cm, about the size of the smaller volumes works well
+		explicit FWaterVolumeRegistry(float InCellSize = 10000.0f);
+
+		//Returns the handle of the new volume, the handles of removed volumes are reused
+		int32_t Add(const FWaterVolume& Volume);
+		void Update(int32_t Handle, const FWaterVolume& Volume);
+		void Remove(int32_t Handle);
+		const FWaterVolume& Get(int32_t Handle) const { return Slots[Handle].Volume; }
+		int32_t GetNum() const { return NumVolumes; }
+
+		//Handles of up to MaxHandles volumes whose box overlaps [BoxMin, BoxMax], in no particular order. Returns how many overlap
+		//in total, which may be more than MaxHandles
+		int32_t FindOverlapping(const FVec3& BoxMin, const FVec3& BoxMax, int32_t* OutHandles, int32_t MaxHandles) const;
+		//The volume a body with this box floats in (see FWaterVolume::Priority), -1 when it is out of the water.
+		//Only one: a body straddling two volumes, like a boat in a lock or at a river mouth, is clipped whole against the
+		//surface of the chosen one, even where its hull is over the other
+		int32_t FindBest(const FVec3& BoxMin, const FVec3& BoxMax) const;
+
+	private:
+		struct FSlot
+		{
+			FWaterVolume Volume;
+			bool bUsed = false;
+			//Grid cells under the volume, inclusive. Unset for the large volumes
+			int32_t CellMinX = 0;
+			int32_t CellMinY = 0;
+			int32_t CellMaxX = -1;
+			int32_t CellMaxY = -1;
+		};
+
+		float CellSize;
+		std::vector<FSlot> Slots;
+		std::vector<int32_t> FreeSlots;
+		int32_t NumVolumes = 0;
+		//Volumes over every used cell
+		std::unordered_map<uint64_t, std::vector<int32_t>> Cells;
+		std::vector<int32_t> LargeVolumes;
+
+		int32_t GetCell(float Coordinate) const;
+		void Link(int32_t Handle);
+		void Unlink(int32_t Handle);
+		template<typename FunctionType>
+		void ForEachOverlapping(const FVec3& BoxMin, const FVec3& BoxMax, FunctionType Function) const;
+	};
+}
@@ -5,7 +5,21 @@
 #include "Components/StaticMeshComponent.h"
 #include "Engine/World.h"
 #include "UnderWaterMeshGenerator.h"
+#include "BuoyancyWaterSurface.h"
+#include "BuoyancyManager.h"
+#include "BuoyancyStats.h"
 #include "Private/KismetTraceUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+
+static TAutoConsoleVariable<int32> CVarBuoyancyVisualize(
+	TEXT("buoyancy.Visualize"),
+	-1,
+	TEXT("Debug view of the under water meshes.\n")
+	TEXT("-1: per component, see bVisualizeUnderWaterMesh (default)\n")
+	TEXT(" 0: off for every body\n")
+	TEXT(" 1: on for every body"));
 
 // Sets default values for this component's properties
 UBuoyancyActorComponent::UBuoyancyActorComponent()
@@ -25,10 +39,28 @@ void UBuoyancyActorComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
+	//Before InitVariables, the manager counts the frames of the reduced rate steps
+	StepManager = bUseBuoyancyManager ? FBuoyancyManager::Get(GetWorld()) : nullptr;
+
 	InitVariables();
 
-	// ...
-	
+	//The manager does the work of every managed body in one go, so this one doesn't need its own tick
+	if (StepManager)
+	{
+		StepManager->Register(this);
+		SetComponentTickEnabled(false);
+	}
+}
+
+void UBuoyancyActorComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (FBuoyancyManager* Manager = FBuoyancyManager::Find(GetWorld()))
+	{
+		Manager->Unregister(this);
+	}
+	StepManager = nullptr;
+
+	Super::EndPlay(EndPlayReason);
 }
 
 
@@ -39,21 +71,338 @@ void UBuoyancyActorComponent::TickComponent(float DeltaTime, ELevelTick TickType
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	UnderWaterMeshGenerator->GenerateUnderWaterMesh();
+	//Same stages the manager runs, just for this one body. Without the manager there is no budget, reduced rate steps only keep to their interval
+	if (bSignificance)
+	{
+		FBuoyancyViews Views;
+		GatherSignificanceViews(GetWorld(), Views);
+		UpdateSignificance(Views);
+	}
+	if (IsStepDue() && PreBuoyancyStep(GetTimeSinceStep(DeltaTime)))
+	{
+		ComputeBuoyancyStep();
+	}
+	ApplyBuoyancyStep();
+}
 
-	//for debugging
-	UnderWaterMeshGenerator->DisplayMesh(UnderWaterMesh, UnderWaterMeshGenerator->UnderWaterTriangleData);
-	
-	//NOTE!!!! Unreal doesnt have a fixed time step like unity, physics should actually be implemented by creating one https://forums.unrealengine.com/community/community-content-tools-and-tutorials/87505-using-a-fixed-physics-timestep-in-unreal-engine-free-the-physics-approach
-	// in this case I did the lazy thing and just ignore this for now. But really should do 
+void UBuoyancyActorComponent::GatherSignificanceViews(UWorld* World, FBuoyancyViews& OutViews)
+{
+	//Every controller, on a server that is every player and on a client only the local ones
+	OutViews.Reset();
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* Controller = It->Get();
+		if (!Controller)
+		{
+			continue;
+		}
+
+		FVector Location;
+		FRotator Rotation;
+		Controller->GetPlayerViewPoint(Location, Rotation);
+		const float FOV = Controller->PlayerCameraManager ? Controller->PlayerCameraManager->GetFOVAngle() : 90.0f;
+
+		FBuoyancyView View;
+		View.Location = Location;
+		View.ScreenScale = 1.0f / FMath::Tan(FMath::DegreesToRadians(FMath::Clamp(FOV, 1.0f, 170.0f) * 0.5f));
+		OutViews.Add(View);
+	}
+}
+
+void UBuoyancyActorComponent::UpdateSignificance(TArrayView<const FBuoyancyView> Views)
+{
+	//Fixed timestep bodies do their work in the physics substeps, which don't go through the tiers
+	if (!bSignificance || bUseFixedTimestep || Views.Num() == 0 || !ParentPrimitive)
+	{
+		SignificanceTier = EBuoyancySignificanceTier::Full;
+		return;
+	}
+
+	//How close the body is to the view that sees it best, bigger is closer for both metrics
+	const FBoxSphereBounds& Bounds = ParentPrimitive->Bounds;
+	float Closeness = 0.0f;
+	float FullThreshold;
+	float AnalyticThreshold;
+	if (SignificanceMetric == EBuoyancySignificanceMetric::Distance)
+	{
+		float MinDistanceSquared = MAX_flt;
+		for (const FBuoyancyView& View : Views)
+		{
+			MinDistanceSquared = FMath::Min(MinDistanceSquared, FVector::DistSquared(View.Location, Bounds.Origin));
+		}
+		Closeness = FMath::InvSqrt(FMath::Max(MinDistanceSquared, 1.0f));
+		FullThreshold = 1.0f / FMath::Max(FullTierDistance, 1.0f);
+		AnalyticThreshold = 1.0f / FMath::Max(AnalyticTierDistance, 1.0f);
+	}
+	else
+	{
+		//About what ComputeBoundsScreenSize gives, without needing the view's projection
+		for (const FBuoyancyView& View : Views)
+		{
+			const float Distance = FMath::Max(FVector::Dist(View.Location, Bounds.Origin), 1.0f);
+			Closeness = FMath::Max(Closeness, Bounds.SphereRadius * View.ScreenScale / Distance);
+		}
+		FullThreshold = FullTierScreenSize;
+		AnalyticThreshold = AnalyticTierScreenSize;
+	}
+
+	//Dropping a tier takes 10% past the threshold, so a body sitting right on it doesn't swap hulls every frame
+	const float Hysteresis = 1.0f / 1.1f;
+	const float FullKeep = SignificanceTier == EBuoyancySignificanceTier::Full ? Hysteresis : 1.0f;
+	const float ReducedKeep = SignificanceTier != EBuoyancySignificanceTier::Analytic ? Hysteresis : 1.0f;
+	if (Closeness >= FullThreshold * FullKeep)
+	{
+		SignificanceTier = EBuoyancySignificanceTier::Full;
+	}
+	else if (Closeness >= AnalyticThreshold * ReducedKeep)
+	{
+		SignificanceTier = EBuoyancySignificanceTier::Reduced;
+	}
+	else
+	{
+		SignificanceTier = EBuoyancySignificanceTier::Analytic;
+	}
+}
+
+float UBuoyancyActorComponent::GetTimeSinceStep(float FrameDeltaTime) const
+{
+	const float TimeSinceStep = GetWorld()->GetTimeSeconds() - LastStepTime;
+	return LastStepTime >= 0.0f && TimeSinceStep > 0.0f ? TimeSinceStep : FrameDeltaTime;
+}
+
+bool UBuoyancyActorComponent::PreBuoyancyStep(float DeltaTime)
+{
+	bStepComputed = false;
+	bStepIsAsync = false;
+	LastStepFrame = GetStepFrame();
+	LastStepTime = GetWorld()->GetTimeSeconds();
+
+	if (!FindWater())
+	{
+		//Nothing to float in, the body skips the whole step. The fixed steps start from nothing once it is back in the water
+		FixedStepForce = FVector::ZeroVector;
+		FixedStepTorque = FVector::ZeroVector;
+		if (bVisualizationShown)
+		{
+			UnderWaterMeshGenerator->HideMesh(UnderWaterMesh);
+			bVisualizationShown = false;
+		}
+		INC_DWORD_STAT(STAT_BuoyancyBodiesOutOfWater);
+		CSV_CUSTOM_STAT(Buoyancy, BodiesOutOfWater, 1, ECsvCustomStatOp::Accumulate);
+		return false;
+	}
+
+	//No step of this body is running here, so the hull can be swapped
+	UpdateHullLOD();
+	UpdatePontoons();
+	UnderWaterMeshGenerator->SetLocalSpaceWater(bLocalSpaceWater);
 
-	////Add forces to the part of the boat that's below the water -- TODO ADD TO FIXED TIMESTEP
-	if (UnderWaterMeshGenerator->UnderWaterTriangleData.Num() > 0)
-	{	
-		//UE_LOG(LogTemp, Warning, TEXT("Addforces"));
-		AddUnderWaterForces();
+	if (bHydrodynamicForces)
+	{
+		//Longest horizontal side of the mesh as the waterline length for the viscous resistance
+		const FVector MeshSize = ParentMesh->GetBoundingBox().GetSize() * UnderWaterMeshGenerator->GetParentMeshTransform().GetScale3D().GetAbs();
+		HydrodynamicHullLength = FMath::Max(MeshSize.X, MeshSize.Y);
+		HydrodynamicMass = ParentPrimitive->GetMass();
 	}
 
+	//Unreal doesnt have a fixed time step like unity, so in fixed timestep mode we hook into the physics substeps instead https://forums.unrealengine.com/community/community-content-tools-and-tutorials/87505-using-a-fixed-physics-timestep-in-unreal-engine-free-the-physics-approach
+	if (bUseFixedTimestep)
+	{
+		FBodyInstance* BodyInstance = ParentPrimitive->GetBodyInstance();
+		if (BodyInstance)
+		{
+			//Everything SubstepTick needs from the game thread
+			FixedStepDeltaTime = 1.0f / FMath::Max(FixedTimestepRate, 1.0f);
+			FixedStepForceModel = ForceModel;
+			bFixedStepReuseWaterline = bReuseWaterlineBetweenSteps;
+			FixedStepWaterVelocity = ActiveWaterVelocity;
+			FixedStepWaterViscosity = WaterViscosity;
+			FixedStepParams.WaterDensity = ActiveWaterDensity;
+			FixedStepParams.GravityZ = GetWorld()->GetGravityZ();
+			FixedStepParams.Model = GetCoreForceModel();
+			FixedStepParams.Hydrodynamics = MakeHydrodynamicParams(ActiveWaterVelocity, FVector::ZeroVector, FixedStepDeltaTime);
+			//World time has already moved on to the end of the frame the substeps are about to simulate
+			FixedStepWaterTime = GetWorld()->GetTimeSeconds() - GetWorld()->GetDeltaSeconds();
+			FixedStepWaterSurface = ActiveWaterSurface;
+			MeshToBodyTransform = UnderWaterMeshGenerator->GetParentMeshTransform().GetRelativeTransform(ParentPrimitive->GetComponentTransform());
+			bClassifiedThisFrame = false;
+
+			//The custom physics delegate only lasts one frame so it has to be added every tick
+			BodyInstance->AddCustomPhysics(OnCalculateCustomPhysics);
+
+			//Counted here rather than per substep, the clips of those show up in the triangle counters
+			INC_DWORD_STAT(STAT_BuoyancyBodiesProcessed);
+			CSV_CUSTOM_STAT(Buoyancy, BodiesProcessed, 1, ECsvCustomStatOp::Accumulate);
+		}
+
+		//The work happens in the substeps
+		return false;
+	}
+
+	BuoyancyCore::FClipCoherenceSettings CoherenceSettings;
+	CoherenceSettings.SkipMovement = CoherenceSkipMovement;
+	CoherenceSettings.SkipDepthChange = CoherenceSkipDepthChange;
+	CoherenceSettings.BandMargin = CoherenceBandMargin;
+	UnderWaterMeshGenerator->SetCoherence(bTemporalCoherence, CoherenceSettings);
+
+	StepMeshTransform = UnderWaterMeshGenerator->GetParentMeshTransform();
+	StepWaterSurface = ActiveWaterSurface;
+	StepWaterTime = GetWorld()->GetTimeSeconds();
+	StepTier = SignificanceTier;
+	StepForceModel = ForceModel;
+	bStepAggregated = UsesAggregatedForces();
+	StepParams.WaterDensity = ActiveWaterDensity;
+	StepParams.Model = GetCoreForceModel();
+	StepParams.GravityZ = GetWorld()->GetGravityZ();
+	StepParams.CenterOfMass = BuoyancyCore::ToCore(ParentPrimitive->GetCenterOfMass());
+	StepParams.Hydrodynamics = MakeHydrodynamicParams(ParentPrimitive->GetPhysicsLinearVelocity(), ParentPrimitive->GetPhysicsAngularVelocityInRadians(), DeltaTime);
+	return true;
+}
+
+BuoyancyCore::FHydrodynamicParams UBuoyancyActorComponent::MakeHydrodynamicParams(const FVector& LinearVelocity, const FVector& AngularVelocity, float DeltaTime) const
+{
+	BuoyancyCore::FHydrodynamicParams Hydrodynamics;
+	if (!bHydrodynamicForces)
+	{
+		return Hydrodynamics;
+	}
+
+	//Through the water, a uniform current moves every point of the hull alike
+	const FVector RelativeVelocity = LinearVelocity - ActiveWaterVelocity;
+	Hydrodynamics.bEnabled = true;
+	Hydrodynamics.LinearVelocity = BuoyancyCore::ToCore(RelativeVelocity);
+	Hydrodynamics.AngularVelocity = BuoyancyCore::ToCore(AngularVelocity);
+	Hydrodynamics.ResistanceCoefficient = BuoyancyCore::ViscousResistanceCoefficient(RelativeVelocity.Size(), HydrodynamicHullLength, WaterViscosity);
+	Hydrodynamics.PressureDragLinear = PressureDragLinear;
+	Hydrodynamics.PressureDragQuadratic = PressureDragQuadratic;
+	Hydrodynamics.PressureDragFalloff = PressureDragFalloff;
+	Hydrodynamics.SuctionDragLinear = SuctionDragLinear;
+	Hydrodynamics.SuctionDragQuadratic = SuctionDragQuadratic;
+	Hydrodynamics.SuctionDragFalloff = SuctionDragFalloff;
+	Hydrodynamics.ReferenceSpeed = DragReferenceSpeed;
+	if (bSlamming)
+	{
+		Hydrodynamics.DeltaTime = DeltaTime;
+		Hydrodynamics.Mass = HydrodynamicMass;
+		Hydrodynamics.MaxSlammingAcceleration = MaxSlammingAcceleration;
+		Hydrodynamics.SlammingPower = SlammingPower;
+	}
+	return Hydrodynamics;
+}
+
+void UBuoyancyActorComponent::ComputeBuoyancyStep()
+{
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+#if !UE_BUILD_SHIPPING
+	const SIZE_T StartBufferSize = UnderWaterMeshGenerator->GetStepBufferSize();
+	const int32 StartBufferSizings = UnderWaterMeshGenerator->GetNumBufferSizings();
+#endif
+	UnderWaterMeshGenerator->SetWaterSurface(StepWaterSurface, StepWaterTime);
+
+	if (StepTier == EBuoyancySignificanceTier::Analytic)
+	{
+		UnderWaterMeshGenerator->GenerateAnalyticForces(StepMeshTransform, StepParams, StepWrench);
+		StepHydrodynamicWrench = UnderWaterMeshGenerator->GetLastHydrodynamicWrench();
+	}
+	else if (StepForceModel == EBuoyancyForceModel::Pontoons)
+	{
+		UnderWaterMeshGenerator->GeneratePontoonForces(StepMeshTransform, StepParams, StepWrench);
+		StepHydrodynamicWrench = BuoyancyCore::FBuoyancyWrench();
+	}
+	else
+	{
+		//The sum is done while clipping, the triangle data is only built for the per triangle forces. The debug view reads the clipper
+		const bool bBuildTriangleData = !bStepAggregated;
+		UnderWaterMeshGenerator->GenerateUnderWaterForces(StepMeshTransform, StepParams, bBuildTriangleData, StepWrench);
+		StepHydrodynamicWrench = UnderWaterMeshGenerator->GetLastHydrodynamicWrench();
+	}
+	bStepComputed = true;
+	bStepFresh = true;
+#if !UE_BUILD_SHIPPING
+	//Any growth outside of the generator's own reserves is a buffer that was sized too small for the hull
+	ensureMsgf(UnderWaterMeshGenerator->GetNumBufferSizings() != StartBufferSizings || UnderWaterMeshGenerator->GetStepBufferSize() == StartBufferSize,
+		TEXT("Buoyancy step of %s grew its buffers after they were sized"), *GetNameSafe(GetOwner()));
+#endif
+
+	//Smoothed, for the manager's budget. A tier change shows up within a few steps
+	const float Cost = (float)(FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) * 1000000.0);
+	StepCostMicroseconds = StepCostMicroseconds > 0.0f ? FMath::Lerp(StepCostMicroseconds, Cost, 0.25f) : Cost;
+
+	INC_DWORD_STAT(STAT_BuoyancyBodiesProcessed);
+	CSV_CUSTOM_STAT(Buoyancy, BodiesProcessed, 1, ECsvCustomStatOp::Accumulate);
+}
+
+void UBuoyancyActorComponent::ApplyBuoyancyStep()
+{
+	//The fixed timestep substeps apply their own forces. The last frame's are done by now (we tick before physics), so the debug
+	//view shows the result of the final one
+	if (!bUseFixedTimestep)
+	{
+		if (!bStepComputed)
+		{
+			return;
+		}
+
+		SCOPE_CYCLE_COUNTER(STAT_BuoyancyApply);
+		CSV_SCOPED_TIMING_STAT(Buoyancy, Apply);
+		if (bStepAggregated)
+		{
+			//Two physics calls for the whole body instead of one per triangle. The drag of a reused result would work against a
+			//velocity the body no longer has, and its slamming was already applied once
+			FVector Force = BuoyancyCore::ToUE(StepWrench.Force);
+			FVector Torque = BuoyancyCore::ToUE(StepWrench.Torque);
+			if (!bStepFresh)
+			{
+				Force -= BuoyancyCore::ToUE(StepHydrodynamicWrench.Force);
+				Torque -= BuoyancyCore::ToUE(StepHydrodynamicWrench.Torque);
+			}
+			ParentPrimitive->AddForce(Force);
+			ParentPrimitive->AddTorqueInRadians(Torque);
+		}
+		else if (UnderWaterMeshGenerator->UnderWaterTriangleData.Num() > 0)
+		{
+			////Add forces to the part of the boat that's below the water
+			AddUnderWaterForces();
+		}
+	}
+
+	UpdateVisualization();
+
+	//An async result is only applied once
+	bStepIsAsync = false;
+	bAsyncCandidate = false;
+	bStepFresh = false;
+}
+
+void UBuoyancyActorComponent::UpdateVisualization()
+{
+	SCOPE_CYCLE_COUNTER(STAT_BuoyancyDisplay);
+	CSV_SCOPED_TIMING_STAT(Buoyancy, Display);
+
+	const int32 Override = CVarBuoyancyVisualize.GetValueOnGameThread();
+	const bool bVisualize = Override < 0 ? bVisualizeUnderWaterMesh : Override > 0;
+	if (!bVisualize)
+	{
+		if (bVisualizationShown)
+		{
+			UnderWaterMeshGenerator->HideMesh(UnderWaterMesh);
+			bVisualizationShown = false;
+		}
+		return;
+	}
+
+	//Between throttled refreshes the mesh stays as it is and the lines live until the next one
+	const float Now = GetWorld()->GetTimeSeconds();
+	const float Interval = VisualizationRefreshRate > 0.0f ? 1.0f / VisualizationRefreshRate : 0.0f;
+	if (bVisualizationShown && Now - LastVisualizationTime < Interval)
+	{
+		return;
+	}
+	LastVisualizationTime = Now;
+	bVisualizationShown = true;
+
+	UnderWaterMeshGenerator->DisplayMesh(UnderWaterMesh);
+	UnderWaterMeshGenerator->DrawDebugLines(GetWorld(), Interval);
 }
 
 
@@ -64,7 +413,7 @@ void UBuoyancyActorComponent::PostLoad()
 
 
 	//CreateTriangle();
-	UE_LOG(LogTemp, Warning, TEXT("PostLoad"));
+	UE_LOG(LogBuoyancy, Verbose, TEXT("PostLoad %s"), *GetNameSafe(GetOwner()));
 }
 
 
@@ -76,66 +425,186 @@ void UBuoyancyActorComponent::InitVariables()
 	UnderWaterMeshGenerator = NewObject<UUnderWaterMeshGenerator>();
 	
 	UnderWaterMeshGenerator->ModifyMesh(GetOwner()->FindComponentByClass<UStaticMeshComponent>());
+	UpdateHullLOD();
+	UpdatePontoons();
+
+	//Start with a full step so the first substep already has a force
+	OnCalculateCustomPhysics.BindUObject(this, &UBuoyancyActorComponent::SubstepTick);
+	FixedStepAccumulator = 1.0f / FMath::Max(FixedTimestepRate, 1.0f);
+
+	//Bodies spawned together would otherwise all take their reduced rate steps in the same frames
+	LastStepFrame = GetStepFrame() - GetUniqueID() % FMath::Max(ReducedTierInterval, 1);
+}
+
+uint64 UBuoyancyActorComponent::GetStepFrame() const
+{
+	return StepManager ? StepManager->GetFrameIndex() : GFrameCounter;
+}
+
+void UBuoyancyActorComponent::UpdateHullLOD()
+{
+	const EBuoyancyHullLOD TargetLOD = SignificanceTier == EBuoyancySignificanceTier::Reduced ? ReducedTierHullLOD : HullLOD;
+	if (TargetLOD == UnderWaterMeshGenerator->GetHullLOD())
+	{
+		return;
+	}
+
+	BuoyancyCore::FHullSimplifySettings ProxySettings;
+	ProxySettings.TargetTriangles = TargetLOD == EBuoyancyHullLOD::Near ? NearProxyTriangles : FarProxyTriangles;
+	ProxySettings.MaxVolumeError = ProxyMaxVolumeError;
+	ProxySettings.MaxCentroidError = ProxyMaxCentroidError;
+	UnderWaterMeshGenerator->SetHullLOD(TargetLOD, ProxySettings);
+}
+
+void UBuoyancyActorComponent::UpdatePontoons()
+{
+	BuoyancyCore::FPontoonSettings PontoonSettings;
+	PontoonSettings.Resolution = PontoonResolution;
+	UnderWaterMeshGenerator->SetPontoons(ForceModel == EBuoyancyForceModel::Pontoons, PontoonSettings);
 }
 
 void UBuoyancyActorComponent::AddUnderWaterForces()
 {
 	//Get all triangles
-	TArray<FTriangleData> underWaterTriangleData = UnderWaterMeshGenerator->UnderWaterTriangleData;
+	const TArray<FTriangleData>& underWaterTriangleData = UnderWaterMeshGenerator->UnderWaterTriangleData;
 
 	for (int i = 0; i < underWaterTriangleData.Num(); i++)
 	{
 		//This triangle
-		FTriangleData triangleData = underWaterTriangleData[i];
+		const FTriangleData& triangleData = underWaterTriangleData[i];
 
 		//Calculate the buoyancy force
-		FVector buoyancyForce = BuoyancyForce(WaterDensity, triangleData);
+		FVector buoyancyForce = BuoyancyForce(ActiveWaterDensity, triangleData);
 
+		UE_LOG(LogBuoyancyTriangles, VeryVerbose, TEXT("AddForce %s at %s"), *buoyancyForce.ToString(), *triangleData.center.ToString());
 
-		UE_LOG(LogTemp, Warning, TEXT("AddForce"));
 		//Add the force to the boat
 		ParentPrimitive->AddForceAtLocation(buoyancyForce, triangleData.center);
+	}
+}
 
+// Pose of a rigid body a little later, extrapolated from its velocities at the start of the substep
+static FTransform ExtrapolateBodyTransform(const FTransform& BodyTransform, const FVector& CenterOfMass, const FVector& LinearVelocity, const FVector& AngularVelocity, float Time)
+{
+	const float Angle = AngularVelocity.Size() * Time;
+	const FQuat DeltaRotation = Angle > KINDA_SMALL_NUMBER ? FQuat(AngularVelocity.GetSafeNormal(), Angle) : FQuat::Identity;
+
+	//Rotate about the center of mass, then move it
+	FTransform Result = BodyTransform;
+	Result.SetRotation(DeltaRotation * BodyTransform.GetRotation());
+	Result.SetLocation(CenterOfMass + LinearVelocity * Time + DeltaRotation.RotateVector(BodyTransform.GetLocation() - CenterOfMass));
+	return Result;
+}
 
-		//Debug
+// Called by the physics engine for every substep of a frame, possibly on the physics thread
+void UBuoyancyActorComponent::SubstepTick(float DeltaTime, FBodyInstance* BodyInstance)
+{
+	const float FixedDeltaTime = FixedStepDeltaTime;
+
+	//Body state at the start of this substep, the fixed steps that fall inside it are extrapolated from this
+	const FTransform BodyTransform = BodyInstance->GetUnrealWorldTransform_AssumesLocked();
+	const FVector CenterOfMass = BodyInstance->GetCOMPosition_AssumesLocked();
+	const FVector LinearVelocity = BodyInstance->GetUnrealWorldVelocity_AssumesLocked();
+	const FVector AngularVelocity = BodyInstance->GetUnrealWorldAngularVelocityInRadians_AssumesLocked();
+
+	//Each fixed step result is held until the next one, the body gets the time weighted average over this substep
+	FVector Force = FVector::ZeroVector;
+	FVector Torque = FVector::ZeroVector;
+	float Time = 0.0f;
+	float NextStep = FixedDeltaTime - FMath::Min(FixedStepAccumulator, FixedDeltaTime);
+	while (NextStep <= DeltaTime)
+	{
+		Force += FixedStepForce * (NextStep - Time);
+		Torque += FixedStepTorque * (NextStep - Time);
+		Time = NextStep;
 
-	
-		//Normal
-
-		UE_LOG(LogTemp, Warning, TEXT("triangle data %s"), *triangleData.normal.ToString());
-		
-		DrawDebugLine(
-			GetWorld(),
-			triangleData.center,
-			triangleData.center + triangleData.normal * 3.0f,
-			FColor::Green,
-			false, -1, 2,
-			1
-		);
-		/*
-		DrawDebugPoint(
-			GetWorld(),
-			triangleData.center,
-			10.0f,
-			FColor::Purple,
-			false, -1, 2	
-		);*/
-
-		//Buoyancy
-
-		DrawDebugLine(
-			GetWorld(),
-			triangleData.center,
-			triangleData.center + buoyancyForce.Normalize() * -3.0f,
-			FColor::Red,
-			false, -1, 0,
-			1
-		);
+		const FTransform StepTransform = ExtrapolateBodyTransform(BodyTransform, CenterOfMass, LinearVelocity, AngularVelocity, Time);
+		ComputeFixedStep(StepTransform, CenterOfMass + LinearVelocity * Time, FixedStepWaterTime + Time, LinearVelocity, AngularVelocity);
+
+		NextStep += FixedDeltaTime;
+	}
+	Force += FixedStepForce * (DeltaTime - Time);
+	Torque += FixedStepTorque * (DeltaTime - Time);
+	FixedStepAccumulator = FixedDeltaTime - (NextStep - DeltaTime);
+	FixedStepWaterTime += DeltaTime;
+
+	if (DeltaTime > 0.0f)
+	{
+		//Already inside a substep, so no substepping of our own
+		BodyInstance->AddForce(Force / DeltaTime, false, false);
+		BodyInstance->AddTorqueInRadians(Torque / DeltaTime, false, false);
+	}
+}
+
+void UBuoyancyActorComponent::ComputeFixedStep(const FTransform& BodyTransform, const FVector& CenterOfMass, float WaterTime, const FVector& LinearVelocity, const FVector& AngularVelocity)
+{
+	BuoyancyCore::FBuoyancyParams Params = FixedStepParams;
+	Params.CenterOfMass = BuoyancyCore::ToCore(CenterOfMass);
+	if (Params.Hydrodynamics.bEnabled)
+	{
+		//The extrapolation keeps the velocities of the start of the substep, the rest is as MakeHydrodynamicParams set it
+		const FVector RelativeVelocity = LinearVelocity - FixedStepWaterVelocity;
+		Params.Hydrodynamics.LinearVelocity = BuoyancyCore::ToCore(RelativeVelocity);
+		Params.Hydrodynamics.AngularVelocity = BuoyancyCore::ToCore(AngularVelocity);
+		Params.Hydrodynamics.ResistanceCoefficient = BuoyancyCore::ViscousResistanceCoefficient(RelativeVelocity.Size(), HydrodynamicHullLength, FixedStepWaterViscosity);
+	}
+
+	const FTransform MeshTransform = MeshToBodyTransform * BodyTransform;
+	UnderWaterMeshGenerator->SetWaterSurface(FixedStepWaterSurface, WaterTime);
+
+	BuoyancyCore::FBuoyancyWrench Wrench;
+	if (FixedStepForceModel == EBuoyancyForceModel::Pontoons)
+	{
+		UnderWaterMeshGenerator->GeneratePontoonForces(MeshTransform, Params, Wrench);
+	}
+	else if (bFixedStepReuseWaterline && bClassifiedThisFrame)
+	{
+		UnderWaterMeshGenerator->UpdateUnderWaterForces(MeshTransform, Params, Wrench);
+	}
+	else
+	{
+		UnderWaterMeshGenerator->GenerateUnderWaterForces(MeshTransform, Params, false, Wrench);
+		bClassifiedThisFrame = true;
 	}
+
+	FixedStepForce = BuoyancyCore::ToUE(Wrench.Force);
+	FixedStepTorque = BuoyancyCore::ToUE(Wrench.Torque);
+}
+
+const BuoyancyCore::IWaterSurface* UBuoyancyActorComponent::GetWaterSurfaceForWorld()
+{
+	//The surface asset hands out the world's shared heightfield cache when it has one turned on
+	return WaterSurface ? WaterSurface->GetSurfaceForWorld(GetWorld()) : nullptr;
+}
+
+bool UBuoyancyActorComponent::FindWater()
+{
+	const FBuoyancyManager* Manager = FBuoyancyManager::Find(GetWorld());
+	if (!Manager || Manager->GetWaterVolumes().GetNum() == 0)
+	{
+		ActiveWaterSurface = GetWaterSurfaceForWorld();
+		ActiveWaterDensity = WaterDensity;
+		ActiveWaterVelocity = FVector::ZeroVector;
+		return true;
+	}
+
+	//The bounds the engine keeps for the whole primitive, no need for anything tighter to rule out most bodies
+	const FBox Box = ParentPrimitive->Bounds.GetBox();
+	const int32 Handle = Manager->GetWaterVolumes().FindBest(BuoyancyCore::ToCore(Box.Min), BuoyancyCore::ToCore(Box.Max));
+	if (Handle < 0)
+	{
+		return false;
+	}
+
+	const BuoyancyCore::FWaterVolume& Volume = Manager->GetWaterVolumes().Get(Handle);
+	ActiveWaterSurface = Volume.Surface;
+	ActiveWaterDensity = Volume.Density;
+	ActiveWaterVelocity = BuoyancyCore::ToUE(Volume.CurrentVelocity);
+	return true;
 }
 
 // found here formula found here https://www.habrador.com/tutorials/unity-boat-tutorial/3-buoyancy/
-FVector UBuoyancyActorComponent::BuoyancyForce(float rho, FTriangleData triangleData)
+FVector UBuoyancyActorComponent::BuoyancyForce(float rho, const FTriangleData& triangleData)
 {
 	//Buoyancy is a hydrostatic force - it's there even if the water isn't flowing or if the boat stays still
 
@@ -151,15 +620,14 @@ FVector UBuoyancyActorComponent::BuoyancyForce(float rho, FTriangleData triangle
 	
 	//
 
-
-	UE_LOG(LogTemp, Warning, TEXT("Force %s, rho %f, gravity %f, distanceToSurface %f, triangle area %f, triangleDataNormal %s"), *buoyancyForce.ToString(), rho, GetWorld()->GetGravityZ(), triangleData.distanceToSurface, triangleData.area, *triangleData.normal.ToString());
-	
 	FVector buoyancyForce = rho * GetWorld()->GetGravityZ() * triangleData.distanceToSurface * triangleData.area * triangleData.normal;
 	
 	//The vertical component of the hydrostatic forces don't cancel out but the horizontal do
 	buoyancyForce.X = 0.0f;
 	buoyancyForce.Y = 0.0f;
 
+	UE_LOG(LogBuoyancyTriangles, Verbose, TEXT("Force %s, rho %f, gravity %f, distanceToSurface %f, triangle area %f, triangleDataNormal %s"), *buoyancyForce.ToString(), rho, GetWorld()->GetGravityZ(), triangleData.distanceToSurface, triangleData.area, *triangleData.normal.ToString());
+
 	return buoyancyForce;
 }
 
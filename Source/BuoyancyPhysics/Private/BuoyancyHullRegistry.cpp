@@ -0,0 +1,326 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BuoyancyHullRegistry.h"
+#include "BuoyancyHullUserData.h"
+#include "BuoyancyCoreConversions.h"
+#include "BuoyancyStats.h"
+#include "HullOptimizer.h"
+#include "CookedHull.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "HAL/IConsoleManager.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "PxTriangleMesh.h"
+#include "PxVec3.h"
+#include "PhysXPublicCore.h"
+#include "PxSimpleTypes.h"
+
+static TAutoConsoleVariable<int32> CVarBuoyancyComparePontoons(
+	TEXT("buoyancy.ComparePontoons"),
+	0,
+	TEXT("1 logs how far the pontoons of every mesh are from clipping its full hull when they are built. A few dozen full clips on the game thread\n")
+	TEXT("per mesh, for checking a pontoon resolution. BuoyancyBench reports the same for its synthetic hulls."),
+	ECVF_Default);
+
+FBuoyancyHullRegistry& FBuoyancyHullRegistry::Get()
+{
+	static FBuoyancyHullRegistry Registry;
+	return Registry;
+}
+
+FBuoyancyHullRegistry::FHullKey FBuoyancyHullRegistry::MakeKey(UStaticMeshComponent* Comp, EBuoyancyHullLOD LOD) const
+{
+	FHullKey Key;
+	Key.Mesh = Comp->GetStaticMesh();
+	if (UBodySetup* BodySetup = Comp->GetBodySetup())
+	{
+		Key.BodySetupGuid = BodySetup->BodySetupGuid;
+	}
+	Key.LOD = LOD;
+	return Key;
+}
+
+std::shared_ptr<const BuoyancyCore::FHullTopology> FBuoyancyHullRegistry::Find(const FHullKey& Key) const
+{
+	const std::weak_ptr<const BuoyancyCore::FHullTopology>* Found = Hulls.Find(Key);
+	return Found ? Found->lock() : nullptr;
+}
+
+void FBuoyancyHullRegistry::Add(const FHullKey& Key, const std::shared_ptr<const BuoyancyCore::FHullTopology>& Hull)
+{
+	//Forget the hulls nobody uses anymore while we are at it, the map stays as small as the set of meshes in use
+	for (auto It = Hulls.CreateIterator(); It; ++It)
+	{
+		if (It.Value().expired())
+		{
+			It.RemoveCurrent();
+		}
+	}
+	Hulls.Add(Key, Hull);
+}
+
+std::shared_ptr<const BuoyancyCore::FHullTopology> FBuoyancyHullRegistry::FindOrAddHull(UStaticMeshComponent* Comp)
+{
+	check(IsInGameThread());
+	if (!Comp || !Comp->GetStaticMesh())
+	{
+		return nullptr;
+	}
+
+	const FHullKey Key = MakeKey(Comp, EBuoyancyHullLOD::Full);
+	std::shared_ptr<const BuoyancyCore::FHullTopology> Hull = Find(Key);
+	if (!Hull)
+	{
+		Hull = LoadHull(Comp);
+		Add(Key, Hull);
+	}
+	return Hull;
+}
+
+std::shared_ptr<const BuoyancyCore::FHullTopology> FBuoyancyHullRegistry::FindOrAddProxy(UStaticMeshComponent* Comp, EBuoyancyHullLOD LOD, const BuoyancyCore::FHullSimplifySettings& Settings)
+{
+	if (LOD == EBuoyancyHullLOD::Full)
+	{
+		return FindOrAddHull(Comp);
+	}
+
+	check(IsInGameThread());
+	if (!Comp || !Comp->GetStaticMesh())
+	{
+		return nullptr;
+	}
+
+	FHullKey Key = MakeKey(Comp, LOD);
+	Key.TargetTriangles = Settings.TargetTriangles;
+	Key.MaxVolumeError = Settings.MaxVolumeError;
+	Key.MaxCentroidError = Settings.MaxCentroidError;
+	std::shared_ptr<const BuoyancyCore::FHullTopology> Proxy = Find(Key);
+	if (Proxy)
+	{
+		return Proxy;
+	}
+
+	UStaticMesh* StaticMesh = Comp->GetStaticMesh();
+	if (const UBuoyancyHullUserData* HullData = StaticMesh->GetAssetUserData<UBuoyancyHullUserData>())
+	{
+		BuoyancyCore::FCookedHullView CookedProxy;
+		if (HullData->GetCookedProxy(StaticMesh, Settings, CookedProxy))
+		{
+			Proxy = BuoyancyCore::FHullTopology::Make(CookedProxy);
+			Add(Key, Proxy);
+			return Proxy;
+		}
+	}
+
+	//Simplifying takes seconds for the largest hulls, far too long to wait for in the middle of a frame
+	if (const TSharedPtr<FProxyBuild, ESPMode::ThreadSafe>* Found = ProxyBuilds.Find(Key))
+	{
+		const TSharedPtr<FProxyBuild, ESPMode::ThreadSafe> Build = *Found;
+		if (!Build->Event->IsComplete())
+		{
+			return nullptr;
+		}
+		ProxyBuilds.Remove(Key);
+		Proxy = Build->Proxy;
+		Add(Key, Proxy);
+
+		UE_LOG(LogBuoyancy, Log, TEXT("%s buoyancy proxy of %s: %d of %d triangles, volume error %.2f%%, centroid error %.2f%%%s"),
+			LOD == EBuoyancyHullLOD::Near ? TEXT("Near") : TEXT("Far"), *StaticMesh->GetName(),
+			Proxy->GetNumTriangles(), Build->SourceTriangles, Build->VolumeError * 100.0f, Build->CentroidError * 100.0f,
+			Build->bReachedTarget ? TEXT("") : TEXT(", stopped by the error limits before the triangle budget"));
+		return Proxy;
+	}
+
+	//The task holds the full hull while simplifying, even if no one else uses it anymore
+	TSharedPtr<FProxyBuild, ESPMode::ThreadSafe> Build = MakeShared<FProxyBuild, ESPMode::ThreadSafe>();
+	std::shared_ptr<const BuoyancyCore::FHullTopology> FullHull = FindOrAddHull(Comp);
+	Build->Event = FFunctionGraphTask::CreateAndDispatchWhenReady([Build, FullHull, Settings]()
+	{
+		BuoyancyCore::FHullMesh Source;
+		FullHull->ToHullMesh(Source);
+
+		BuoyancyCore::FHullSimplifyResult Result;
+		BuoyancyCore::FHullMesh ProxyMesh;
+		BuoyancyCore::BuildProxyHull(Source, Settings, ProxyMesh, Result);
+		Build->Proxy = BuoyancyCore::FHullTopology::Make(ProxyMesh.Vertices.data(), (int32)ProxyMesh.Vertices.size(), ProxyMesh.Indexes.data(), (int32)ProxyMesh.Indexes.size());
+		Build->SourceTriangles = Source.GetNumTriangles();
+		Build->VolumeError = Result.VolumeError;
+		Build->CentroidError = Result.CentroidError;
+		Build->bReachedTarget = Result.bReachedTarget;
+	}, TStatId(), nullptr, ENamedThreads::AnyBackgroundThreadNormalTask);
+	ProxyBuilds.Add(Key, Build);
+	return nullptr;
+}
+
+std::shared_ptr<const BuoyancyCore::FHullPontoons> FBuoyancyHullRegistry::FindOrAddPontoons(UStaticMeshComponent* Comp, const BuoyancyCore::FPontoonSettings& Settings)
+{
+	check(IsInGameThread());
+	if (!Comp || !Comp->GetStaticMesh())
+	{
+		return nullptr;
+	}
+
+	FHullKey Key = MakeKey(Comp, EBuoyancyHullLOD::Full);
+	Key.PontoonResolution = FMath::Max(Settings.Resolution, 1);
+	const std::weak_ptr<const BuoyancyCore::FHullPontoons>* Found = Pontoons.Find(Key);
+	std::shared_ptr<const BuoyancyCore::FHullPontoons> HullPontoons = Found ? Found->lock() : nullptr;
+	if (HullPontoons)
+	{
+		return HullPontoons;
+	}
+
+	const std::shared_ptr<const BuoyancyCore::FHullTopology> FullHull = FindOrAddHull(Comp);
+	HullPontoons = BuoyancyCore::FHullPontoons::Build(*FullHull, Settings);
+	for (auto It = Pontoons.CreateIterator(); It; ++It)
+	{
+		if (It.Value().expired())
+		{
+			It.RemoveCurrent();
+		}
+	}
+	Pontoons.Add(Key, HullPontoons);
+
+#if !NO_LOGGING
+	if (CVarBuoyancyComparePontoons.GetValueOnGameThread() != 0)
+	{
+		BuoyancyCore::FPontoonErrorReport Report;
+		BuoyancyCore::ComparePontoons(FullHull, HullPontoons, Report);
+		UE_LOG(LogBuoyancy, Log, TEXT("Buoyancy pontoons of %s: %d for %d triangles, force error %.2f%% (max %.2f%%), torque error %.2f%% (max %.2f%%) over %d poses"),
+			*Comp->GetStaticMesh()->GetName(), HullPontoons->GetNum(), FullHull->GetNumTriangles(), Report.MeanForceError * 100.0f, Report.MaxForceError * 100.0f,
+			Report.MeanTorqueError * 100.0f, Report.MaxTorqueError * 100.0f, Report.NumPoses);
+	}
+#endif
+	return HullPontoons;
+}
+
+int32 FBuoyancyHullRegistry::GetNumHulls() const
+{
+	int32 Num = 0;
+	for (const auto& Pair : Hulls)
+	{
+		Num += Pair.Value.expired() ? 0 : 1;
+	}
+	return Num;
+}
+
+SIZE_T FBuoyancyHullRegistry::GetAllocatedSize() const
+{
+	SIZE_T Size = Hulls.GetAllocatedSize();
+	for (const auto& Pair : Hulls)
+	{
+		if (const std::shared_ptr<const BuoyancyCore::FHullTopology> Hull = Pair.Value.lock())
+		{
+			Size += sizeof(BuoyancyCore::FHullTopology) + Hull->GetAllocatedSize();
+		}
+	}
+	Size += Pontoons.GetAllocatedSize();
+	for (const auto& Pair : Pontoons)
+	{
+		if (const std::shared_ptr<const BuoyancyCore::FHullPontoons> HullPontoons = Pair.Value.lock())
+		{
+			Size += sizeof(BuoyancyCore::FHullPontoons) + HullPontoons->GetAllocatedSize();
+		}
+	}
+	return Size;
+}
+
+std::shared_ptr<const BuoyancyCore::FHullTopology> FBuoyancyHullRegistry::LoadHull(UStaticMeshComponent* Comp) const
+{
+	//Bulk load the cooked hull when the mesh has one, reading the PhysX mesh is only the fallback
+	UStaticMesh* StaticMesh = Comp->GetStaticMesh();
+	if (const UBuoyancyHullUserData* HullData = StaticMesh->GetAssetUserData<UBuoyancyHullUserData>())
+	{
+		BuoyancyCore::FCookedHullView CookedHull;
+		if (HullData->GetCookedHull(StaticMesh, CookedHull))
+		{
+			return BuoyancyCore::FHullTopology::Make(CookedHull);
+		}
+	}
+
+	TArray<FVector> Vertices;
+	TArray<int> Triangles;
+	if (!GetBodySetupVerticesAndTriangles(Comp->GetBodySetup(), Vertices, Triangles))
+	{
+		//UE_LOG(LogTemp,Warning,TEXT("Getting Vertices and Triangle Failed!!! Bad"));
+	}
+
+	BuoyancyCore::FHullMesh Source;
+	Source.Vertices.reserve(Vertices.Num());
+	for (const FVector& Vertex : Vertices)
+	{
+		Source.Vertices.push_back(BuoyancyCore::ToCore(Vertex));
+	}
+	Source.Indexes.assign(Triangles.GetData(), Triangles.GetData() + Triangles.Num());
+
+	//The PhysX mesh comes in whatever order the cooker left it, with a copy of a vertex for every split normal or uv seam
+	BuoyancyCore::FHullMesh Hull;
+	BuoyancyCore::FHullOptimizeReport Report;
+	BuoyancyCore::OptimizeHull(Source, BuoyancyCore::FHullOptimizeSettings(), Hull, Report);
+	UE_LOG(LogBuoyancy, Log, TEXT("Buoyancy hull of %s from PhysX: %d triangles, removed %d duplicate and %d unused vertices and %d degenerate triangles, gather misses %lld -> %lld"),
+		*StaticMesh->GetName(), Hull.GetNumTriangles(), Report.NumDuplicateVertices, Report.NumUnusedVertices, Report.NumDegenerateTriangles,
+		Report.GatherMissesBefore, Report.GatherMissesAfter);
+	return BuoyancyCore::FHullTopology::Make(Hull.Vertices.data(), (int32)Hull.Vertices.size(), Hull.Indexes.data(), (int32)Hull.Indexes.size());
+}
+
+//some relavant info found here https://wiki.unrealengine.com/Accessing_mesh_triangles_and_vertex_positions_in_build
+bool FBuoyancyHullRegistry::GetBodySetupVerticesAndTriangles(UBodySetup* BodySetup, TArray<FVector>& LocalVertexPositions, TArray<int>& TriangleIndexes)
+{
+	//Body Setup valid?
+	if (!BodySetup || !BodySetup->IsValidLowLevel())
+	{
+		return false;
+	}
+
+	//array as of 4.9
+	for (PxTriangleMesh* EachTriMesh : BodySetup->TriMeshes)
+	{
+		if (!EachTriMesh)
+		{
+			return false;
+		}
+		
+		//Number of vertices
+		PxU32 VertexCount = EachTriMesh->getNbVertices();
+
+		//Vertex array
+		const PxVec3* Vertices = EachTriMesh->getVertices();
+
+		//TRIANGLE POSITIONS 
+		int32 TriNumber = EachTriMesh->getNbTriangles();
+		const void* Triangles = EachTriMesh->getTriangles();
+
+		//Every tri mesh indexes its own vertices, which go after the ones of the meshes before it
+		const int32 BaseVertex = LocalVertexPositions.Num();
+
+		// Note amound of triangle indexes should always be 3x the amount of triangles
+		//The index width is the same for the whole mesh, so it is checked once and the indexes are widened in one loop
+		const int32 FirstIndex = TriangleIndexes.AddUninitialized(TriNumber * 3);
+		int* OutIndexes = TriangleIndexes.GetData() + FirstIndex;
+		if (EachTriMesh->getTriangleMeshFlags() & PxTriangleMeshFlag::e16_BIT_INDICES)
+		{
+			const PxU16* P16BitIndices = (const PxU16*)Triangles;
+			for (int32 i = 0; i < TriNumber * 3; i++)
+			{
+				OutIndexes[i] = BaseVertex + P16BitIndices[i];
+			}
+		}
+		else
+		{
+			const PxU32* P32BitIndices = (const PxU32*)Triangles;
+			for (int32 i = 0; i < TriNumber * 3; i++)
+			{
+				OutIndexes[i] = BaseVertex + (int32)P32BitIndices[i];
+			}
+		}
+
+		// VERTEX POSITIONS
+		LocalVertexPositions.Reserve(LocalVertexPositions.Num() + VertexCount);
+		for (PxU32 v = 0; v < VertexCount; v++)
+		{
+			LocalVertexPositions.Add(P2UVector(Vertices[v]));
+		}
+	}
+
+	return true;
+}
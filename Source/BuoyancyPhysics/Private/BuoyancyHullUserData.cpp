@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BuoyancyHullUserData.h"
+#include "BuoyancyHullRegistry.h"
+#include "BuoyancyCoreConversions.h"
+#include "Engine/StaticMesh.h"
+#include "PhysicsEngine/BodySetup.h"
+
+bool UBuoyancyHullUserData::GetCookedHull(const UStaticMesh* Mesh, BuoyancyCore::FCookedHullView& OutView) const
+{
+	OutView = BuoyancyCore::FCookedHullView();
+	if (!Mesh || !Mesh->BodySetup || Mesh->BodySetup->BodySetupGuid != SourceBodySetupGuid)
+	{
+		return false;
+	}
+	return BuoyancyCore::ReadCookedHull(CookedHull.GetData(), CookedHull.Num(), OutView);
+}
+
+bool UBuoyancyHullUserData::GetCookedProxy(const UStaticMesh* Mesh, const BuoyancyCore::FHullSimplifySettings& Settings, BuoyancyCore::FCookedHullView& OutView) const
+{
+	BuoyancyCore::FCookedHullView Hull;
+	if (!GetCookedHull(Mesh, Hull))
+	{
+		OutView = BuoyancyCore::FCookedHullView();
+		return false;
+	}
+	return Hull.FindProxy(Settings, OutView);
+}
+
+void UBuoyancyHullUserData::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	//A byte array goes through the archive in one Serialize call
+	Ar << CookedHull;
+}
+
+#if WITH_EDITOR
+void UBuoyancyHullUserData::CookFromMesh(UStaticMesh* Mesh)
+{
+	CookedHull.Reset();
+	SourceBodySetupGuid.Invalidate();
+
+	UBodySetup* BodySetup = Mesh ? Mesh->BodySetup : nullptr;
+	if (!BodySetup)
+	{
+		return;
+	}
+	BodySetup->CreatePhysicsMeshes();
+
+	TArray<FVector> Vertices;
+	TArray<int> Triangles;
+	if (!FBuoyancyHullRegistry::GetBodySetupVerticesAndTriangles(BodySetup, Vertices, Triangles))
+	{
+		return;
+	}
+
+	BuoyancyCore::FHullMesh Source;
+	Source.Vertices.reserve(Vertices.Num());
+	for (const FVector& Vertex : Vertices)
+	{
+		Source.Vertices.push_back(BuoyancyCore::ToCore(Vertex));
+	}
+	Source.Indexes.assign(Triangles.GetData(), Triangles.GetData() + Triangles.Num());
+
+	//Simplifying a large hull takes long enough that it is done here rather than when a body first picks a proxy
+	BuoyancyCore::FHullSimplifySettings ProxySettings[BuoyancyCore::MaxCookedProxies];
+	ProxySettings[0].TargetTriangles = NearProxyTriangles;
+	ProxySettings[1].TargetTriangles = FarProxyTriangles;
+	for (BuoyancyCore::FHullSimplifySettings& Settings : ProxySettings)
+	{
+		Settings.MaxVolumeError = ProxyMaxVolumeError;
+		Settings.MaxCentroidError = ProxyMaxCentroidError;
+	}
+
+	std::vector<uint8_t> Cooked;
+	BuoyancyCore::CookHull(Source, WeldDistance, ProxySettings, bCookProxies ? BuoyancyCore::MaxCookedProxies : 0, Cooked);
+	CookedHull.SetNumUninitialized((int32)Cooked.size());
+	FMemory::Memcpy(CookedHull.GetData(), Cooked.data(), Cooked.size());
+	SourceBodySetupGuid = BodySetup->BodySetupGuid;
+}
+
+void UBuoyancyHullUserData::PreSave(const class ITargetPlatform* TargetPlatform)
+{
+	Super::PreSave(TargetPlatform);
+
+	//Called for editor saves and for every cook, so shipped data always matches the collision it ships with
+	CookFromMesh(Cast<UStaticMesh>(GetOuter()));
+}
+
+void UBuoyancyHullUserData::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	CookFromMesh(Cast<UStaticMesh>(GetOuter()));
+}
+#endif
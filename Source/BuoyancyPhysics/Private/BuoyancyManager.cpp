@@ -0,0 +1,293 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BuoyancyManager.h"
+#include "BuoyancyActorComponent.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "BuoyancyStats.h"
+
+static TAutoConsoleVariable<int32> CVarBuoyancyParallel(
+	TEXT("buoyancy.Parallel"),
+	1,
+	TEXT("1 runs the buoyancy of all bodies on the worker threads, 0 runs them one after the other on the game thread."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarBuoyancyAsync(
+	TEXT("buoyancy.Async"),
+	1,
+	TEXT("1 lets bodies with bAsyncBuoyancy compute their buoyancy one frame late on a background task, 0 steps every body synchronously."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarBuoyancyBudget(
+	TEXT("buoyancy.BudgetMicroseconds"),
+	1000.0f,
+	TEXT("Estimated worker time in microseconds the synchronous buoyancy steps of one frame may take before reduced rate bodies are pushed to later frames.\n")
+	TEXT("Bodies at the full and analytic tiers always step. 0 for no limit."),
+	ECVF_Default);
+
+TMap<UWorld*, FBuoyancyManager*> FBuoyancyManager::Managers;
+
+void FBuoyancyManagerTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Manager && TickType != LEVELTICK_ViewportsOnly)
+	{
+		if (bEndOfFrame)
+		{
+			Manager->LaunchAsyncStep(DeltaTime);
+		}
+		else
+		{
+			Manager->Tick(DeltaTime);
+		}
+	}
+}
+
+FString FBuoyancyManagerTickFunction::DiagnosticMessage()
+{
+	return bEndOfFrame ? TEXT("FBuoyancyManagerTickFunction[EndOfFrame]") : TEXT("FBuoyancyManagerTickFunction");
+}
+
+FBuoyancyManager* FBuoyancyManager::Get(UWorld* World)
+{
+	if (!World)
+	{
+		return nullptr;
+	}
+
+	if (FBuoyancyManager** Found = Managers.Find(World))
+	{
+		return *Found;
+	}
+
+	static bool bCleanupBound = false;
+	if (!bCleanupBound)
+	{
+		FWorldDelegates::OnWorldCleanup.AddStatic(&FBuoyancyManager::OnWorldCleanup);
+		bCleanupBound = true;
+	}
+
+	FBuoyancyManager* Manager = new FBuoyancyManager(World);
+	Managers.Add(World, Manager);
+	return Manager;
+}
+
+FBuoyancyManager* FBuoyancyManager::Find(UWorld* World)
+{
+	FBuoyancyManager** Found = Managers.Find(World);
+	return Found ? *Found : nullptr;
+}
+
+void FBuoyancyManager::OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+{
+	FBuoyancyManager* Manager = nullptr;
+	if (Managers.RemoveAndCopyValue(World, Manager))
+	{
+		delete Manager;
+	}
+}
+
+FBuoyancyManager::FBuoyancyManager(UWorld* InWorld)
+	: World(InWorld)
+{
+	TickFunction.Manager = this;
+	TickFunction.bCanEverTick = true;
+	TickFunction.bStartWithTickEnabled = true;
+	TickFunction.TickGroup = TG_PrePhysics;
+	//The parallel stage blocks until it is done, it has to start from the game thread
+	TickFunction.bRunOnAnyThread = false;
+	TickFunction.RegisterTickFunction(World->PersistentLevel);
+
+	//After physics and everything else that moves things, so the snapshot is the pose the next physics step starts from
+	EndOfFrameTickFunction.Manager = this;
+	EndOfFrameTickFunction.bEndOfFrame = true;
+	EndOfFrameTickFunction.bCanEverTick = true;
+	EndOfFrameTickFunction.bStartWithTickEnabled = true;
+	EndOfFrameTickFunction.TickGroup = TG_PostUpdateWork;
+	EndOfFrameTickFunction.bRunOnAnyThread = false;
+	EndOfFrameTickFunction.RegisterTickFunction(World->PersistentLevel);
+}
+
+FBuoyancyManager::~FBuoyancyManager()
+{
+	WaitForAsyncStep();
+	TickFunction.UnRegisterTickFunction();
+	EndOfFrameTickFunction.UnRegisterTickFunction();
+}
+
+void FBuoyancyManager::Register(UBuoyancyActorComponent* Component)
+{
+	Components.AddUnique(Component);
+}
+
+void FBuoyancyManager::Unregister(UBuoyancyActorComponent* Component)
+{
+	//The background task may still be writing into it
+	if (AsyncComponents.Contains(Component))
+	{
+		WaitForAsyncStep();
+	}
+	Components.RemoveSingleSwap(Component);
+}
+
+void FBuoyancyManager::WaitForAsyncStep()
+{
+	if (AsyncStepEvent.IsValid())
+	{
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(AsyncStepEvent, ENamedThreads::GameThread);
+		AsyncStepEvent = nullptr;
+	}
+	AsyncComponents.Reset();
+}
+
+void FBuoyancyManager::WaitForAsyncSteps()
+{
+	check(IsInGameThread());
+	for (const auto& Pair : Managers)
+	{
+		Pair.Value->WaitForAsyncStep();
+	}
+}
+
+void FBuoyancyManager::GatherSteps(const TArray<UBuoyancyActorComponent*>& Candidates, float DeltaTime, TArray<UBuoyancyActorComponent*>& OutSteps)
+{
+	const float Budget = CVarBuoyancyBudget.GetValueOnGameThread();
+	float EstimatedCost = 0.0f;
+	OutSteps.Reset();
+	DueComponents.Reset();
+	for (UBuoyancyActorComponent* Component : Candidates)
+	{
+		//Reduced rate bodies get what is left of the budget once every body that has to step is in
+		if (Component->GetSignificanceTier() == EBuoyancySignificanceTier::Reduced)
+		{
+			if (Component->IsStepDue())
+			{
+				DueComponents.Add(Component);
+			}
+			continue;
+		}
+		if (Component->PreBuoyancyStep(Component->GetTimeSinceStep(DeltaTime)))
+		{
+			OutSteps.Add(Component);
+			EstimatedCost += Component->GetStepCost();
+		}
+	}
+
+	//Longest waiting first. A body skipped now applies its last result again, once overdue it steps whatever the budget says
+	DueComponents.Sort([](const UBuoyancyActorComponent& A, const UBuoyancyActorComponent& B)
+	{
+		return A.GetFramesSinceStep() > B.GetFramesSinceStep();
+	});
+	int32 NumDeferred = 0;
+	for (UBuoyancyActorComponent* Component : DueComponents)
+	{
+		if (Budget > 0.0f && EstimatedCost + Component->GetStepCost() > Budget && !Component->IsStepOverdue())
+		{
+			NumDeferred++;
+			continue;
+		}
+		if (Component->PreBuoyancyStep(Component->GetTimeSinceStep(DeltaTime)))
+		{
+			OutSteps.Add(Component);
+			EstimatedCost += Component->GetStepCost();
+		}
+	}
+	INC_DWORD_STAT_BY(STAT_BuoyancyBodiesDeferred, NumDeferred);
+	CSV_CUSTOM_STAT(Buoyancy, BodiesDeferred, NumDeferred, ECsvCustomStatOp::Accumulate);
+}
+
+void FBuoyancyManager::LaunchAsyncStep(float DeltaTime)
+{
+	WaitForAsyncStep();
+	if (CVarBuoyancyAsync.GetValueOnGameThread() == 0)
+	{
+		return;
+	}
+
+	//Same tiers, intervals and budget as the synchronous steps, the budget of the async ones is counted apart since they run on their own
+	StepCandidates.Reset();
+	for (UBuoyancyActorComponent* Component : Components)
+	{
+		if (Component->WantsAsyncBuoyancyStep())
+		{
+			Component->MarkAsyncCandidate();
+			StepCandidates.Add(Component);
+		}
+	}
+	GatherSteps(StepCandidates, DeltaTime, AsyncComponents);
+	for (UBuoyancyActorComponent* Component : AsyncComponents)
+	{
+		Component->MarkAsyncBuoyancyStep();
+	}
+	if (AsyncComponents.Num() == 0)
+	{
+		return;
+	}
+
+	//Runs while the game thread finishes this frame and starts the next one, Tick waits for it before applying
+	const bool bSingleThread = CVarBuoyancyParallel.GetValueOnGameThread() == 0;
+	AsyncStepEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([this, bSingleThread]()
+	{
+		ParallelFor(AsyncComponents.Num(), [this](int32 Index)
+		{
+			AsyncComponents[Index]->ComputeBuoyancyStep();
+		}, bSingleThread);
+	}, TStatId(), nullptr, ENamedThreads::AnyHiPriThreadNormalTask);
+}
+
+void FBuoyancyManager::Tick(float DeltaTime)
+{
+	//Last frame's async step has had the whole frame boundary to finish, normally this doesn't wait at all
+	WaitForAsyncStep();
+	FrameIndex++;
+
+	double StageStart = FPlatformTime::Seconds();
+	auto EndStage = [&StageStart](double& OutSeconds)
+	{
+		const double Now = FPlatformTime::Seconds();
+		OutSeconds = Now - StageStart;
+		StageStart = Now;
+	};
+
+	//Tiers first, they decide which hull the snapshot switches to
+	FBuoyancyViews Views;
+	UBuoyancyActorComponent::GatherSignificanceViews(World, Views);
+	for (UBuoyancyActorComponent* Component : Components)
+	{
+		Component->UpdateSignificance(Views);
+	}
+	EndStage(LastTimings.Significance);
+
+	//Snapshot on the game thread, anything that reads other UObjects happens here.
+	//Async results that are recent enough are applied as they are and the async deferrals were counted at the launch, only
+	//a late async result falls back to a synchronous step
+	const float WorldTime = World->GetTimeSeconds();
+	StepCandidates.Reset();
+	for (UBuoyancyActorComponent* Component : Components)
+	{
+		if (!Component->IsHandledByAsyncStep(WorldTime))
+		{
+			StepCandidates.Add(Component);
+		}
+	}
+	GatherSteps(StepCandidates, DeltaTime, StepComponents);
+	EndStage(LastTimings.Snapshot);
+
+	//Every body only touches its own clipper and scratch buffers, the shared water caches lock themselves
+	const bool bSingleThread = CVarBuoyancyParallel.GetValueOnGameThread() == 0;
+	ParallelFor(StepComponents.Num(), [this](int32 Index)
+	{
+		StepComponents[Index]->ComputeBuoyancyStep();
+	}, bSingleThread);
+	EndStage(LastTimings.Compute);
+
+	//Forces, debug drawing and the procedural mesh all go through the game thread
+	for (UBuoyancyActorComponent* Component : Components)
+	{
+		Component->ApplyBuoyancyStep();
+	}
+	EndStage(LastTimings.Apply);
+	LastTimings.NumStepped = StepComponents.Num();
+}
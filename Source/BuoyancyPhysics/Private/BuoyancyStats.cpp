@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BuoyancyStats.h"
+
+DEFINE_LOG_CATEGORY(LogBuoyancy);
+DEFINE_LOG_CATEGORY(LogBuoyancyTriangles);
+
+DEFINE_STAT(STAT_BuoyancyTransform);
+DEFINE_STAT(STAT_BuoyancyClassify);
+DEFINE_STAT(STAT_BuoyancyClip);
+DEFINE_STAT(STAT_BuoyancyIntegrate);
+DEFINE_STAT(STAT_BuoyancyApply);
+DEFINE_STAT(STAT_BuoyancyDisplay);
+DEFINE_STAT(STAT_BuoyancyTrianglesIn);
+DEFINE_STAT(STAT_BuoyancyTrianglesEmitted);
+DEFINE_STAT(STAT_BuoyancyBodiesProcessed);
+DEFINE_STAT(STAT_BuoyancyBodiesDeferred);
+DEFINE_STAT(STAT_BuoyancyBodiesOutOfWater);
+
+CSV_DEFINE_CATEGORY_MODULE(BUOYANCYPHYSICS_API, Buoyancy, true);
+
+#if STATS
+static TStatId GetStageStatId(BuoyancyCore::EClipStage Stage)
+{
+	switch (Stage)
+	{
+	case BuoyancyCore::EClipStage::Transform:
+		return GET_STATID(STAT_BuoyancyTransform);
+	case BuoyancyCore::EClipStage::Classify:
+		return GET_STATID(STAT_BuoyancyClassify);
+	case BuoyancyCore::EClipStage::Clip:
+		return GET_STATID(STAT_BuoyancyClip);
+	default:
+		return GET_STATID(STAT_BuoyancyIntegrate);
+	}
+}
+#endif
+
+#if CSV_PROFILER
+//Names of the CSV timings, indexed by EClipStage
+static const char* const StageCsvNames[] = { "Transform", "Classify", "Clip", "Integrate" };
+static_assert(ARRAY_COUNT(StageCsvNames) == (int32)BuoyancyCore::EClipStage::Num, "Every clip stage needs a CSV name");
+#endif
+
+void FBuoyancyClipProfiler::BeginStage(BuoyancyCore::EClipStage Stage)
+{
+#if STATS
+	StageCounter.Start(GetStageStatId(Stage));
+#endif
+#if CSV_PROFILER
+	FCsvProfiler::BeginStat(StageCsvNames[(int32)Stage], CSV_CATEGORY_INDEX(Buoyancy));
+#endif
+}
+
+void FBuoyancyClipProfiler::EndStage(BuoyancyCore::EClipStage Stage)
+{
+#if CSV_PROFILER
+	FCsvProfiler::EndStat(StageCsvNames[(int32)Stage], CSV_CATEGORY_INDEX(Buoyancy));
+#endif
+#if STATS
+	StageCounter.Stop();
+#endif
+}
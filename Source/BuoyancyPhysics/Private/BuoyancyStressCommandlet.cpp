@@ -0,0 +1,322 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BuoyancyStressCommandlet.h"
+#include "BuoyancyActorComponent.h"
+#include "BuoyancyManager.h"
+#include "BuoyancyWaterSurface.h"
+#include "BuoyancyStats.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+namespace
+{
+	//Frames before the timing starts, the hulls are loaded and the boats settle on the water
+	const int32 WarmupFrames = 30;
+	const float StressDeltaTime = 1.0f / 60.0f;
+
+	TSharedRef<FJsonObject> MakeStageJson(TArray<double>& Seconds)
+	{
+		Seconds.Sort();
+		double Sum = 0.0;
+		for (const double Sample : Seconds)
+		{
+			Sum += Sample;
+		}
+
+		TSharedRef<FJsonObject> Stage = MakeShared<FJsonObject>();
+		Stage->SetNumberField(TEXT("median_us"), Seconds[Seconds.Num() / 2] * 1000000.0);
+		Stage->SetNumberField(TEXT("mean_us"), Sum / Seconds.Num() * 1000000.0);
+		Stage->SetNumberField(TEXT("max_us"), Seconds.Last() * 1000000.0);
+		return Stage;
+	}
+
+	void MakeSea(UGerstnerBuoyancyWaterSurface* Sea)
+	{
+		//A long swell with some chop across it, fixed so runs stay comparable
+		FGerstnerWaveSettings Swell;
+		Swell.Direction = FVector2D(1.0f, 0.3f);
+		Swell.Wavelength = 6000.0f;
+		Swell.Amplitude = 60.0f;
+		Swell.Steepness = 0.4f;
+
+		FGerstnerWaveSettings Chop;
+		Chop.Direction = FVector2D(-0.4f, 1.0f);
+		Chop.Wavelength = 900.0f;
+		Chop.Amplitude = 15.0f;
+		Chop.Steepness = 0.6f;
+		Chop.Phase = 1.0f;
+
+		Sea->Waves.Add(Swell);
+		Sea->Waves.Add(Chop);
+		Sea->RefreshSurface();
+	}
+}
+
+UBuoyancyStressCommandlet::UBuoyancyStressCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UBuoyancyStressCommandlet::Main(const FString& Params)
+{
+	FBuoyancyStressSettings Settings;
+	float ThresholdPercent = 10.0f;
+	FString OutputPath;
+	FString BaselinePath;
+	FParse::Value(*Params, TEXT("Boats="), Settings.NumBoats);
+	FParse::Value(*Params, TEXT("Frames="), Settings.NumFrames);
+	FParse::Value(*Params, TEXT("Threshold="), ThresholdPercent);
+	FParse::Value(*Params, TEXT("Mesh="), Settings.MeshPath);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FParse::Value(*Params, TEXT("Baseline="), BaselinePath);
+	Settings.bSingleThread = FParse::Param(*Params, TEXT("SingleThread"));
+
+	const TSharedPtr<FJsonObject> Result = RunStress(Settings);
+	if (!Result.IsValid())
+	{
+		return 1;
+	}
+
+	const TSharedPtr<FJsonObject> Stages = Result->GetObjectField(TEXT("stages"));
+	UE_LOG(LogBuoyancy, Display, TEXT("%d boats over %d frames: %.0f body steps/s, compute %.1f us and frame %.1f us median"),
+		(int32)Result->GetNumberField(TEXT("boats")), (int32)Result->GetNumberField(TEXT("frames")), Result->GetNumberField(TEXT("body_steps_per_second")),
+		Stages->GetObjectField(TEXT("compute"))->GetNumberField(TEXT("median_us")), Stages->GetObjectField(TEXT("frame"))->GetNumberField(TEXT("median_us")));
+
+	if (!OutputPath.IsEmpty())
+	{
+		FString Text;
+		const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Text);
+		if (!FJsonSerializer::Serialize(Result.ToSharedRef(), Writer) || !FFileHelper::SaveStringToFile(Text, *OutputPath))
+		{
+			UE_LOG(LogBuoyancy, Error, TEXT("Could not write %s"), *OutputPath);
+			return 1;
+		}
+	}
+
+	if (!BaselinePath.IsEmpty())
+	{
+		FString BaselineText;
+		TSharedPtr<FJsonObject> Baseline;
+		if (!FFileHelper::LoadFileToString(BaselineText, *BaselinePath))
+		{
+			UE_LOG(LogBuoyancy, Error, TEXT("Could not read the baseline %s"), *BaselinePath);
+			return 1;
+		}
+		const TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(BaselineText);
+		if (!FJsonSerializer::Deserialize(Reader, Baseline) || !Baseline.IsValid())
+		{
+			UE_LOG(LogBuoyancy, Error, TEXT("The baseline %s is not valid JSON"), *BaselinePath);
+			return 1;
+		}
+		return CompareWithBaseline(*Result, *Baseline, ThresholdPercent);
+	}
+	return 0;
+}
+
+TSharedPtr<FJsonObject> UBuoyancyStressCommandlet::RunStress(const FBuoyancyStressSettings& Settings)
+{
+	const int32 NumBoats = FMath::Max(Settings.NumBoats, 1);
+	const int32 NumFrames = FMath::Max(Settings.NumFrames, 1);
+
+	UStaticMesh* Mesh = LoadObject<UStaticMesh>(nullptr, *Settings.MeshPath);
+	if (!Mesh)
+	{
+		UE_LOG(LogBuoyancy, Error, TEXT("Could not load the boat mesh %s"), *Settings.MeshPath);
+		return nullptr;
+	}
+
+	//Put back once the run is over, the automation test runs in a process that goes on
+	IConsoleVariable* ParallelVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("buoyancy.Parallel"));
+	const int32 PreviousParallel = ParallelVariable->GetInt();
+	if (Settings.bSingleThread)
+	{
+		ParallelVariable->Set(0, ECVF_SetByCode);
+	}
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("BuoyancyStress"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	UGerstnerBuoyancyWaterSurface* Sea = NewObject<UGerstnerBuoyancyWaterSurface>(GetTransientPackage());
+	MakeSea(Sea);
+
+	//A square grid around the origin, far enough apart that the boats don't touch, every one at another phase of the waves
+	const FBoxSphereBounds MeshBounds = Mesh->GetBounds();
+	const float Spacing = FMath::Max(MeshBounds.BoxExtent.X, MeshBounds.BoxExtent.Y) * 4.0f;
+	const int32 GridSide = FMath::CeilToInt(FMath::Sqrt((float)NumBoats));
+	TArray<UBuoyancyActorComponent*> Boats;
+	Boats.Reserve(NumBoats);
+	for (int32 Index = 0; Index < NumBoats; Index++)
+	{
+		const FVector Location((Index % GridSide - GridSide * 0.5f) * Spacing, (Index / GridSide - GridSide * 0.5f) * Spacing, 0.0f);
+		AStaticMeshActor* Actor = World->SpawnActor<AStaticMeshActor>(Location, FRotator(0.0f, (float)(Index * 37 % 360), 0.0f));
+		UStaticMeshComponent* MeshComponent = Actor->GetStaticMeshComponent();
+		MeshComponent->SetMobility(EComponentMobility::Movable);
+		MeshComponent->SetStaticMesh(Mesh);
+		MeshComponent->SetSimulatePhysics(true);
+
+		UBuoyancyActorComponent* Boat = NewObject<UBuoyancyActorComponent>(Actor);
+		Boat->WaterSurface = Sea;
+		//Net force and torque of every step, they make the checksums
+		Boat->ForceMode = EBuoyancyForceMode::Aggregated;
+		//The debug view would time the procedural mesh updates instead of the buoyancy, buoyancy.Visualize 1 still turns it on
+		Boat->bVisualizeUnderWaterMesh = false;
+		Boat->RegisterComponent();
+		Boats.Add(Boat);
+	}
+
+	const FBuoyancyManager* Manager = FBuoyancyManager::Find(World);
+	if (!Manager)
+	{
+		UE_LOG(LogBuoyancy, Error, TEXT("No buoyancy manager was made for the stress world"));
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		ParallelVariable->Set(PreviousParallel, ECVF_SetByCode);
+		return nullptr;
+	}
+
+	TArray<double> FrameSeconds;
+	TArray<double> SignificanceSeconds;
+	TArray<double> SnapshotSeconds;
+	TArray<double> ComputeSeconds;
+	TArray<double> ApplySeconds;
+	FrameSeconds.Reserve(NumFrames);
+	SignificanceSeconds.Reserve(NumFrames);
+	SnapshotSeconds.Reserve(NumFrames);
+	ComputeSeconds.Reserve(NumFrames);
+	ApplySeconds.Reserve(NumFrames);
+	int64 NumSteps = 0;
+	double ManagerSeconds = 0.0;
+	double ForceChecksum = 0.0;
+	double TorqueChecksum = 0.0;
+
+	for (int32 Frame = 0; Frame < WarmupFrames + NumFrames; Frame++)
+	{
+		const double FrameStart = FPlatformTime::Seconds();
+		World->Tick(LEVELTICK_All, StressDeltaTime);
+		const double FrameEnd = FPlatformTime::Seconds();
+		if (Frame < WarmupFrames)
+		{
+			continue;
+		}
+
+		const FBuoyancyManagerTimings& Timings = Manager->GetLastTimings();
+		FrameSeconds.Add(FrameEnd - FrameStart);
+		SignificanceSeconds.Add(Timings.Significance);
+		SnapshotSeconds.Add(Timings.Snapshot);
+		ComputeSeconds.Add(Timings.Compute);
+		ApplySeconds.Add(Timings.Apply);
+		ManagerSeconds += Timings.Significance + Timings.Snapshot + Timings.Compute + Timings.Apply;
+		NumSteps += Timings.NumStepped;
+
+		for (const UBuoyancyActorComponent* Boat : Boats)
+		{
+			const BuoyancyCore::FBuoyancyWrench& Wrench = Boat->GetStepWrench();
+			ForceChecksum += Wrench.Force.Z;
+			TorqueChecksum += Wrench.Torque.Size();
+		}
+	}
+
+	double HeightChecksum = 0.0;
+	for (const UBuoyancyActorComponent* Boat : Boats)
+	{
+		HeightChecksum += Boat->GetOwner()->GetActorLocation().Z;
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	ParallelVariable->Set(PreviousParallel, ECVF_SetByCode);
+
+	TSharedRef<FJsonObject> Stages = MakeShared<FJsonObject>();
+	Stages->SetObjectField(TEXT("frame"), MakeStageJson(FrameSeconds));
+	Stages->SetObjectField(TEXT("significance"), MakeStageJson(SignificanceSeconds));
+	Stages->SetObjectField(TEXT("snapshot"), MakeStageJson(SnapshotSeconds));
+	Stages->SetObjectField(TEXT("compute"), MakeStageJson(ComputeSeconds));
+	Stages->SetObjectField(TEXT("apply"), MakeStageJson(ApplySeconds));
+
+	const double Throughput = ManagerSeconds > 0.0 ? (double)NumSteps / ManagerSeconds : 0.0;
+	TSharedRef<FJsonObject> Result = MakeShared<FJsonObject>();
+	Result->SetNumberField(TEXT("boats"), NumBoats);
+	Result->SetNumberField(TEXT("frames"), NumFrames);
+	Result->SetNumberField(TEXT("delta_time"), StressDeltaTime);
+	Result->SetStringField(TEXT("mesh"), Settings.MeshPath);
+	Result->SetBoolField(TEXT("single_thread"), Settings.bSingleThread);
+	Result->SetObjectField(TEXT("stages"), Stages);
+	Result->SetNumberField(TEXT("body_steps"), (double)NumSteps);
+	Result->SetNumberField(TEXT("body_steps_per_second"), Throughput);
+	Result->SetNumberField(TEXT("force_checksum"), ForceChecksum);
+	Result->SetNumberField(TEXT("torque_checksum"), TorqueChecksum);
+	Result->SetNumberField(TEXT("height_checksum"), HeightChecksum);
+	return Result;
+}
+
+int32 UBuoyancyStressCommandlet::CompareWithBaseline(const FJsonObject& Result, const FJsonObject& Baseline, float ThresholdPercent)
+{
+	//Throughput doesn't scale linearly with the boats, only the same run can be compared
+	int32 BaselineBoats = 0;
+	int32 BaselineFrames = 0;
+	Baseline.TryGetNumberField(TEXT("boats"), BaselineBoats);
+	Baseline.TryGetNumberField(TEXT("frames"), BaselineFrames);
+	const int32 NumBoats = (int32)Result.GetNumberField(TEXT("boats"));
+	const int32 NumFrames = (int32)Result.GetNumberField(TEXT("frames"));
+	if (BaselineBoats != NumBoats || BaselineFrames != NumFrames)
+	{
+		UE_LOG(LogBuoyancy, Error, TEXT("The baseline was made with %d boats over %d frames, this run has %d over %d"), BaselineBoats, BaselineFrames, NumBoats, NumFrames);
+		return 1;
+	}
+
+	//Another mesh has other hull sizes, and the threading changes the compute time more than any regression would
+	FString BaselineMesh;
+	bool bBaselineSingleThread = false;
+	Baseline.TryGetStringField(TEXT("mesh"), BaselineMesh);
+	Baseline.TryGetBoolField(TEXT("single_thread"), bBaselineSingleThread);
+	const FString Mesh = Result.GetStringField(TEXT("mesh"));
+	const bool bSingleThread = Result.GetBoolField(TEXT("single_thread"));
+	if (BaselineMesh != Mesh || bBaselineSingleThread != bSingleThread)
+	{
+		UE_LOG(LogBuoyancy, Error, TEXT("The baseline was made with %s%s, this run with %s%s"), *BaselineMesh, bBaselineSingleThread ? TEXT(" on one thread") : TEXT(""),
+			*Mesh, bSingleThread ? TEXT(" on one thread") : TEXT(""));
+		return 1;
+	}
+
+	static const TCHAR* const Checksums[] = { TEXT("force_checksum"), TEXT("torque_checksum"), TEXT("height_checksum") };
+	for (const TCHAR* Name : Checksums)
+	{
+		double BaselineValue = 0.0;
+		const double Value = Result.GetNumberField(Name);
+		if (Baseline.TryGetNumberField(Name, BaselineValue) && !FMath::IsNearlyEqual(Value, BaselineValue, FMath::Abs(BaselineValue) * 1.0e-3 + KINDA_SMALL_NUMBER))
+		{
+			UE_LOG(LogBuoyancy, Warning, TEXT("%s is %g, %g in the baseline. The forces changed"), Name, Value, BaselineValue);
+		}
+	}
+
+	double BaselineThroughput = 0.0;
+	Baseline.TryGetNumberField(TEXT("body_steps_per_second"), BaselineThroughput);
+	const double Throughput = Result.GetNumberField(TEXT("body_steps_per_second"));
+	const double ChangePercent = BaselineThroughput > 0.0 ? (Throughput / BaselineThroughput - 1.0) * 100.0 : 0.0;
+	if (ChangePercent < -ThresholdPercent)
+	{
+		UE_LOG(LogBuoyancy, Error, TEXT("Throughput regressed by %.1f%%: %.0f body steps/s against %.0f in the baseline, the threshold is %.1f%%"),
+			-ChangePercent, Throughput, BaselineThroughput, ThresholdPercent);
+		return 1;
+	}
+
+	UE_LOG(LogBuoyancy, Display, TEXT("Throughput %+.1f%% against the baseline"), ChangePercent);
+	return 0;
+}
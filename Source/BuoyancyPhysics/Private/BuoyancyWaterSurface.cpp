@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BuoyancyWaterSurface.h"
+#include "BuoyancyManager.h"
+
+float UBuoyancyWaterSurface::GetWaterHeight(const FVector& Location, float Time) const
+{
+	const BuoyancyCore::IWaterSurface* Surface = GetCoreSurface();
+	if (!Surface)
+	{
+		return 0.0f;
+	}
+
+	//A batch of one, gameplay queries are rare enough that this is fine
+	float Height = 0.0f;
+	Surface->GetHeights(&Location.X, &Location.Y, 1, Time, &Height);
+	return Height;
+}
+
+const BuoyancyCore::IWaterSurface* UBuoyancyWaterSurface::GetSurfaceForWorld(UWorld* World)
+{
+	if (!bUseHeightfieldCache || !World)
+	{
+		return GetCoreSurface();
+	}
+
+	TUniquePtr<BuoyancyCore::FWaterHeightfieldCache>* Found = WorldCaches.Find(World);
+	if (Found)
+	{
+		return Found->Get();
+	}
+
+	//First boat in a new world, a good moment to forget the worlds that are gone
+	for (auto It = WorldCaches.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	TUniquePtr<BuoyancyCore::FWaterHeightfieldCache>& Cache = WorldCaches.Add(World, MakeUnique<BuoyancyCore::FWaterHeightfieldCache>());
+	Cache->SetSource(GetCoreSurface(), GetCacheSettings());
+	return Cache.Get();
+}
+
+BuoyancyCore::FWaterHeightfieldCache::FSettings UBuoyancyWaterSurface::GetCacheSettings() const
+{
+	BuoyancyCore::FWaterHeightfieldCache::FSettings Settings;
+	Settings.CellSize = CacheCellSize;
+	Settings.TileResolution = CacheTileResolution;
+	Settings.MaxTiles = CacheMaxTiles;
+	Settings.TimeStep = CacheTimeStep;
+	return Settings;
+}
+
+void UBuoyancyWaterSurface::RefreshSurface()
+{
+	//The async steps read the surface and its caches from their task
+	check(IsInGameThread());
+	FBuoyancyManager::WaitForAsyncSteps();
+	UpdateCoreSurface();
+
+	//The tiles were built from the old settings
+	for (auto& Pair : WorldCaches)
+	{
+		Pair.Value->SetSource(GetCoreSurface(), GetCacheSettings());
+	}
+}
+
+void UBuoyancyWaterSurface::PostInitProperties()
+{
+	Super::PostInitProperties();
+	//No step can be reading an object that is still being made or loaded and it has no caches yet, so no RefreshSurface.
+	//This can also run off the game thread
+	UpdateCoreSurface();
+}
+
+void UBuoyancyWaterSurface::PostLoad()
+{
+	Super::PostLoad();
+	UpdateCoreSurface();
+}
+
+#if WITH_EDITOR
+void UBuoyancyWaterSurface::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	RefreshSurface();
+}
+#endif
+
+void UFlatBuoyancyWaterSurface::UpdateCoreSurface()
+{
+	Surface.SetHeight(Height);
+}
+
+void UGerstnerBuoyancyWaterSurface::UpdateCoreSurface()
+{
+	TArray<BuoyancyCore::FGerstnerWave, TInlineAllocator<8>> CoreWaves;
+	for (const FGerstnerWaveSettings& Settings : Waves)
+	{
+		BuoyancyCore::FGerstnerWave& Wave = CoreWaves.AddDefaulted_GetRef();
+		Wave.DirectionX = Settings.Direction.X;
+		Wave.DirectionY = Settings.Direction.Y;
+		Wave.Wavelength = Settings.Wavelength;
+		Wave.Amplitude = Settings.Amplitude;
+		Wave.Steepness = Settings.Steepness;
+		Wave.Phase = Settings.Phase;
+	}
+
+	Surface.SetWaves(CoreWaves.GetData(), CoreWaves.Num(), MeanHeight);
+	Surface.SetInversionIterations(InversionIterations);
+}
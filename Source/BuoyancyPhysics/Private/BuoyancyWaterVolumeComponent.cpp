@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BuoyancyWaterVolumeComponent.h"
+#include "BuoyancyWaterSurface.h"
+#include "BuoyancyManager.h"
+#include "BuoyancyCoreConversions.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/World.h"
+
+UBuoyancyWaterVolumeComponent::UBuoyancyWaterVolumeComponent()
+{
+	//Only a region for the buoyancy, nothing should bump into it
+	SetCollisionProfileName(UCollisionProfile::NoCollision_ProfileName);
+	SetGenerateOverlapEvents(false);
+	InitBoxExtent(FVector(5000.0f, 5000.0f, 500.0f));
+}
+
+BuoyancyCore::FWaterVolume UBuoyancyWaterVolumeComponent::MakeCoreVolume()
+{
+	BuoyancyCore::FWaterVolume Volume;
+	//From the transform rather than Bounds, which are only updated after OnUpdateTransform
+	const FBox Box = CalcBounds(GetComponentTransform()).GetBox();
+	Volume.BoundsMin = BuoyancyCore::ToCore(Box.Min);
+	Volume.BoundsMax = BuoyancyCore::ToCore(Box.Max);
+	Volume.Surface = WaterSurface ? WaterSurface->GetSurfaceForWorld(GetWorld()) : nullptr;
+	Volume.Density = WaterDensity;
+	Volume.CurrentVelocity = BuoyancyCore::ToCore(CurrentVelocity);
+	Volume.Priority = Priority;
+	return Volume;
+}
+
+void UBuoyancyWaterVolumeComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (FBuoyancyManager* Manager = FBuoyancyManager::Get(GetWorld()))
+	{
+		VolumeHandle = Manager->GetWaterVolumes().Add(MakeCoreVolume());
+	}
+}
+
+void UBuoyancyWaterVolumeComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FBuoyancyManager* Manager = FBuoyancyManager::Find(GetWorld());
+	if (Manager && VolumeHandle >= 0)
+	{
+		Manager->GetWaterVolumes().Remove(VolumeHandle);
+	}
+	VolumeHandle = -1;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UBuoyancyWaterVolumeComponent::RefreshWaterVolume()
+{
+	FBuoyancyManager* Manager = FBuoyancyManager::Find(GetWorld());
+	if (Manager && VolumeHandle >= 0)
+	{
+		Manager->GetWaterVolumes().Update(VolumeHandle, MakeCoreVolume());
+	}
+}
+
+void UBuoyancyWaterVolumeComponent::OnUpdateTransform(EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	Super::OnUpdateTransform(UpdateTransformFlags, Teleport);
+	RefreshWaterVolume();
+}
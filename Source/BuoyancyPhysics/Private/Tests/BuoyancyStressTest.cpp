@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BuoyancyStressCommandlet.h"
+#include "Misc/AutomationTest.h"
+#include "Dom/JsonObject.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+//The stress commandlet's loop with a few boats, to catch a broken step without a benchmark run:
+//UE4Editor-Cmd BuoyancyPhysics.uproject -nullrhi -unattended -ExecCmds="Automation RunTests Buoyancy; Quit"
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuoyancyStressTest, "Buoyancy.Stress.Small", EAutomationTestFlags::EngineFilter | EAutomationTestFlags::ApplicationContextMask)
+
+bool FBuoyancyStressTest::RunTest(const FString& Parameters)
+{
+	FBuoyancyStressSettings Settings;
+	Settings.NumBoats = 16;
+	Settings.NumFrames = 60;
+
+	const TSharedPtr<FJsonObject> Result = UBuoyancyStressCommandlet::RunStress(Settings);
+	if (!TestTrue(TEXT("The stress run ran"), Result.IsValid()))
+	{
+		return false;
+	}
+
+	TestTrue(TEXT("Bodies were stepped"), Result->GetNumberField(TEXT("body_steps")) > 0.0);
+	static const TCHAR* const Checksums[] = { TEXT("force_checksum"), TEXT("torque_checksum"), TEXT("height_checksum") };
+	for (const TCHAR* Name : Checksums)
+	{
+		const double Value = Result->GetNumberField(Name);
+		TestTrue(FString::Printf(TEXT("%s is finite"), Name), FMath::IsFinite(Value));
+	}
+	//Something floated, the boats start at the water line
+	TestTrue(TEXT("The water pushed on the boats"), Result->GetNumberField(TEXT("force_checksum")) != 0.0);
+	return true;
+}
+
+#endif
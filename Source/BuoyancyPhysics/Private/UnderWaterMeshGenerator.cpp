@@ -3,403 +3,295 @@
 
 #include "UnderWaterMeshGenerator.h"
 #include "Components/StaticMeshComponent.h"
-#include "PxTriangleMesh.h"
-#include "PxVec3.h"
-#include "PhysicsEngine/BodySetup.h"
-#include "PhysXPublicCore.h"
-#include "PxSimpleTypes.h"
 #include "ProceduralMeshComponent.h"
 #include "KismetProceduralMeshLibrary.h"
+#include "BuoyancyHullRegistry.h"
 
 
-void UUnderWaterMeshGenerator::GenerateUnderWaterMesh()
-{	
-
-	//UE_LOG(LogTemp, Warning, TEXT("GeneratUnderWaterMesh"));
-	// get triangles below water
-	UnderWaterTriangleData.Empty();
-
-	//get distance to water
-	for (int32 i = 0; i < MeshVertices.Num(); i++) {
-
-		//The coordinate should be in global position
-		FVector globalPos = ParentMesh->GetComponentTransform().TransformPosition(MeshVertices[i]);
-
-		//Save the global position so we only need to calculate it once here
-		//And if we want to debug we can convert it back to local
-		MeshVerticesGlobal[i] = globalPos;
-		AllDistancesToWater[i] = globalPos.Z - 0;
-
-		//UE_LOG(LogTemp, Warning, TEXT("transform %s"), *ParentMesh->GetComponentTransform().ToString());
-		//UE_LOG(LogTemp, Warning, TEXT("%f"), AllDistancesToWater[i]);
-	}
-
-	AddTriangles();
+void UUnderWaterMeshGenerator::SetWaterSurface(const BuoyancyCore::IWaterSurface* Surface, float Time)
+{
+	GetClipper().SetWaterSurface(Surface, Time);
+	PontoonSolver.SetWaterSurface(Surface, Time);
 }
 
-void UUnderWaterMeshGenerator::DisplayMesh(UProceduralMeshComponent* UnderWaterMesh, TArray<FTriangleData> triangleData)
-{	
-	TArray<FVector> vertices;
-	TArray<int32> triangles;
-	TArray<FVector> normals;
-	TArray<FProcMeshTangent> tangents;
-	//Build the mesh
-	for (int32 i = 0; i < triangleData.Num(); i++)
-	{	
-		
-		//From global coordinates to local coordinates
-		FVector p1 = ParentMesh->GetComponentTransform().InverseTransformPosition(triangleData[i].p1);
-		FVector p2 = ParentMesh->GetComponentTransform().InverseTransformPosition(triangleData[i].p2);
-		FVector p3 = ParentMesh->GetComponentTransform().InverseTransformPosition(triangleData[i].p3);
-
-
-		normals.Add(-(triangleData[i].normal));
-		vertices.Add(p1);
-		triangles.Add(vertices.Num() - 1);
-
-		normals.Add(-(triangleData[i].normal));
-		vertices.Add(p2);
-		triangles.Add(vertices.Num() - 1);
-
-		normals.Add(-(triangleData[i].normal));
-		//UE_LOG(LogTemp, Warning, TEXT("%s"), *triangleData[i].normal.ToString())
-		vertices.Add(p3);
-		triangles.Add(vertices.Num() - 1);
-	}
-
-	if (UnderWaterMesh) {
-		UnderWaterMesh->ClearAllMeshSections();
-		//UKismetProceduralMeshLibrary::CalculateTangentsForMesh(vertices, triangles, TArray<FVector2D>(), OUT normals, OUT tangents);
-		UnderWaterMesh->CreateMeshSection_LinearColor(0, vertices, triangles, normals, TArray<FVector2D>(), TArray<FLinearColor>(), TArray<FProcMeshTangent>(), false);
-		
-	}
-		
-
-
-	//UnderWaterMesh->CreateMeshSection(0, vertices, triangles, normals,, TArray<FColor>(), TArray<FProcMeshTangent>(), false);
-
-	
-
-	// Enable collision data
-	//UnderWaterMesh->ContainsPhysicsTriMeshData(false);
-
-	//UnderWaterMesh->CreateMeshSection_LinearColor(0, vertices, triangles, normals, TArray<FVector2D>(), TArray<FColor>(), TArray<FProcMeshTangent>(), true);
+void UUnderWaterMeshGenerator::SetCoherence(bool bEnable, const BuoyancyCore::FClipCoherenceSettings& Settings)
+{
+	bCoherent = bEnable;
+	CoherenceSettings = Settings;
 }
 
-void UUnderWaterMeshGenerator::ModifyMesh(UStaticMeshComponent* Comp)
+void UUnderWaterMeshGenerator::GenerateUnderWaterMesh()
 {	
-	ParentMesh = Comp;
-	MeshTransform = Comp->GetComponentTransform();
-	//UE_LOG(LogTemp, Warning, TEXT("ModifiyMesh"));
-	if (!GetStaticMeshVertexLocationsAndTriangles(Comp, MeshVerticesGlobal, MeshVertices, MeshTriangles)) {
-		//UE_LOG(LogTemp,Warning,TEXT("Getting Vertices and Triangle Failed!!! Bad"));
-	}
+	//The coordinates should be in global position, the transform is only fetched once for the whole hull
+	GetClipper().GenerateUnderWaterMesh(BuoyancyCore::ToCore(ParentMesh->GetComponentTransform()));
+	RecordClipStats();
 
-	AllDistancesToWater.Init(0, MeshVertices.Num() + 1);
+	CopyUnderWaterTriangleData();
 }
 
-void UUnderWaterMeshGenerator::AddTriangles()
+void UUnderWaterMeshGenerator::GenerateUnderWaterForces(const BuoyancyCore::FBuoyancyParams& Params, bool bBuildTriangleData, BuoyancyCore::FBuoyancyWrench& OutWrench)
 {
-	//List that will store the data we need to sort the vertices based on distance to water
-	TArray<FVertexData> vertexData;
-
-	//Add init data that will be replaced
-	vertexData.Add(FVertexData());
-	vertexData.Add(FVertexData());
-	vertexData.Add(FVertexData());
-
-	//UE_LOG(LogTemp, Warning, TEXT("Addtrias"));
-	//Loop through all the triangles (3 vertices at a time = 1 triangle)
-	int32 i = 0;
-	
-	while (i < MeshTriangles.Num())
-	{	
-		//UE_LOG(LogTemp, Warning, TEXT("%d    %d"), MeshTriangles.Num(), i);
-		//Loop through the 3 vertices
-		for (int32 x = 0; x < 3; x++)
-		{
-			//Save the data we need
-
-			//
-			vertexData[x].distance = AllDistancesToWater[MeshTriangles[i]];
-
-			vertexData[x].index = x;
-
-			vertexData[x].globalVertexPos = MeshVerticesGlobal[MeshTriangles[i]];
-
-			float f = AllDistancesToWater[MeshTriangles[i]];
-			//UE_LOG(LogTemp, Warning, TEXT("Distance to water %f"), f);
-
-			i++;
-		}
-
-
-		//All vertices are above the water
-		if (vertexData[0].distance > 0.0f && vertexData[1].distance > 0.0f && vertexData[2].distance > 0.0f)
-		{	
-			//UE_LOG(LogTemp, Warning, TEXT("Addtrias 1"));
-			continue;
-		}
-
-
-		//Create the triangles that are below the waterline
-
-		//All vertices are underwater
-		if (vertexData[0].distance < 0.0f && vertexData[1].distance < 0.0f && vertexData[2].distance < 0.0f)
-		{	
-			//UE_LOG(LogTemp, Warning, TEXT("Addtrias 2"));
-			FVector p1 = vertexData[0].globalVertexPos;
-			FVector p2 = vertexData[1].globalVertexPos;
-			FVector p3 = vertexData[2].globalVertexPos;
-
-			//Save the triangle in reverse order (unreal counter clockwise for some dumb reason)
-			UnderWaterTriangleData.Add(FTriangleData(p3, p2, p1));
-		}
-		//1 or 2 vertices are below the water
-		else
-		{	
-			//Sort the vertices, may need to reverse this
-			vertexData.Sort([](const FVertexData& a, const FVertexData& b) { return a.distance > b.distance; });
-
-			//vertexData.Sort((const FVertexData x, const FVertexData y) = > x.distance.CompareTo(y.distance));
-
-			//One vertice is above the water, the rest is below
-			if (vertexData[0].distance > 0.0f && vertexData[1].distance < 0.0f && vertexData[2].distance < 0.0f)
-			{	
-
-				//UE_LOG(LogTemp, Warning, TEXT("Addtrias 3"));
-				AddTrianglesOneAboveWater(vertexData);
-			}
-			//Two vertices are above the water, the other is below
-			else if (vertexData[0].distance > 0.0f && vertexData[1].distance > 0.0f && vertexData[2].distance < 0.0f)
-			{	
-
-				//UE_LOG(LogTemp, Warning, TEXT("Addtrias 4"));
-				AddTrianglesTwoAboveWater(vertexData);
-			}
-		}
-	}
+	GenerateUnderWaterForces(ParentMesh->GetComponentTransform(), Params, bBuildTriangleData, OutWrench);
 }
 
-void UUnderWaterMeshGenerator::AddTrianglesOneAboveWater(TArray<FVertexData> vertexData)
+void UUnderWaterMeshGenerator::GenerateUnderWaterForces(const FTransform& ComponentTransform, const BuoyancyCore::FBuoyancyParams& Params, bool bBuildTriangleData, BuoyancyCore::FBuoyancyWrench& OutWrench)
 {
-	//H is always at position 0
-	FVector H = vertexData[0].globalVertexPos;
-
-	//Left of H is M
-	//Right of H is L
-
-	//Find the index of M
-	int M_index = vertexData[0].index - 1;
-	if (M_index < 0)
+	if (bLocalSpaceWater)
 	{
-		M_index = 2;
+		GetClipper().GenerateUnderWaterMeshLocal(BuoyancyCore::ToCore(ComponentTransform), Params, OutWrench);
 	}
-
-	//We also need the heights to water
-	float h_H = vertexData[0].distance;
-	float h_M = 0.0f;
-	float h_L = 0.0f;
-
-	FVector M = FVector::ZeroVector;
-	FVector L = FVector::ZeroVector;
-	//This means M is at position 1 in the List
-	if (vertexData[1].index == M_index)
+	else if (bCoherent)
 	{
-		M = vertexData[1].globalVertexPos;
-		L = vertexData[2].globalVertexPos;
-
-		h_M = vertexData[1].distance;
-		h_L = vertexData[2].distance;
+		GetClipper().GenerateUnderWaterMeshCoherent(BuoyancyCore::ToCore(ComponentTransform), Params, CoherenceSettings, OutWrench);
 	}
 	else
 	{
-		M = vertexData[2].globalVertexPos;
-		L = vertexData[1].globalVertexPos;
-
-		h_M = vertexData[2].distance;
-		h_L = vertexData[1].distance;
+		GetClipper().GenerateUnderWaterMesh(BuoyancyCore::ToCore(ComponentTransform), Params, OutWrench);
 	}
+	RecordClipStats();
 
+	if (bBuildTriangleData)
+	{
+		CopyUnderWaterTriangleData();
+	}
+	else
+	{
+		UnderWaterTriangleData.Reset();
+	}
+}
 
-	//Now we can calculate where we should cut the triangle to form 2 new triangles
-	//because the resulting area will always form a square
-
-	//Point I_M
-	FVector MH = H - M;
-
-	float t_M = -h_M / (h_H - h_M);
-
-	FVector MI_M = t_M * MH;
-
-	FVector I_M = MI_M + M;
-
+void UUnderWaterMeshGenerator::UpdateUnderWaterForces(const FTransform& ComponentTransform, const BuoyancyCore::FBuoyancyParams& Params, BuoyancyCore::FBuoyancyWrench& OutWrench)
+{
+	//A local space clip is about as cheap as the update, and the update only knows world space
+	if (bLocalSpaceWater)
+	{
+		GetClipper().GenerateUnderWaterMeshLocal(BuoyancyCore::ToCore(ComponentTransform), Params, OutWrench);
+	}
+	else
+	{
+		GetClipper().UpdateUnderWaterMesh(BuoyancyCore::ToCore(ComponentTransform), Params, OutWrench);
+	}
+	RecordClipStats();
+}
 
-	//Point I_L
-	FVector LH = H - L;
+void UUnderWaterMeshGenerator::GenerateAnalyticForces(const FTransform& ComponentTransform, const BuoyancyCore::FBuoyancyParams& Params, BuoyancyCore::FBuoyancyWrench& OutWrench)
+{
+	//Not counted in the triangle stats, no triangle is looked at
+	GetClipper().GenerateAnalyticForces(BuoyancyCore::ToCore(ComponentTransform), Params, OutWrench);
+	UnderWaterTriangleData.Reset();
+}
 
-	float t_L = -h_L / (h_H - h_L);
+void UUnderWaterMeshGenerator::GeneratePontoonForces(const FTransform& ComponentTransform, const BuoyancyCore::FBuoyancyParams& Params, BuoyancyCore::FBuoyancyWrench& OutWrench)
+{
+	PontoonSolver.ComputeForces(BuoyancyCore::ToCore(ComponentTransform), Params, OutWrench);
+	UnderWaterTriangleData.Reset();
+}
 
-	FVector LI_L = t_L * LH;
+void UUnderWaterMeshGenerator::RecordClipStats()
+{
+	//Counters are fine to add to from the worker and physics threads the steps run on
+	INC_DWORD_STAT_BY(STAT_BuoyancyTrianglesIn, GetClipper().GetNumTriangles());
+	INC_DWORD_STAT_BY(STAT_BuoyancyTrianglesEmitted, GetClipper().GetNumUnderWaterTriangles());
+	CSV_CUSTOM_STAT(Buoyancy, TrianglesIn, GetClipper().GetNumTriangles(), ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(Buoyancy, TrianglesEmitted, GetClipper().GetNumUnderWaterTriangles(), ECsvCustomStatOp::Accumulate);
+}
 
-	FVector I_L = LI_L + L;
+void UUnderWaterMeshGenerator::CopyUnderWaterTriangleData()
+{
+	// get triangles below water
+	UnderWaterTriangleData.Reset();
 
+	//Reserved once per hull for the most triangles a clip can give, so after that copying never allocates
+	const int32 MaxTriangles = 2 * GetClipper().GetNumTriangles() + 2;
+	if (UnderWaterTriangleData.Max() < MaxTriangles)
+	{
+		UnderWaterTriangleData.Reserve(MaxTriangles);
+		NumBufferSizings++;
+	}
 
-	//Save the data, such as normal, area, etc      
-	//2 triangles below the water
+	const BuoyancyCore::FUnderWaterTriangle* Triangles = GetClipper().GetUnderWaterTriangles();
+	const int32 NumTriangles = GetClipper().GetNumUnderWaterTriangles();
+	for (int32 i = 0; i < NumTriangles; i++)
+	{
+		UnderWaterTriangleData.Add(FTriangleData(Triangles[i]));
+	}
+}
 
-	//Save the triangle in reverse order (unreal counter clockwise for some dumb reason)
-	UnderWaterTriangleData.Add(FTriangleData(I_L, I_M, M));
-	UnderWaterTriangleData.Add(FTriangleData(L, I_L, M));
+FTransform UUnderWaterMeshGenerator::GetParentMeshTransform() const
+{
+	return ParentMesh->GetComponentTransform();
 }
 
-void UUnderWaterMeshGenerator::AddTrianglesTwoAboveWater(TArray<FVertexData> vertexData)
+void UUnderWaterMeshGenerator::DisplayMesh(UProceduralMeshComponent* UnderWaterMesh)
 {
-	//H and M are above the water
-			//H is after the vertice that's below water, which is L
-			//So we know which one is L because it is last in the sorted list
-	FVector L = vertexData[2].globalVertexPos;
-
-	//Find the index of H
-	int H_index = vertexData[2].index + 1;
-	if (H_index > 2)
+	if (!UnderWaterMesh)
 	{
-		H_index = 0;
+		return;
 	}
 
+	const BuoyancyCore::FUnderWaterTriangle* Triangles = GetClipper().GetUnderWaterTriangles();
+	const int32 NumVertices = GetClipper().GetNumUnderWaterTriangles() * 3;
 
-	//We also need the heights to water
-	float h_L = vertexData[2].distance;
-	float h_H = 0.0f;
-	float h_M = 0.0f;
-
-	FVector H = FVector::ZeroVector;
-	FVector M = FVector::ZeroVector;
+	//The section grows to the next power of two so a hull slowly sinking deeper doesn't create it again every frame
+	const bool bCreateSection = NumVertices > DebugSectionVertices || DebugSectionVertices == 0;
+	if (bCreateSection)
+	{
+		DebugSectionVertices = FMath::Max<int32>(3, FMath::RoundUpToPowerOfTwo(NumVertices));
+		DebugVertices.SetNumUninitialized(DebugSectionVertices);
+		DebugNormals.SetNumUninitialized(DebugSectionVertices);
+		DebugIndexes.SetNumUninitialized(DebugSectionVertices);
+		for (int32 i = 0; i < DebugSectionVertices; i++)
+		{
+			DebugIndexes[i] = i;
+		}
+	}
 
-	//This means that H is at position 1 in the list
-	if (vertexData[1].index == H_index)
+	//From global coordinates to local coordinates, unless the clip already was in local space
+	const bool bLocal = GetClipper().IsLocalSpace();
+	const FMatrix WorldToLocal = ParentMesh->GetComponentTransform().ToInverseMatrixWithScale();
+	for (int32 i = 0; i < NumVertices / 3; i++)
 	{
-		H = vertexData[1].globalVertexPos;
-		M = vertexData[0].globalVertexPos;
+		const BuoyancyCore::FUnderWaterTriangle& Triangle = Triangles[i];
+		FVector* Vertices = DebugVertices.GetData() + i * 3;
+		Vertices[0] = BuoyancyCore::ToUE(Triangle.P1);
+		Vertices[1] = BuoyancyCore::ToUE(Triangle.P2);
+		Vertices[2] = BuoyancyCore::ToUE(Triangle.P3);
+		FVector Normal = -BuoyancyCore::ToUE(Triangle.Normal);
+		if (!bLocal)
+		{
+			Vertices[0] = WorldToLocal.TransformPosition(Vertices[0]);
+			Vertices[1] = WorldToLocal.TransformPosition(Vertices[1]);
+			Vertices[2] = WorldToLocal.TransformPosition(Vertices[2]);
+			Normal = WorldToLocal.TransformVector(Normal).GetSafeNormal();
+		}
+		DebugNormals[i * 3 + 0] = Normal;
+		DebugNormals[i * 3 + 1] = Normal;
+		DebugNormals[i * 3 + 2] = Normal;
+	}
+	//The rest of the section collapses to a point
+	for (int32 i = NumVertices; i < DebugSectionVertices; i++)
+	{
+		DebugVertices[i] = FVector::ZeroVector;
+		DebugNormals[i] = FVector::UpVector;
+	}
 
-		h_H = vertexData[1].distance;
-		h_M = vertexData[0].distance;
+	if (bCreateSection)
+	{
+		UnderWaterMesh->CreateMeshSection_LinearColor(0, DebugVertices, DebugIndexes, DebugNormals, TArray<FVector2D>(), TArray<FLinearColor>(), TArray<FProcMeshTangent>(), false);
 	}
 	else
 	{
-		H = vertexData[0].globalVertexPos;
-		M = vertexData[1].globalVertexPos;
-
-		h_H = vertexData[0].distance;
-		h_M = vertexData[1].distance;
+		UnderWaterMesh->UpdateMeshSection_LinearColor(0, DebugVertices, DebugNormals, TArray<FVector2D>(), TArray<FLinearColor>(), TArray<FProcMeshTangent>());
 	}
+}
 
+void UUnderWaterMeshGenerator::HideMesh(UProceduralMeshComponent* UnderWaterMesh)
+{
+	if (UnderWaterMesh)
+	{
+		UnderWaterMesh->ClearAllMeshSections();
+	}
+	DebugVertices.Empty();
+	DebugNormals.Empty();
+	DebugIndexes.Empty();
+	DebugLines.Empty();
+	DebugSectionVertices = 0;
+}
 
-	//Now we can find where to cut the triangle
-
-	//Point J_M
-	FVector LM = M - L;
-
-	float t_M = -h_L / (h_M - h_L);
-
-	FVector LJ_M = t_M * LM;
-
-	FVector J_M = LJ_M + L;
-
-
-	//Point J_H
-	FVector LH = H - L;
+void UUnderWaterMeshGenerator::DrawDebugLines(UWorld* World, float LifeTime)
+{
+	//Lines that have to outlive this frame go to the persistent batcher, like DrawDebugLine does it
+	ULineBatchComponent* LineBatcher = LifeTime > 0.0f ? World->PersistentLineBatcher : World->LineBatcher;
+	if (!LineBatcher)
+	{
+		return;
+	}
 
-	float t_H = -h_L / (h_H - h_L);
+	const BuoyancyCore::FUnderWaterTriangle* Triangles = GetClipper().GetUnderWaterTriangles();
+	const int32 NumTriangles = GetClipper().GetNumUnderWaterTriangles();
+	const bool bLocal = GetClipper().IsLocalSpace();
+	const FMatrix LocalToWorld = ParentMesh->GetComponentTransform().ToMatrixWithScale();
+	const float GravityZ = World->GetGravityZ();
 
-	FVector LJ_H = t_H * LH;
+	DebugLines.Reset(NumTriangles * 2);
+	for (int32 i = 0; i < NumTriangles; i++)
+	{
+		const BuoyancyCore::FUnderWaterTriangle& Triangle = Triangles[i];
+		FVector Center = BuoyancyCore::ToUE(Triangle.Center);
+		FVector Normal = BuoyancyCore::ToUE(Triangle.Normal);
+		if (bLocal)
+		{
+			Center = LocalToWorld.TransformPosition(Center);
+			Normal = LocalToWorld.TransformVector(Normal).GetSafeNormal();
+		}
 
-	FVector J_H = LJ_H + L;
+		//Only the direction of the buoyancy is drawn, see BuoyancyCore::BuoyancyForce
+		const float Force = GravityZ * Triangle.DistanceToSurface * Normal.Z;
+		DebugLines.Add(FBatchedLine(Center, Center + Normal * 3.0f, FLinearColor::Green, LifeTime, 1.0f, 2));
+		DebugLines.Add(FBatchedLine(Center, Center + FVector(0.0f, 0.0f, Force > 0.0f ? 3.0f : -3.0f), FLinearColor::Red, LifeTime, 1.0f, 0));
+	}
+	LineBatcher->DrawLines(DebugLines);
+}
 
+void UUnderWaterMeshGenerator::ModifyMesh(UStaticMeshComponent* Comp)
+{	
+	ParentMesh = Comp;
+	MeshTransform = Comp->GetComponentTransform();
+	UE_LOG(LogBuoyancy, Verbose, TEXT("ModifyMesh %s"), *GetNameSafe(Comp));
 
-	//Save the data, such as normal, area, etc
-	//1 triangle below the water, reverse oder because unreal is dumb
-	UnderWaterTriangleData.Add(FTriangleData(J_M, J_H, L));
+	//Every body of the same mesh shares one copy of the hull, only the clippers' scratch buffers are per body.
+	//The proxies' clippers let go of the old mesh's proxies and are sized again when their LOD is next used
+	FullHull = FBuoyancyHullRegistry::Get().FindOrAddHull(Comp);
+	HullLOD = EBuoyancyHullLOD::Full;
+	for (BuoyancyCore::FHullClipper& Clipper : HullClippers)
+	{
+		Clipper.SetHull(&Clipper == &GetClipper() ? FullHull : nullptr);
+		Clipper.SetProfiler(FBuoyancyClipProfiler::IsAvailable() ? &ClipProfiler : nullptr);
+	}
+	NumBufferSizings++;
+	//The solver never runs at the same time as the clipper, so they can report to the same profiler
+	PontoonSolver.SetProfiler(FBuoyancyClipProfiler::IsAvailable() ? &ClipProfiler : nullptr);
+	PontoonSolver.SetPontoons(nullptr);
+	PontoonResolution = 0;
 }
 
-bool UUnderWaterMeshGenerator::GetStaticMeshVertexLocationsAndTriangles(UStaticMeshComponent* Comp, TArray<FVector>& GlobalVertexPositions, TArray<FVector>& LocalVertexPositions, TArray<int>& TriangleIndexes)
+bool UUnderWaterMeshGenerator::SetHullLOD(EBuoyancyHullLOD LOD, const BuoyancyCore::FHullSimplifySettings& ProxySettings)
 {
-	if (!Comp)
+	if (LOD == HullLOD)
 	{
-		return false;
+		return true;
 	}
 
-	if (!Comp->IsValidLowLevel())
+	//The registry hands out the same proxy for as long as the settings stay the same, so that is the only time the clipper is sized again
+	std::shared_ptr<const BuoyancyCore::FHullTopology> Hull = LOD == EBuoyancyHullLOD::Full ? FullHull : FBuoyancyHullRegistry::Get().FindOrAddProxy(ParentMesh, LOD, ProxySettings);
+	if (!Hull)
 	{
+		//Still being built, the current LOD is clipped until it is there
 		return false;
 	}
+	HullLOD = LOD;
 
-	//Component Transform
-	FTransform RV_Transform = Comp->GetComponentTransform();
-
-	//Body Setup valid?
-	UBodySetup* BodySetup = Comp->GetBodySetup();
-
-	if (!BodySetup || !BodySetup->IsValidLowLevel())
+	BuoyancyCore::FHullClipper& Clipper = GetClipper();
+	if (Clipper.GetHull() != Hull)
 	{
-		return false;
+		Clipper.SetHull(std::move(Hull));
+		NumBufferSizings++;
 	}
-
-	//array as of 4.9
-	for (PxTriangleMesh* EachTriMesh : BodySetup->TriMeshes)
+	else
 	{
-		if (!EachTriMesh)
-		{
-			return false;
-		}
-		
-		//Number of vertices
-		PxU32 VertexCount = EachTriMesh->getNbVertices();
-
-		//Vertex array
-		const PxVec3* Vertices = EachTriMesh->getVertices();
-
-		//TRIANGLE POSITIONS 
-		int32 TriNumber = EachTriMesh->getNbTriangles();
-		const void* Triangles = EachTriMesh->getTriangles();
-
-		// Grab triangle indices
-		int32 I0, I1, I2;
-
-		for (int32 TriIndex = 0; TriIndex < TriNumber; ++TriIndex)
-		{	
-			//could not work here
-			if (EachTriMesh->getTriangleMeshFlags() & PxTriangleMeshFlag::e16_BIT_INDICES)
-			{
-				PxU16* P16BitIndices = (PxU16*)Triangles;
-				I0 = P16BitIndices[(TriIndex * 3) + 0];
-				I1 = P16BitIndices[(TriIndex * 3) + 1];
-				I2 = P16BitIndices[(TriIndex * 3) + 2];
-			}
-			else
-			{
-				PxU32* P32BitIndices = (PxU32*)Triangles;
-				I0 = P32BitIndices[(TriIndex * 3) + 0];
-				I1 = P32BitIndices[(TriIndex * 3) + 1];
-				I2 = P32BitIndices[(TriIndex * 3) + 2];
-			}
-
-			// Note amound of triangle indexes should always be 3x the amount of triangles
-			TriangleIndexes.Add(I0);
-			TriangleIndexes.Add(I1);
-			TriangleIndexes.Add(I2);
-		}
-
-		// VERTEX POSITIONS
-
-		//For each vertex, get global by transforming the position to match the component Transform, and get local
-		for (PxU32 v = 0; v < VertexCount; v++)
-		{
-			GlobalVertexPositions.Add(RV_Transform.TransformPosition(P2UVector(Vertices[v])));
-			LocalVertexPositions.Add(P2UVector(Vertices[v]));
-		}
+		Clipper.ForgetHistory();
 	}
-
 	return true;
 }
 
+void UUnderWaterMeshGenerator::SetPontoons(bool bEnable, const BuoyancyCore::FPontoonSettings& Settings)
+{
+	const int32 Resolution = bEnable ? FMath::Max(Settings.Resolution, 1) : 0;
+	if (Resolution == PontoonResolution)
+	{
+		return;
+	}
+	PontoonResolution = Resolution;
+
+	PontoonSolver.SetPontoons(bEnable ? FBuoyancyHullRegistry::Get().FindOrAddPontoons(ParentMesh, Settings) : nullptr);
+}
@@ -6,11 +6,65 @@
 #include "Components/ActorComponent.h"
 #include "ProceduralMeshComponent.h"
 #include "UnderWaterMeshGenerator.h"
+#include "PhysicsEngine/BodyInstance.h"
 #include "BuoyancyActorComponent.generated.h"
 
 class UStaticMesh;
 class UUnderWaterMeshGenerator;
+class UBuoyancyWaterSurface;
+class FBuoyancyManager;
 
+UENUM(BlueprintType)
+enum class EBuoyancyForceMode : uint8
+{
+	//One AddForceAtLocation for every under water triangle
+	PerTriangle,
+	//All triangles summed into one force and one torque about the center of mass
+	Aggregated
+};
+
+UENUM(BlueprintType)
+enum class EBuoyancyForceModel : uint8
+{
+	//Water pressure on every under water triangle
+	Pressure,
+	//Weight of the displaced water at the center of buoyancy, from the volume the clipped hull closes off.
+	//Bodies entirely in or out of the water skip clipping, forces are always aggregated
+	DisplacedVolume,
+	//Displaced water of a voxel grid of pontoons standing in for the hull, see BuoyancyCore::FHullPontoons. No clip and no
+	//under water mesh, the cost only depends on PontoonResolution. Hydrodynamic forces are not computed, forces are always aggregated
+	Pontoons
+};
+
+//How much work a body gets, from how far it is from the players or how big it looks to them
+UENUM(BlueprintType)
+enum class EBuoyancySignificanceTier : uint8
+{
+	//HullLOD clipped every frame
+	Full,
+	//ReducedTierHullLOD clipped every ReducedTierInterval frames, or later when the frame's budget is spent
+	Reduced,
+	//No clip, see BuoyancyCore::FHullClipper::GenerateAnalyticForces
+	Analytic
+};
+
+UENUM(BlueprintType)
+enum class EBuoyancySignificanceMetric : uint8
+{
+	//Distance from the closest view
+	Distance,
+	//Bounding sphere radius over the half width of the view at that distance, from the view that sees the body biggest
+	ScreenSize
+};
+
+//Where a player looks from, for the significance tiers
+struct FBuoyancyView
+{
+	FVector Location;
+	//1 / tan(FOV / 2)
+	float ScreenScale;
+};
+typedef TArray<FBuoyancyView, TInlineAllocator<4>> FBuoyancyViews;
 
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class BUOYANCYPHYSICS_API UBuoyancyActorComponent : public UActorComponent
@@ -24,17 +78,227 @@ public:
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:	
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
 	virtual void PostLoad();
+
+	//The three stages of one buoyancy update, run by FBuoyancyManager for all bodies at once or by TickComponent for one.
+	//Game thread: snapshot everything the compute stage needs, returns false when there is nothing to compute.
+	//DeltaTime is the time since this body's last step (see GetTimeSinceStep), which for the reduced tier is several frames
+	bool PreBuoyancyStep(float DeltaTime);
+	//Any thread: transform, clip and sum the forces, only touches this component's own data
+	void ComputeBuoyancyStep();
+	//Game thread: hand the forces to the physics engine and update the debug mesh
+	void ApplyBuoyancyStep();
+
+	//For the manager's async step: whether this body should take part, flag the snapshot just taken as async,
+	//and whether the async result is there and no older than MaxAsyncLatency
+	bool WantsAsyncBuoyancyStep() const { return bAsyncBuoyancy && bUseBuoyancyManager && !bUseFixedTimestep; }
+	void MarkAsyncBuoyancyStep() { bStepIsAsync = true; }
+	bool HasAsyncBuoyancyStep(float WorldTime) const { return bStepIsAsync && bStepComputed && WorldTime - StepWaterTime <= MaxAsyncLatency; }
+	//The last async launch looked at this body, until the next ApplyBuoyancyStep
+	void MarkAsyncCandidate() { bAsyncCandidate = true; }
+	//The async launch took care of this body: it stepped and the result is recent enough, or it was left for later like the
+	//synchronous budget would. Only a launched step whose result came too late needs a synchronous one
+	bool IsHandledByAsyncStep(float WorldTime) const { return bAsyncCandidate && (!bStepIsAsync || HasAsyncBuoyancyStep(WorldTime)); }
+
+	//Every player's view point in World, the same for all bodies so it is gathered once per frame
+	static void GatherSignificanceViews(UWorld* World, FBuoyancyViews& OutViews);
+	//Game thread, before PreBuoyancyStep: picks the tier from the views. Without views, or with bSignificance off, it is Full
+	void UpdateSignificance(TArrayView<const FBuoyancyView> Views);
+	EBuoyancySignificanceTier GetSignificanceTier() const { return SignificanceTier; }
+	//Frames since PreBuoyancyStep last snapshot a step. A skipped frame applies the last result again
+	uint64 GetFramesSinceStep() const { return GetStepFrame() - LastStepFrame; }
+	//World time since PreBuoyancyStep last ran, FrameDeltaTime for the first step or a second one within the same frame
+	float GetTimeSinceStep(float FrameDeltaTime) const;
+	//Only reduced rate bodies can be due later, and after twice their interval they are overdue and step whatever the budget
+	bool IsStepDue() const { return SignificanceTier != EBuoyancySignificanceTier::Reduced || GetFramesSinceStep() >= (uint64)FMath::Max(ReducedTierInterval, 1); }
+	bool IsStepOverdue() const { return GetFramesSinceStep() >= 2 * (uint64)FMath::Max(ReducedTierInterval, 1); }
+	//Recent time ComputeBuoyancyStep took in microseconds, 0 before the first one
+	float GetStepCost() const { return StepCostMicroseconds; }
+	//Net force and torque of the last step, only for bodies that use the aggregated forces (see UsesAggregatedForces)
+	const BuoyancyCore::FBuoyancyWrench& GetStepWrench() const { return StepWrench; }
 	
 	UPROPERTY(VisibleAnywhere)
 	UUnderWaterMeshGenerator* UnderWaterMeshGenerator;
 	UPROPERTY(VisibleAnywhere)
 	UProceduralMeshComponent* UnderWaterMesh;
+
+	//How the buoyancy of the under water triangles is handed to the physics engine
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy")
+	EBuoyancyForceMode ForceMode = EBuoyancyForceMode::PerTriangle;
+
+	//How the under water part of the hull is turned into a force
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy")
+	EBuoyancyForceModel ForceModel = EBuoyancyForceModel::Pressure;
+
+	//Water the hull floats in, leave empty for still water at Z = 0. Boats on the same sea should share one asset
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy")
+	UBuoyancyWaterSurface* WaterSurface;
+
+	//Let the world's buoyancy manager step this body together with all the others on the worker threads,
+	//when off the component ticks and does its own work on the game thread
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Buoyancy")
+	bool bUseBuoyancyManager = true;
+
+	//Compute buoyancy on a background task from the end of frame pose and apply it at the start of the next physics step.
+	//Takes buoyancy off the game thread for one frame of lag, needs bUseBuoyancyManager
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Async", meta = (EditCondition = "bUseBuoyancyManager"))
+	bool bAsyncBuoyancy = false;
+
+	//Oldest async result in seconds that is still applied, after a hitch or a missed step the body is stepped synchronously instead
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Async", meta = (ClampMin = "0.0", UIMax = "0.2", EditCondition = "bAsyncBuoyancy"))
+	float MaxAsyncLatency = 0.05f;
+
+	//Clip a simplified proxy of the collision mesh instead of the mesh itself, can be changed while playing. The proxy is cooked with the mesh
+	//when its Buoyancy Hull user data has the same proxy settings, otherwise it is built in the background and the full hull is clipped until then
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Proxy Hull")
+	EBuoyancyHullLOD HullLOD = EBuoyancyHullLOD::Full;
+
+	//Triangle budget of the near proxy
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Proxy Hull", meta = (ClampMin = "4"))
+	int32 NearProxyTriangles = 1000;
+
+	//Triangle budget of the far proxy
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Proxy Hull", meta = (ClampMin = "4"))
+	int32 FarProxyTriangles = 200;
+
+	//Largest change of the displaced volume a proxy may make, as a fraction of the full hull's. Simplifying stops early rather than go past it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Proxy Hull", meta = (ClampMin = "0.0", UIMax = "0.1"))
+	float ProxyMaxVolumeError = 0.02f;
+
+	//Largest movement of the center of buoyancy a proxy may make, as a fraction of the hull's bounding box diagonal
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Proxy Hull", meta = (ClampMin = "0.0", UIMax = "0.1"))
+	float ProxyMaxCentroidError = 0.01f;
+
+	//Reuse or only partly redo last frame's clip while the body and the water barely move, for boats that are mostly at rest like in a harbor
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Coherence")
+	bool bTemporalCoherence = false;
+
+	//Last frame's forces are applied again while no hull vertex moved further than this (cm)... Not with bHydrodynamicForces,
+	//those depend on the velocity and always need a step
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Coherence", meta = (ClampMin = "0.0", UIMax = "5.0", EditCondition = "bTemporalCoherence"))
+	float CoherenceSkipMovement = 0.5f;
+
+	//...and no vertex depth below the water changed by more than this (cm)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Coherence", meta = (ClampMin = "0.0", UIMax = "5.0", EditCondition = "bTemporalCoherence"))
+	float CoherenceSkipDepthChange = 0.5f;
+
+	//Triangles this far (cm) above the waterline of the last full clip are not clipped again until some vertex depth changed by more than it.
+	//Bigger means fewer full clips but more triangles clipped on the others
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Coherence", meta = (ClampMin = "0.0", UIMax = "50.0", EditCondition = "bTemporalCoherence"))
+	float CoherenceBandMargin = 10.0f;
+
+	//Clip in the mesh's own space against a plane fitted to the water under it instead of moving every vertex into world space.
+	//Exact on flat water, only follows waves much longer than the hull. Forces are always aggregated in this mode
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy")
+	bool bLocalSpaceWater = false;
+
+	//Shows the under water mesh with the normal and buoyancy direction of every triangle. Can be switched while playing and costs
+	//nothing when off, buoyancy.Visualize overrides it for every body
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy")
+	bool bVisualizeUnderWaterMesh = true;
+
+	//Refreshes of the visualization per second, 0 for every frame. Lower it when profiling with lots of bodies
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy", meta = (ClampMin = "0.0", UIMax = "60.0", EditCondition = "bVisualizeUnderWaterMesh"))
+	float VisualizationRefreshRate = 0.0f;
+
+	//Viscous resistance, pressure drag and slamming from the velocity of every under water triangle, summed in the same pass
+	//as the buoyancy. Replaces damping on the body, forces are always aggregated in this mode
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Hydrodynamics")
+	bool bHydrodynamicForces = false;
+
+	//Voxels along the longest side of the hull for the pontoons force model, the pontoons cost about Resolution^3 / 3 for a boat shape.
+	//Bodies of the same mesh and resolution share them. The load log tells how far they are from clipping the hull
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Pontoons", meta = (ClampMin = "1", UIMax = "32"))
+	int32 PontoonResolution = 8;
+
+	//Kinematic viscosity of the water in cm^2/s for the viscous resistance, about 0.01 for water
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Hydrodynamics", meta = (ClampMin = "0.0", EditCondition = "bHydrodynamicForces"))
+	float WaterViscosity = 0.01f;
+
+	//Drag on the parts of the hull moving into the water, linear and quadratic in the speed over DragReferenceSpeed
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Hydrodynamics", meta = (ClampMin = "0.0", EditCondition = "bHydrodynamicForces"))
+	float PressureDragLinear = 10.0f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Hydrodynamics", meta = (ClampMin = "0.0", EditCondition = "bHydrodynamicForces"))
+	float PressureDragQuadratic = 10.0f;
+	//How fast the drag falls off for triangles the flow hits at an angle, 0.5 for blunt hulls up to about 1 for slender ones
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Hydrodynamics", meta = (ClampMin = "0.0", UIMax = "2.0", EditCondition = "bHydrodynamicForces"))
+	float PressureDragFalloff = 0.5f;
+
+	//Same for the suction on the parts moving away from the water
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Hydrodynamics", meta = (ClampMin = "0.0", EditCondition = "bHydrodynamicForces"))
+	float SuctionDragLinear = 10.0f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Hydrodynamics", meta = (ClampMin = "0.0", EditCondition = "bHydrodynamicForces"))
+	float SuctionDragQuadratic = 10.0f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Hydrodynamics", meta = (ClampMin = "0.0", UIMax = "2.0", EditCondition = "bHydrodynamicForces"))
+	float SuctionDragFalloff = 0.5f;
+
+	//Speed (cm/s) the drag coefficients are given at
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Hydrodynamics", meta = (ClampMin = "1.0", EditCondition = "bHydrodynamicForces"))
+	float DragReferenceSpeed = 100.0f;
+
+	//Push back from the water when the hull hits it fast, like a bow coming down on a wave
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Hydrodynamics", meta = (EditCondition = "bHydrodynamicForces"))
+	bool bSlamming = true;
+
+	//Rate of change of a triangle's wet area times velocity (cm/s^2) that gets the full slamming force, lower rates get less
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Hydrodynamics", meta = (ClampMin = "0.0", EditCondition = "bSlamming"))
+	float MaxSlammingAcceleration = 1000.0f;
+
+	//How sharply the slamming force falls off below MaxSlammingAcceleration
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Hydrodynamics", meta = (ClampMin = "0.0", UIMax = "4.0", EditCondition = "bSlamming"))
+	float SlammingPower = 2.0f;
+
+	//Give bodies less work the further they are from the players, see EBuoyancySignificanceTier. The manager also spreads the
+	//reduced rate steps over the frames to stay within buoyancy.BudgetMicroseconds, bodies ticking on their own only keep to
+	//their interval. Bodies with bUseFixedTimestep always stay at the full tier
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Significance")
+	bool bSignificance = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Significance", meta = (EditCondition = "bSignificance"))
+	EBuoyancySignificanceMetric SignificanceMetric = EBuoyancySignificanceMetric::Distance;
+
+	//Closer than this (cm) is the full tier...
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Significance", meta = (ClampMin = "0.0", EditCondition = "bSignificance"))
+	float FullTierDistance = 5000.0f;
+
+	//...and further than this the analytic one, reduced in between
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Significance", meta = (ClampMin = "0.0", EditCondition = "bSignificance"))
+	float AnalyticTierDistance = 30000.0f;
+
+	//Same with the screen size, bigger than this is the full tier...
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Significance", meta = (ClampMin = "0.0", UIMax = "1.0", EditCondition = "bSignificance"))
+	float FullTierScreenSize = 0.1f;
+
+	//...and smaller than this the analytic one
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Significance", meta = (ClampMin = "0.0", UIMax = "1.0", EditCondition = "bSignificance"))
+	float AnalyticTierScreenSize = 0.01f;
+
+	//Hull clipped at the reduced tier
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Significance", meta = (EditCondition = "bSignificance"))
+	EBuoyancyHullLOD ReducedTierHullLOD = EBuoyancyHullLOD::Far;
+
+	//Frames between steps at the reduced tier, the last result is applied again in between
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Significance", meta = (ClampMin = "1", UIMax = "10", EditCondition = "bSignificance"))
+	int32 ReducedTierInterval = 4;
+
+	//Runs buoyancy from the physics substep callback at FixedTimestepRate instead of once per rendered frame.
+	//Turn on substepping in the project physics settings for this, forces are always aggregated in this mode
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Fixed Timestep")
+	bool bUseFixedTimestep = false;
+
+	//Buoyancy updates per second in fixed timestep mode, for example 60, 120 or 240
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Fixed Timestep", meta = (ClampMin = "10.0", UIMin = "30.0", UIMax = "240.0", EditCondition = "bUseFixedTimestep"))
+	float FixedTimestepRate = 120.0f;
+
+	//Only the first fixed step of a frame works out which triangles are wet, the others just move the cut points to the new depths
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy|Fixed Timestep", meta = (EditCondition = "bUseFixedTimestep"))
+	bool bReuseWaterlineBetweenSteps = false;
 private:
 	
 	UPROPERTY(VisibleAnywhere)
@@ -42,17 +306,101 @@ private:
 	UPROPERTY(VisibleAnywhere)
 	UPrimitiveComponent* ParentPrimitive;
 
-	//Note RHO of water in real life is normally 1000kg/m^3 
+	//Note RHO of water in real life is normally 1000kg/m^3. Only used while the world has no water volumes, they bring their own
 	UPROPERTY(VisibleAnywhere)
 	float WaterDensity = 1.0f;
 
+	//The water the body is in this frame, from FindWater. Set on the game thread before the step and read by it on any thread
+	const BuoyancyCore::IWaterSurface* ActiveWaterSurface = nullptr;
+	float ActiveWaterDensity = 1.0f;
+	FVector ActiveWaterVelocity = FVector::ZeroVector;
+
 
 	UPROPERTY(VisibleAnywhere)
 	UProceduralMeshComponent* mesh;
 
+	//Snapshot taken by PreBuoyancyStep for ComputeBuoyancyStep and its result
+	FTransform StepMeshTransform;
+	BuoyancyCore::FBuoyancyParams StepParams;
+	const BuoyancyCore::IWaterSurface* StepWaterSurface = nullptr;
+	float StepWaterTime = 0.0f;
+	//What the step does, the settings themselves can change on the game thread while an async step runs
+	EBuoyancySignificanceTier StepTier = EBuoyancySignificanceTier::Full;
+	EBuoyancyForceModel StepForceModel = EBuoyancyForceModel::Pressure;
+	bool bStepAggregated = false;
+	BuoyancyCore::FBuoyancyWrench StepWrench;
+	//Drag and slamming part of StepWrench. They depend on the velocity of the step's frame so only the rest is applied again
+	BuoyancyCore::FBuoyancyWrench StepHydrodynamicWrench;
+	bool bStepComputed = false;
+	//StepWrench was computed since the last ApplyBuoyancyStep, otherwise it is applied again
+	bool bStepFresh = false;
+	//The step was computed by the manager's async task from the end of last frame
+	bool bStepIsAsync = false;
+	bool bAsyncCandidate = false;
+
+	EBuoyancySignificanceTier SignificanceTier = EBuoyancySignificanceTier::Full;
+	//GetStepFrame of the last step snapshot, started at a different phase for every body so the reduced rate ones spread out
+	uint64 LastStepFrame = 0;
+	//The manager stepping this body, from BeginPlay to EndPlay
+	FBuoyancyManager* StepManager = nullptr;
+	//World time of the last step snapshot, negative before the first
+	float LastStepTime = -1.0f;
+	//Written by ComputeBuoyancyStep on whatever thread it ran, only read on the game thread once it is done
+	float StepCostMicroseconds = 0.0f;
+
+	//Fixed timestep state, everything below is only touched by the physics thread between TickComponent calls
+	FCalculateCustomPhysics OnCalculateCustomPhysics;
+	//Time since the last fixed step
+	float FixedStepAccumulator = 0.0f;
+	//Result of the last fixed step, held until the next one like a fixed rate physics engine would
+	FVector FixedStepForce = FVector::ZeroVector;
+	FVector FixedStepTorque = FVector::ZeroVector;
+	bool bClassifiedThisFrame = false;
+	//Copied from the game thread every tick, blueprints can change the properties while the physics runs. The center of mass and
+	//the velocities of the hydrodynamic params are filled in per fixed step
+	BuoyancyCore::FBuoyancyParams FixedStepParams;
+	EBuoyancyForceModel FixedStepForceModel = EBuoyancyForceModel::Pressure;
+	bool bFixedStepReuseWaterline = false;
+	float FixedStepDeltaTime = 0.0f;
+	FVector FixedStepWaterVelocity = FVector::ZeroVector;
+	float FixedStepWaterViscosity = 0.0f;
+	//Water time at the start of the next substep
+	float FixedStepWaterTime = 0.0f;
+	//Surface resolved for this world on the game thread, the physics thread only reads it
+	const BuoyancyCore::IWaterSurface* FixedStepWaterSurface = nullptr;
+	FTransform MeshToBodyTransform;
+	//Mass of the body and length of the hull for the hydrodynamic forces, copied from the game thread every tick
+	float HydrodynamicMass = 0.0f;
+	float HydrodynamicHullLength = 0.0f;
+
 	void InitVariables();
+	//Frame number the reduced rate steps count in, the manager's own frames or GFrameCounter for a body that ticks itself
+	uint64 GetStepFrame() const;
+	//Local space water, the displaced volume and pontoon models, the hydrodynamic forces and the analytic tier only give the net force and torque
+	bool UsesAggregatedForces() const { return ForceMode == EBuoyancyForceMode::Aggregated || bLocalSpaceWater || ForceModel != EBuoyancyForceModel::Pressure || bHydrodynamicForces || SignificanceTier == EBuoyancySignificanceTier::Analytic; }
+	//Hydrodynamic settings for a body moving at these velocities, DeltaTime is the time since the last step for slamming
+	BuoyancyCore::FHydrodynamicParams MakeHydrodynamicParams(const FVector& LinearVelocity, const FVector& AngularVelocity, float DeltaTime) const;
+	BuoyancyCore::EBuoyancyModel GetCoreForceModel() const { return ForceModel == EBuoyancyForceModel::DisplacedVolume ? BuoyancyCore::EBuoyancyModel::DisplacedVolume : BuoyancyCore::EBuoyancyModel::Pressure; }
+	//Switches the generator to HullLOD, or ReducedTierHullLOD at the reduced tier, if it changed. Between steps on the game thread.
+	//Asks again every step while the proxy is still being built
+	void UpdateHullLOD();
+	//Gets or drops the generator's pontoons when the force model or PontoonResolution changed, same rules as UpdateHullLOD
+	void UpdatePontoons();
 	void AddUnderWaterForces();
+	//Refreshes, throttles or hides the debug view after a step was applied
+	void UpdateVisualization();
+	//The debug view currently shows something, and when it was last refreshed
+	bool bVisualizationShown = false;
+	float LastVisualizationTime = 0.0f;
+
+	void SubstepTick(float DeltaTime, FBodyInstance* BodyInstance);
+	void ComputeFixedStep(const FTransform& BodyTransform, const FVector& CenterOfMass, float WaterTime, const FVector& LinearVelocity, const FVector& AngularVelocity);
+	const BuoyancyCore::IWaterSurface* GetWaterSurfaceForWorld();
+	//Looks up the water volume the body's bounds are in and makes it the active water, false when they are in none. Where several
+	//overlap the bounds the body only floats in the best one (see FWaterVolumeRegistry::FindBest).
+	//Without any volumes in the world it is the component's own surface and density
+	bool FindWater();
 
-	FVector BuoyancyForce(float rho, FTriangleData triangleData);
+	FVector BuoyancyForce(float rho, const FTriangleData& triangleData);
 	void CreateTriangle();	
 };
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BuoyancyCoreTypes.h"
+
+//Helpers to go between the engine types and the engine independent BuoyancyCore types
+namespace BuoyancyCore
+{
+	FORCEINLINE FVec3 ToCore(const FVector& V)
+	{
+		return FVec3(V.X, V.Y, V.Z);
+	}
+
+	FORCEINLINE FVector ToUE(const FVec3& V)
+	{
+		return FVector(V.X, V.Y, V.Z);
+	}
+
+	//FMatrix uses row vectors (P' = P * M) so the 3x4 core matrix is its transpose
+	FORCEINLINE FHullTransform ToCore(const FTransform& Transform)
+	{
+		const FMatrix Matrix = Transform.ToMatrixWithScale();
+
+		FHullTransform Result;
+		for (int32 Row = 0; Row < 3; Row++)
+		{
+			for (int32 Col = 0; Col < 4; Col++)
+			{
+				Result.M[Row][Col] = Matrix.M[Col][Row];
+			}
+		}
+		return Result;
+	}
+}
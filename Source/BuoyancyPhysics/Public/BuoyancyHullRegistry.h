@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HullTopology.h"
+#include "HullSimplifier.h"
+#include "HullPontoons.h"
+#include "UnderWaterMeshGenerator.h"
+#include "Async/TaskGraphInterfaces.h"
+#include <memory>
+
+class UStaticMesh;
+class UStaticMeshComponent;
+class UBodySetup;
+
+/**
+ * Hands out the immutable hull (see BuoyancyCore::FHullTopology) of a static mesh and hull LOD, built once
+ * and shared by every generator floating that mesh. The registry only keeps weak references, a hull is freed
+ * when the last generator using it lets go. Game thread only.
+ */
+class BUOYANCYPHYSICS_API FBuoyancyHullRegistry
+{
+public:
+	static FBuoyancyHullRegistry& Get();
+
+	//Full hull of Comp's mesh, from its cooked data if it has some for the current collision, otherwise from the PhysX mesh
+	std::shared_ptr<const BuoyancyCore::FHullTopology> FindOrAddHull(UStaticMeshComponent* Comp);
+	//Proxy of Comp's mesh, from its cooked data if it has one with these settings. Otherwise the first call starts simplifying the
+	//full hull on a background thread and this returns nullptr until that is done, so keep asking
+	std::shared_ptr<const BuoyancyCore::FHullTopology> FindOrAddProxy(UStaticMeshComponent* Comp, EBuoyancyHullLOD LOD, const BuoyancyCore::FHullSimplifySettings& Settings);
+	//Pontoons of Comp's full hull, voxelized the first time they are asked for at this resolution
+	std::shared_ptr<const BuoyancyCore::FHullPontoons> FindOrAddPontoons(UStaticMeshComponent* Comp, const BuoyancyCore::FPontoonSettings& Settings);
+
+	//Hulls alive right now and the memory they and the pontoons hold, for stats
+	int32 GetNumHulls() const;
+	SIZE_T GetAllocatedSize() const;
+
+	//Local vertices and 3 indexes per triangle of all the PhysX triangle meshes of BodySetup, false if it has none
+	static bool GetBodySetupVerticesAndTriangles(UBodySetup* BodySetup, TArray<FVector>& LocalVertexPositions, TArray<int>& TriangleIndexes);
+
+private:
+	struct FHullKey
+	{
+		const UStaticMesh* Mesh = nullptr;
+		//Changes when the collision is rebuilt, so an edited mesh doesn't get its old hull
+		FGuid BodySetupGuid;
+		EBuoyancyHullLOD LOD = EBuoyancyHullLOD::Full;
+		//Zero for the full hull
+		int32 TargetTriangles = 0;
+		float MaxVolumeError = 0.0f;
+		float MaxCentroidError = 0.0f;
+		//Zero for hulls, only the pontoons are keyed by it
+		int32 PontoonResolution = 0;
+
+		bool operator==(const FHullKey& Other) const
+		{
+			return Mesh == Other.Mesh && BodySetupGuid == Other.BodySetupGuid && LOD == Other.LOD && TargetTriangles == Other.TargetTriangles
+				&& MaxVolumeError == Other.MaxVolumeError && MaxCentroidError == Other.MaxCentroidError && PontoonResolution == Other.PontoonResolution;
+		}
+
+		friend uint32 GetTypeHash(const FHullKey& Key)
+		{
+			uint32 Hash = HashCombine(PointerHash(Key.Mesh), GetTypeHash(Key.BodySetupGuid));
+			Hash = HashCombine(Hash, GetTypeHash((uint8)Key.LOD));
+			Hash = HashCombine(Hash, GetTypeHash(Key.TargetTriangles));
+			return HashCombine(Hash, GetTypeHash(Key.PontoonResolution));
+		}
+	};
+
+	TMap<FHullKey, std::weak_ptr<const BuoyancyCore::FHullTopology>> Hulls;
+	TMap<FHullKey, std::weak_ptr<const BuoyancyCore::FHullPontoons>> Pontoons;
+
+	//A proxy simplified in the background, Proxy and the stats are written by the task and only read once Event is complete
+	struct FProxyBuild
+	{
+		FGraphEventRef Event;
+		std::shared_ptr<const BuoyancyCore::FHullTopology> Proxy;
+		int32 SourceTriangles = 0;
+		float VolumeError = 0.0f;
+		float CentroidError = 0.0f;
+		bool bReachedTarget = false;
+	};
+	//Held until the proxy is asked for again after it is done
+	TMap<FHullKey, TSharedPtr<FProxyBuild, ESPMode::ThreadSafe>> ProxyBuilds;
+
+	FHullKey MakeKey(UStaticMeshComponent* Comp, EBuoyancyHullLOD LOD) const;
+	std::shared_ptr<const BuoyancyCore::FHullTopology> Find(const FHullKey& Key) const;
+	void Add(const FHullKey& Key, const std::shared_ptr<const BuoyancyCore::FHullTopology>& Hull);
+	std::shared_ptr<const BuoyancyCore::FHullTopology> LoadHull(UStaticMeshComponent* Comp) const;
+};
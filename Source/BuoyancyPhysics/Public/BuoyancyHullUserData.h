@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/AssetUserData.h"
+#include "CookedHull.h"
+#include "BuoyancyHullUserData.generated.h"
+
+class UStaticMesh;
+
+/**
+ * Add to a static mesh's Asset User Data to ship its buoyancy hull pre cooked. The hull is read from the
+ * mesh's collision and welded when the mesh is saved or cooked, at runtime the buoyancy component bulk
+ * loads it instead of walking the PhysX triangle mesh. The Near and Far proxies are cooked with it, so
+ * components with the same proxy settings never simplify the hull at runtime. Data cooked from older
+ * collision or by an older version is ignored and the component reads the collision like it would without this.
+ */
+UCLASS(meta = (DisplayName = "Buoyancy Hull"))
+class BUOYANCYPHYSICS_API UBuoyancyHullUserData : public UAssetUserData
+{
+	GENERATED_BODY()
+
+public:
+	//Vertices closer than this (cm) are merged when cooking
+	UPROPERTY(EditAnywhere, Category = "Buoyancy")
+	float WeldDistance = 0.01f;
+
+	//Cook the Near and Far proxies with these settings too. A component with other proxy settings builds its own in the background
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Proxy Hull")
+	bool bCookProxies = true;
+
+	//Same as NearProxyTriangles of the buoyancy component
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Proxy Hull", meta = (ClampMin = "4", EditCondition = "bCookProxies"))
+	int32 NearProxyTriangles = 1000;
+
+	//Same as FarProxyTriangles of the buoyancy component
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Proxy Hull", meta = (ClampMin = "4", EditCondition = "bCookProxies"))
+	int32 FarProxyTriangles = 200;
+
+	//Same as ProxyMaxVolumeError of the buoyancy component
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Proxy Hull", meta = (ClampMin = "0.0", UIMax = "0.1", EditCondition = "bCookProxies"))
+	float ProxyMaxVolumeError = 0.02f;
+
+	//Same as ProxyMaxCentroidError of the buoyancy component
+	UPROPERTY(EditAnywhere, Category = "Buoyancy|Proxy Hull", meta = (ClampMin = "0.0", UIMax = "0.1", EditCondition = "bCookProxies"))
+	float ProxyMaxCentroidError = 0.01f;
+
+	//View into the cooked hull, false when there is none for Mesh's current collision
+	bool GetCookedHull(const UStaticMesh* Mesh, BuoyancyCore::FCookedHullView& OutView) const;
+	//View into the proxy cooked with Settings' target and error limits, false when there is none for Mesh's current collision
+	bool GetCookedProxy(const UStaticMesh* Mesh, const BuoyancyCore::FHullSimplifySettings& Settings, BuoyancyCore::FCookedHullView& OutView) const;
+
+	//Size of the cooked data in bytes, for the details panel and memory reports
+	int32 GetCookedHullSize() const { return CookedHull.Num(); }
+
+	virtual void Serialize(FArchive& Ar) override;
+#if WITH_EDITOR
+	//Reads the collision of Mesh and cooks it and the proxies again
+	void CookFromMesh(UStaticMesh* Mesh);
+
+	virtual void PreSave(const class ITargetPlatform* TargetPlatform) override;
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+	//BuoyancyCore cooked hull, see CookHull. Serialized by hand so it is read as one block
+	TArray<uint8> CookedHull;
+
+	//BodySetupGuid of the collision it was cooked from
+	UPROPERTY()
+	FGuid SourceBodySetupGuid;
+};
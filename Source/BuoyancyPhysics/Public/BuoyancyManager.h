@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "WaterVolumes.h"
+#include "BuoyancyManager.generated.h"
+
+class UBuoyancyActorComponent;
+class FBuoyancyManager;
+
+//Runs the manager once per frame in the pre physics group, where the components used to tick,
+//or at the end of the frame to start the asynchronous step
+USTRUCT()
+struct FBuoyancyManagerTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	FBuoyancyManager* Manager = nullptr;
+	bool bEndOfFrame = false;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FBuoyancyManagerTickFunction> : public TStructOpsTypeTraitsBase2<FBuoyancyManagerTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+//Wall clock time of the parts of one manager tick in seconds. The async steps run outside of it and aren't counted
+struct FBuoyancyManagerTimings
+{
+	//Significance tiers of every body
+	double Significance = 0.0;
+	//PreBuoyancyStep of the bodies that step, plus the budget
+	double Snapshot = 0.0;
+	//The ParallelFor, waiting for the slowest worker included
+	double Compute = 0.0;
+	double Apply = 0.0;
+	int32 NumStepped = 0;
+};
+
+/**
+ * One per world, steps every registered buoyancy component together instead of each ticking on its own:
+ * the snapshot of every body is taken on the game thread, the transform, clip and force sum of all bodies
+ * run in one ParallelFor over the task graph workers, then the forces are applied on the game thread.
+ * This is what UWorldSubsystem would be for, which this engine version doesn't have yet.
+ *
+ * Bodies with bAsyncBuoyancy are snapshot at the end of the frame instead and computed on a background task
+ * while the next frame's game code runs, the pre physics tick then only waits for it and applies the forces.
+ * A body whose async result is missing or older than its MaxAsyncLatency is stepped synchronously instead.
+ *
+ * With bSignificance the bodies get their tier from the players' views first. Reduced rate bodies that are due only step
+ * while the estimated cost of the frame's steps stays within buoyancy.BudgetMicroseconds, the ones that waited longest go first.
+ *
+ * Also holds the world's water volumes (see UBuoyancyWaterVolumeComponent), which every body looks up once per frame on the game thread.
+ */
+class BUOYANCYPHYSICS_API FBuoyancyManager
+{
+public:
+	//Manager of World, made the first time a component asks for it and destroyed with the world
+	static FBuoyancyManager* Get(UWorld* World);
+	//Same without making one
+	static FBuoyancyManager* Find(UWorld* World);
+
+	void Register(UBuoyancyActorComponent* Component);
+	void Unregister(UBuoyancyActorComponent* Component);
+
+	//Game thread only, no step reads them
+	BuoyancyCore::FWaterVolumeRegistry& GetWaterVolumes() { return WaterVolumes; }
+	const BuoyancyCore::FWaterVolumeRegistry& GetWaterVolumes() const { return WaterVolumes; }
+
+	void Tick(float DeltaTime);
+	//Of the last Tick, cheap enough to always be kept so tools can read it without a stats capture
+	const FBuoyancyManagerTimings& GetLastTimings() const { return LastTimings; }
+	int32 GetNumComponents() const { return Components.Num(); }
+	//Ticks of this manager so far, what the reduced rate steps of its bodies count in. Doesn't need the engine loop's GFrameCounter
+	uint64 GetFrameIndex() const { return FrameIndex; }
+	//Snapshots the async bodies and starts their step on a background task
+	void LaunchAsyncStep(float DeltaTime);
+	//Blocks until the async step of every world is done, call before changing anything a step reads that isn't in its snapshot
+	static void WaitForAsyncSteps();
+
+private:
+	explicit FBuoyancyManager(UWorld* InWorld);
+	~FBuoyancyManager();
+
+	UWorld* World;
+	FBuoyancyManagerTickFunction TickFunction;
+	FBuoyancyManagerTickFunction EndOfFrameTickFunction;
+	TArray<UBuoyancyActorComponent*> Components;
+	//Components that have work for the parallel stage this frame, kept to avoid reallocating
+	TArray<UBuoyancyActorComponent*> StepComponents;
+	//Components that could step this frame, before the tiers and the budget
+	TArray<UBuoyancyActorComponent*> StepCandidates;
+	//Reduced rate components that are due this frame, waiting for what is left of the budget
+	TArray<UBuoyancyActorComponent*> DueComponents;
+	//Components the background task is stepping, only touched by the game thread once it is done
+	TArray<UBuoyancyActorComponent*> AsyncComponents;
+	FGraphEventRef AsyncStepEvent;
+	BuoyancyCore::FWaterVolumeRegistry WaterVolumes;
+	FBuoyancyManagerTimings LastTimings;
+	uint64 FrameIndex = 0;
+
+	void WaitForAsyncStep();
+	//Snapshots the Candidates that step this frame into OutSteps: the full and analytic tiers always, the due reduced rate ones
+	//longest waiting first while the budget lasts
+	void GatherSteps(const TArray<UBuoyancyActorComponent*>& Candidates, float DeltaTime, TArray<UBuoyancyActorComponent*>& OutSteps);
+
+	static TMap<UWorld*, FBuoyancyManager*> Managers;
+	static void OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources);
+};
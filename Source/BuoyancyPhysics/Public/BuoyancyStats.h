@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "ClipProfiler.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogBuoyancy, Log, All);
+//One line per triangle, far too much for anything but a single body. Silent until raised with "log LogBuoyancyTriangles VeryVerbose",
+//and compiled out of shipping builds so the formatting costs nothing there
+#if UE_BUILD_SHIPPING
+DECLARE_LOG_CATEGORY_EXTERN(LogBuoyancyTriangles, Warning, NoLogging);
+#else
+DECLARE_LOG_CATEGORY_EXTERN(LogBuoyancyTriangles, Warning, All);
+#endif
+
+//"stat Buoyancy", the clip stages are summed over every body and substep of the frame
+DECLARE_STATS_GROUP(TEXT("Buoyancy"), STATGROUP_Buoyancy, STATCAT_Advanced);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Transform"), STAT_BuoyancyTransform, STATGROUP_Buoyancy, BUOYANCYPHYSICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Classify"), STAT_BuoyancyClassify, STATGROUP_Buoyancy, BUOYANCYPHYSICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Clip"), STAT_BuoyancyClip, STATGROUP_Buoyancy, BUOYANCYPHYSICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Integrate"), STAT_BuoyancyIntegrate, STATGROUP_Buoyancy, BUOYANCYPHYSICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Apply"), STAT_BuoyancyApply, STATGROUP_Buoyancy, BUOYANCYPHYSICS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Display"), STAT_BuoyancyDisplay, STATGROUP_Buoyancy, BUOYANCYPHYSICS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Triangles In"), STAT_BuoyancyTrianglesIn, STATGROUP_Buoyancy, BUOYANCYPHYSICS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Triangles Emitted"), STAT_BuoyancyTrianglesEmitted, STATGROUP_Buoyancy, BUOYANCYPHYSICS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bodies Processed"), STAT_BuoyancyBodiesProcessed, STATGROUP_Buoyancy, BUOYANCYPHYSICS_API);
+//Reduced rate bodies that were due but pushed to a later frame by the budget
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bodies Deferred"), STAT_BuoyancyBodiesDeferred, STATGROUP_Buoyancy, BUOYANCYPHYSICS_API);
+//Bodies outside every water volume, they skip their step
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bodies Out Of Water"), STAT_BuoyancyBodiesOutOfWater, STATGROUP_Buoyancy, BUOYANCYPHYSICS_API);
+
+//Same stages and counters in CsvProfile captures, under the Buoyancy category
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(BUOYANCYPHYSICS_API, Buoyancy);
+
+/**
+ * Feeds the stages of one clipper into the cycle counters above and the Buoyancy CSV category.
+ * Holds the stage that is running, so every clipper needs its own.
+ */
+class BUOYANCYPHYSICS_API FBuoyancyClipProfiler : public BuoyancyCore::IClipProfiler
+{
+public:
+	//Whether there is anything to report to in this build, clippers are better off without a profiler otherwise
+	static constexpr bool IsAvailable() { return STATS || CSV_PROFILER; }
+
+	virtual void BeginStage(BuoyancyCore::EClipStage Stage) override;
+	virtual void EndStage(BuoyancyCore::EClipStage Stage) override;
+
+private:
+#if STATS
+	FCycleCounter StageCounter;
+#endif
+};
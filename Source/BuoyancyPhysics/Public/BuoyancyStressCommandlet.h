@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "BuoyancyStressCommandlet.generated.h"
+
+class FJsonObject;
+
+//One stress run, see UBuoyancyStressCommandlet
+struct FBuoyancyStressSettings
+{
+	int32 NumBoats = 256;
+	//Timed frames, the warmup ones come on top
+	int32 NumFrames = 600;
+	FString MeshPath = TEXT("/Engine/BasicShapes/Cube.Cube");
+	//Steps the bodies on the game thread only, buoyancy.Parallel 0 for the run
+	bool bSingleThread = false;
+};
+
+/**
+ * Headless stress run of the whole buoyancy path, physics and manager included, for seeing how it scales and for catching regressions.
+ * Spawns a grid of boats on a fixed Gerstner sea in a fresh game world, steps it a fixed number of frames at a fixed delta time
+ * and writes the manager's stage timings and checksums of the net forces to JSON.
+ *
+ * UE4Editor-Cmd BuoyancyPhysics.uproject -run=BuoyancyStress -nullrhi -unattended [-Boats=N] [-Frames=N] [-Mesh=Path]
+ *     [-Output=File.json] [-Baseline=File.json] [-Threshold=Percent] [-SingleThread]
+ *
+ * With -Baseline the run fails when its throughput (body steps per second of compute) is more than Threshold percent (default 10)
+ * below the baseline's, or when the baseline was made with a different number of boats or frames, another mesh or the other
+ * threading. Differing checksums only warn, the forces change with every physics or compiler update and aren't the point of the run.
+ * The boats need a mesh with complex collision, the engine's cube is used by default. The automation test Buoyancy.Stress runs
+ * a small version of the same loop.
+ */
+UCLASS()
+class BUOYANCYPHYSICS_API UBuoyancyStressCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UBuoyancyStressCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+	//Spawns the boats in a world of its own, steps it and returns what the commandlet writes to JSON, null when it couldn't run
+	static TSharedPtr<FJsonObject> RunStress(const FBuoyancyStressSettings& Settings);
+
+private:
+	//0 when Result is within the threshold of Baseline
+	static int32 CompareWithBaseline(const FJsonObject& Result, const FJsonObject& Baseline, float ThresholdPercent);
+};
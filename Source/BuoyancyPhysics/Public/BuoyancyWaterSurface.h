@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "WaterSurface.h"
+#include "WaterHeightfieldCache.h"
+#include "BuoyancyWaterSurface.generated.h"
+
+/**
+ * Editor facing wrapper around a BuoyancyCore::IWaterSurface, set one on the buoyancy component to clip against it.
+ * Made as an asset so every boat on the same sea can point at the same one and share its heightfield cache.
+ * The core surface is rebuilt from the properties whenever they change, the buoyancy code only ever reads it.
+ */
+UCLASS(Abstract, BlueprintType)
+class BUOYANCYPHYSICS_API UBuoyancyWaterSurface : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	//Sample the water on a grid shared by all boats in a world instead of evaluating it for every hull vertex.
+	//Pays off with many boats or dense hulls, costs a bit of accuracy between grid points
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Heightfield Cache")
+	bool bUseHeightfieldCache = false;
+
+	//Distance between grid points in cm, keep it well under the shortest wavelength
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Heightfield Cache", meta = (ClampMin = "1.0", EditCondition = "bUseHeightfieldCache"))
+	float CacheCellSize = 50.0f;
+
+	//Grid cells along each side of a cache tile
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Heightfield Cache", meta = (ClampMin = "4", ClampMax = "256", EditCondition = "bUseHeightfieldCache"))
+	int32 CacheTileResolution = 32;
+
+	//Tiles each world keeps before recycling the least recently used one
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Heightfield Cache", meta = (ClampMin = "2", EditCondition = "bUseHeightfieldCache"))
+	int32 CacheMaxTiles = 256;
+
+	//Seconds the sampled times are snapped to, so the substeps and async bodies of a frame share the tiles instead of each
+	//rebuilding them. The water lags or leads by up to half of it, 0 samples every time exactly
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Heightfield Cache", meta = (ClampMin = "0.0", UIMax = "0.1", EditCondition = "bUseHeightfieldCache"))
+	float CacheTimeStep = 1.0f / 60.0f;
+
+	//The surface the clipper queries, nullptr means the plane Z = 0
+	virtual const BuoyancyCore::IWaterSurface* GetCoreSurface() const { return nullptr; }
+
+	//What the boats in World should query, the core surface or the world's shared heightfield cache of it. Game thread only
+	const BuoyancyCore::IWaterSurface* GetSurfaceForWorld(UWorld* World);
+
+	//Water height under a world location, for gameplay code that wants to agree with the buoyancy
+	UFUNCTION(BlueprintPure, Category = "Buoyancy|Water")
+	float GetWaterHeight(const FVector& Location, float Time) const;
+
+	//Call after changing the properties at runtime, waits for the async buoyancy steps that might be reading the surface
+	UFUNCTION(BlueprintCallable, Category = "Buoyancy|Water")
+	void RefreshSurface();
+
+	virtual void PostInitProperties() override;
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+protected:
+	//Copies the properties into the core surface
+	virtual void UpdateCoreSurface() {}
+
+private:
+	//One cache per world, worlds run on their own clocks so they can't share tiles
+	TMap<TWeakObjectPtr<UWorld>, TUniquePtr<BuoyancyCore::FWaterHeightfieldCache>> WorldCaches;
+
+	BuoyancyCore::FWaterHeightfieldCache::FSettings GetCacheSettings() const;
+};
+
+//Still water at a fixed height
+UCLASS(meta = (DisplayName = "Flat Water"))
+class BUOYANCYPHYSICS_API UFlatBuoyancyWaterSurface : public UBuoyancyWaterSurface
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water")
+	float Height = 0.0f;
+
+	virtual const BuoyancyCore::IWaterSurface* GetCoreSurface() const override { return &Surface; }
+
+protected:
+	virtual void UpdateCoreSurface() override;
+
+private:
+	BuoyancyCore::FFlatWaterSurface Surface;
+};
+
+USTRUCT(BlueprintType)
+struct FGerstnerWaveSettings
+{
+	GENERATED_BODY()
+
+	//Direction the wave travels in
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wave")
+	FVector2D Direction = FVector2D(1.0f, 0.0f);
+
+	//Crest to crest distance in cm
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wave", meta = (ClampMin = "1.0"))
+	float Wavelength = 2000.0f;
+
+	//Crest height above the mean level in cm
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wave", meta = (ClampMin = "0.0"))
+	float Amplitude = 50.0f;
+
+	//0 is a plain sine wave, 1 the sharpest crest
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wave", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float Steepness = 0.5f;
+
+	//Phase offset in radians
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wave")
+	float Phase = 0.0f;
+};
+
+//Sum of Gerstner waves, match the settings with the water material so the boat floats on what is drawn
+UCLASS(meta = (DisplayName = "Gerstner Waves"))
+class BUOYANCYPHYSICS_API UGerstnerBuoyancyWaterSurface : public UBuoyancyWaterSurface
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water")
+	float MeanHeight = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water")
+	TArray<FGerstnerWaveSettings> Waves;
+
+	//How many times the sideways motion of the water is undone when looking up a height, more is closer to the rendered surface
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water", meta = (ClampMin = "0", ClampMax = "4"))
+	int32 InversionIterations = 1;
+
+	virtual const BuoyancyCore::IWaterSurface* GetCoreSurface() const override { return &Surface; }
+
+protected:
+	virtual void UpdateCoreSurface() override;
+
+private:
+	BuoyancyCore::FGerstnerWaterSurface Surface;
+};
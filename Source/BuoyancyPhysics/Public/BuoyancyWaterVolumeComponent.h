@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/BoxComponent.h"
+#include "WaterVolumes.h"
+#include "BuoyancyWaterVolumeComponent.generated.h"
+
+class UBuoyancyWaterSurface;
+
+/**
+ * A harbor, river or lake: the box is where its water is, the rest is what floating in it means. Once a world has a single
+ * one of these, buoyancy bodies only float where a volume's box overlaps their bounds and skip their step everywhere else.
+ * A world without any keeps the one implicit sea of the components' own WaterSurface and WaterDensity.
+ * Only the world aligned bounds of the box count, a rotated box covers its whole bounding box.
+ * A body floats in a single volume at a time (see Priority), its whole hull is clipped against that volume's surface even where
+ * it reaches into another. Keep the surfaces of overlapping volumes at about the same level where boats cross between them.
+ */
+UCLASS(ClassGroup = (Physics), meta = (BlueprintSpawnableComponent))
+class BUOYANCYPHYSICS_API UBuoyancyWaterVolumeComponent : public UBoxComponent
+{
+	GENERATED_BODY()
+
+public:
+	UBuoyancyWaterVolumeComponent();
+
+	//Water inside the box, leave empty for still water at Z = 0. Keep the top of the box above the highest crest
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy")
+	UBuoyancyWaterSurface* WaterSurface = nullptr;
+
+	//Same units as the component's WaterDensity, 1 for fresh water
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy", meta = (ClampMin = "0.0"))
+	float WaterDensity = 1.0f;
+
+	//Velocity of the water in cm/s, only the hydrodynamic forces see it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy")
+	FVector CurrentVelocity = FVector::ZeroVector;
+
+	//Where volumes overlap a body floats in the one with the highest priority, then in the one with the smallest area, and only in that one
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyancy")
+	int32 Priority = 0;
+
+	//Call after changing the properties at runtime, moving the component updates it by itself
+	UFUNCTION(BlueprintCallable, Category = "Buoyancy|Water")
+	void RefreshWaterVolume();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+protected:
+	virtual void OnUpdateTransform(EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport) override;
+
+private:
+	//In the manager's registry, -1 while not registered
+	int32 VolumeHandle = -1;
+
+	BuoyancyCore::FWaterVolume MakeCoreVolume();
+};
@@ -5,11 +5,29 @@
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
 #include "Engine/World.h"
+#include "HullClipper.h"
+#include "HullSimplifier.h"
+#include "HullPontoons.h"
+#include "BuoyancyCoreConversions.h"
+#include "BuoyancyStats.h"
+#include "Components/LineBatchComponent.h"
 #include "UnderWaterMeshGenerator.generated.h"
 
 class UStaticMeshComponent;
 class UProceduralMeshComponent;
 
+//Which version of the hull is clipped, the proxies are simplified copies of the collision mesh
+UENUM(BlueprintType)
+enum class EBuoyancyHullLOD : uint8
+{
+	//The collision mesh as it is
+	Full,
+	//Proxy for bodies close to the camera
+	Near,
+	//Coarser proxy for everything further away
+	Far
+};
+
 /**
  * 
  */
@@ -35,82 +53,119 @@ struct FTriangleData
 	float area;
 
 	//normally this would be the construction but unreal doesnt allow it so have to make it a method
-	FTriangleData(FVector Newp1, FVector Newp2, FVector Newp3) {
-		p1 = Newp1;
-		p2 = Newp2;
-		p3 = Newp3;
-
-		//Center of the triangle
-		center = (p1 + p2 + p3) / 3.0f;
-		
-		//float MyTime = GetWorld()->GetTimeSeconds(); 
-
-		//Distance to the surface from the center of the triangle
-		distanceToSurface = FVector::Distance(FVector::ZeroVector, center);
-
-		//Normal to the triangle
-		normal = FVector::CrossProduct(p2 - p3, p1 - p3).GetClampedToSize(-1,1);
-		
-
-		// formula to get angle between two vectors found here https://www.jofre.de/?page_id=1297#item6
-		float angle = FMath::Atan2(FVector::CrossProduct(p2 - p1, p3 - p1).Normalize(), FVector::DotProduct(p2 - p1, p3 - p1));
-
-		//Area of the triangle
-		float a = FVector::Distance(p1, p2);
-		float c = FVector::Distance(p3, p1);	
-		area = (a * c * FMath::Sin(FMath::RadiansToDegrees(angle))) / 2.0f;
+	FTriangleData(FVector Newp1, FVector Newp2, FVector Newp3)
+		: FTriangleData(BuoyancyCore::FUnderWaterTriangle::Make(BuoyancyCore::ToCore(Newp1), BuoyancyCore::ToCore(Newp2), BuoyancyCore::ToCore(Newp3)))
+	{
+	}
+	FTriangleData(const BuoyancyCore::FUnderWaterTriangle& Triangle)
+		: p1(BuoyancyCore::ToUE(Triangle.P1))
+		, p2(BuoyancyCore::ToUE(Triangle.P2))
+		, p3(BuoyancyCore::ToUE(Triangle.P3))
+		, center(BuoyancyCore::ToUE(Triangle.Center))
+		, distanceToSurface(Triangle.DistanceToSurface)
+		, normal(BuoyancyCore::ToUE(Triangle.Normal))
+		, area(Triangle.Area)
+	{
 	}
 	FTriangleData() {}
 };
 
-//Helper struct to store triangle data so we can sort the distances
-USTRUCT(BlueprintType)
-struct FVertexData
-{
-	GENERATED_BODY()
-	//The distance to water from this vertex
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VertexData")
-	float distance;
-	//An index so we can form clockwise triangles
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VertexData")
-	int index;
-	//The global Vector3 position of the vertex
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VertexData")
-	FVector globalVertexPos;
-};
-
 UCLASS()
 class BUOYANCYPHYSICS_API UUnderWaterMeshGenerator : public UObject
 {
 	GENERATED_BODY()
 
 public:
-	UPROPERTY(VisibleAnywhere)
-	TArray<FVector> MeshVerticesGlobal;
 	UPROPERTY(VisibleAnywhere)
 	TArray<FTriangleData> UnderWaterTriangleData;
 
+	//Water the following Generate/Update calls clip against and the time to sample it at, nullptr for the plane Z = 0
+	void SetWaterSurface(const BuoyancyCore::IWaterSurface* Surface, float Time);
+
 	void GenerateUnderWaterMesh();
-	void DisplayMesh(UProceduralMeshComponent* UnderWaterMesh, TArray<FTriangleData> triangleData);
+	//Use the clipper's coherent path in GenerateUnderWaterForces from now on, for bodies that spend most of their time almost at rest
+	void SetCoherence(bool bEnable, const BuoyancyCore::FClipCoherenceSettings& Settings);
+	//Clip in the mesh's own space against a plane fitted to the water from now on, see FHullClipper::GenerateUnderWaterMeshLocal.
+	//Takes precedence over the coherent path, UnderWaterTriangleData is then in component space
+	void SetLocalSpaceWater(bool bEnable) { bLocalSpaceWater = bEnable; }
+
+	//Clips the hull and sums the buoyancy of all under water triangles into OutWrench in the same pass,
+	//UnderWaterTriangleData is only filled in when bBuildTriangleData is set (for the per triangle forces)
+	void GenerateUnderWaterForces(const BuoyancyCore::FBuoyancyParams& Params, bool bBuildTriangleData, BuoyancyCore::FBuoyancyWrench& OutWrench);
+	//Same with the mesh transform passed in, safe to call from the physics thread when bBuildTriangleData is false
+	void GenerateUnderWaterForces(const FTransform& ComponentTransform, const BuoyancyCore::FBuoyancyParams& Params, bool bBuildTriangleData, BuoyancyCore::FBuoyancyWrench& OutWrench);
+	//Reuses which triangles were wet in the last GenerateUnderWaterForces and only updates the depths
+	void UpdateUnderWaterForces(const FTransform& ComponentTransform, const BuoyancyCore::FBuoyancyParams& Params, BuoyancyCore::FBuoyancyWrench& OutWrench);
+	//No clip, the forces of the hull's box against the water plane around it, see FHullClipper::GenerateAnalyticForces.
+	//Leaves no triangles behind
+	void GenerateAnalyticForces(const FTransform& ComponentTransform, const BuoyancyCore::FBuoyancyParams& Params, BuoyancyCore::FBuoyancyWrench& OutWrench);
+	//No clip either, the displaced volume of the hull's pontoons, see BuoyancyCore::FPontoonSolver. Needs SetPontoons, leaves no triangles behind
+	void GeneratePontoonForces(const FTransform& ComponentTransform, const BuoyancyCore::FBuoyancyParams& Params, BuoyancyCore::FBuoyancyWrench& OutWrench);
+	//Fills UnderWaterTriangleData from the last clip
+	void CopyUnderWaterTriangleData();
+	//Drag and slamming part of the wrench of the last clip, see FHullClipper::GetLastHydrodynamicWrench. The pontoons have none
+	const BuoyancyCore::FBuoyancyWrench& GetLastHydrodynamicWrench() const { return GetClipper().GetLastHydrodynamicWrench(); }
+
+	//The clippers and the pontoons size their scratch buffers when their hull is set, UnderWaterTriangleData is reserved by the first
+	//copy on a larger hull. Counts those reserves, a step that didn't make one must leave GetStepBufferSize as it was
+	int32 GetNumBufferSizings() const { return NumBufferSizings; }
+	SIZE_T GetStepBufferSize() const { return GetClipper().GetScratchSize() + PontoonSolver.GetScratchSize() + UnderWaterTriangleData.GetAllocatedSize(); }
+
+	FTransform GetParentMeshTransform() const;
+	//Shows the under water triangles of the last clip in UnderWaterMesh, straight from the clipper. The mesh section and its
+	//buffers are kept between calls and only the vertices are updated, the section is only created again when the triangles outgrow it
+	void DisplayMesh(UProceduralMeshComponent* UnderWaterMesh);
+	//Removes the section and frees its buffers
+	void HideMesh(UProceduralMeshComponent* UnderWaterMesh);
+	//Normal and buoyancy direction of every under water triangle of the last clip as one line batch, kept for LifeTime seconds or this frame with 0
+	void DrawDebugLines(UWorld* World, float LifeTime);
 	void ModifyMesh(UStaticMeshComponent* Comp);
+
+	//Clips LOD's hull from now on, proxies come from FBuoyancyHullRegistry and are shared with every other body of the same mesh.
+	//Every LOD has its own clipper, sized the first time the LOD is used, so going back and forth between them doesn't allocate.
+	//False while the registry is still building the proxy, the current LOD is kept until a later call finds it done.
+	//Game thread only, and not while a step of this generator is being computed
+	bool SetHullLOD(EBuoyancyHullLOD LOD, const BuoyancyCore::FHullSimplifySettings& ProxySettings);
+	EBuoyancyHullLOD GetHullLOD() const { return HullLOD; }
+	//Gets the full hull's pontoons at Settings' resolution from FBuoyancyHullRegistry, or lets go of them. Same threading rules as SetHullLOD
+	void SetPontoons(bool bEnable, const BuoyancyCore::FPontoonSettings& Settings);
 private:
 
 	UPROPERTY(VisibleAnywhere)
 	UStaticMeshComponent* ParentMesh;
 	UPROPERTY(VisibleAnywhere)
 	FTransform MeshTransform;
-	UPROPERTY(VisibleAnywhere)
-	TArray<int> MeshTriangles;
-	UPROPERTY(VisibleAnywhere)
-	TArray<FVector> MeshVertices;
-	UPROPERTY(VisibleAnywhere)
-	TArray<float> AllDistancesToWater;
-
-	void AddTriangles();
-	void AddTrianglesOneAboveWater(TArray<FVertexData> vertexData);
-	void AddTrianglesTwoAboveWater(TArray<FVertexData> vertexData);
 
-	//some relavant info found here https://wiki.unrealengine.com/Accessing_mesh_triangles_and_vertex_positions_in_build
-	bool GetStaticMeshVertexLocationsAndTriangles(UStaticMeshComponent* Comp, TArray<FVector>& GlobalVertexPositions, TArray<FVector>& LocalVertexPositions, TArray<int>& TriangleIndexes);
+	EBuoyancyHullLOD HullLOD = EBuoyancyHullLOD::Full;
+	//Held so the registry keeps the full hull while a proxy is selected
+	std::shared_ptr<const BuoyancyCore::FHullTopology> FullHull;
+
+	bool bCoherent = false;
+	BuoyancyCore::FClipCoherenceSettings CoherenceSettings;
+	bool bLocalSpaceWater = false;
+
+	//Resolution of the pontoons the solver has, 0 for none
+	int32 PontoonResolution = 0;
+	BuoyancyCore::FPontoonSolver PontoonSolver;
+
+	int32 NumBufferSizings = 0;
+
+	//Debug view buffers, reused every DisplayMesh. The section has DebugSectionVertices vertices, the ones past the last triangle are collapsed
+	TArray<FVector> DebugVertices;
+	TArray<FVector> DebugNormals;
+	TArray<int32> DebugIndexes;
+	int32 DebugSectionVertices = 0;
+	TArray<FBatchedLine> DebugLines;
+
+	//Do the actual transform and clipping, see BuoyancyCore. One per LOD so each keeps the buffers and state of its own hull,
+	//only the one of HullLOD is used
+	BuoyancyCore::FHullClipper HullClippers[(int32)EBuoyancyHullLOD::Far + 1];
+	BuoyancyCore::FHullClipper& GetClipper() { return HullClippers[(int32)HullLOD]; }
+	const BuoyancyCore::FHullClipper& GetClipper() const { return HullClippers[(int32)HullLOD]; }
+	//Times the clipper's stages for "stat Buoyancy" and CSV captures
+	FBuoyancyClipProfiler ClipProfiler;
+
+	//Triangle counters of the clip that just ran
+	void RecordClipStats();
 
 };